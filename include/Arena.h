@@ -0,0 +1,154 @@
+/**
+ * @file Arena.h
+ *
+ * @brief Defines the bump allocator used for decoded class trees.
+ **/
+# ifndef __ARENA_H__
+# define __ARENA_H__
+
+# include <stddef.h>
+# include <stdint.h>
+
+namespace JBC {
+
+/**
+ * @class Arena
+ * @brief A bump allocator for objects sharing a single lifetime.
+ *
+ * Memory is carved sequentially out of large chunks, and is only ever
+ * returned all at once, when the arena is reset or destroyed. Objects
+ * placed in an arena must not be used after the arena is released.
+ *
+ * Arenas are not thread safe; each decoding thread should use its own.
+ **/
+class Arena {
+private:
+	struct Chunk {
+		Chunk *next;
+		size_t size;
+	};
+
+	// Most recently allocated chunk first.
+	Chunk *chunks;
+
+	// Free space in the current chunk.
+	uint8_t *cursor;
+	uint8_t *limit;
+
+	size_t chunk_size;
+	size_t allocated;
+
+public:
+	/**
+	 * @brief Creates an empty arena.
+	 *
+	 * No memory is allocated until the first request.
+	 *
+	 * @param chunk_size The preferred size of each chunk, in bytes.
+	 **/
+	Arena(size_t chunk_size = 16384);
+
+	/**
+	 * @brief Releases all memory held by the arena.
+	 **/
+	~Arena();
+
+public:
+	/**
+	 * @brief Allocates a block of memory from the arena.
+	 *
+	 * Blocks are aligned suitably for any fundamental type, and throw
+	 * std::bad_alloc if memory runs out.
+	 *
+	 * @param size The size of the block, in bytes.
+	 * @return A pointer to the new block.
+	 **/
+	inline
+	void *Allocate(size_t size) {
+		uint8_t *block = cursor;
+
+		size = (size + (alignof(max_align_t) - 1)) & ~(alignof(max_align_t) - 1);
+		if(size > (size_t)(limit - cursor)) {
+			return Refill(size);
+		}
+
+		cursor += size;
+		allocated += size;
+		return block;
+	}
+
+	/**
+	 * @brief Releases every block allocated from the arena.
+	 *
+	 * The most recent chunk is kept for reuse.
+	 **/
+	void Reset();
+
+	/**
+	 * @brief Returns the number of bytes handed out since the last reset.
+	 **/
+	inline
+	size_t Allocated() {
+		return allocated;
+	}
+
+public:
+	/**
+	 * @brief Returns the arena selected on the calling thread, or NULL.
+	 **/
+	static
+	Arena *Current();
+
+	/**
+	 * @brief Selects the arena used on the calling thread.
+	 *
+	 * @param arena The arena to select, or NULL for the heap.
+	 * @return The previously selected arena.
+	 **/
+	static
+	Arena *Select(Arena *arena);
+
+private:
+	void *Refill(size_t size);
+};
+
+/**
+ * @class ArenaScope
+ * @brief Selects an arena for the calling thread until destroyed.
+ **/
+class ArenaScope {
+private:
+	Arena *saved;
+
+public:
+	inline
+	ArenaScope(Arena *arena)
+		: saved(Arena::Select(arena)) {
+	}
+
+	inline
+	~ArenaScope() {
+		Arena::Select(saved);
+	}
+};
+
+/**
+ * @struct ArenaObject
+ * @brief A base for types that may be allocated from an arena.
+ *
+ * While an arena is selected on the calling thread, new instances of
+ * derived types are placed in it, and deleting them runs only their
+ * destructors; the memory is reclaimed with the arena. Otherwise they
+ * are allocated from the heap as usual.
+ **/
+struct ArenaObject {
+	static
+	void *operator new(size_t size);
+
+	static
+	void operator delete(void *ptr);
+};
+
+} /* JBC */
+
+# endif /* Arena.h */
@@ -12,6 +12,7 @@
 # include <string>
 # include <vector>
 
+# include "Arena.h"
 # include "ClassBuffer.h"
 # include "ClassBuilder.h"
 # include "ConstantInfo.h"
@@ -21,24 +22,132 @@
 
 namespace JBC {
 
+/* Attribute Kinds */
+
+enum AttributeKind {
+	ATTRIBUTE_UNRESOLVED = 0,
+	ATTRIBUTE_CONSTANT_VALUE,
+	ATTRIBUTE_CODE,
+	ATTRIBUTE_STACK_MAP_TABLE,
+	ATTRIBUTE_EXCEPTIONS,
+	ATTRIBUTE_INNER_CLASSES,
+	ATTRIBUTE_ENCLOSING_METHOD,
+	ATTRIBUTE_SYNTHETIC,
+	ATTRIBUTE_SIGNATURE,
+	ATTRIBUTE_SOURCE_FILE,
+	ATTRIBUTE_SOURCE_DEBUG_EXTENSION,
+	ATTRIBUTE_LINE_NUMBER_TABLE,
+	ATTRIBUTE_LOCAL_VARIABLE_TABLE,
+	ATTRIBUTE_LOCAL_VARIABLE_TYPE_TABLE,
+	ATTRIBUTE_DEPRECATED,
+	ATTRIBUTE_RUNTIME_VISIBLE_ANNOTATIONS,
+	ATTRIBUTE_RUNTIME_INVISIBLE_ANNOTATIONS,
+	ATTRIBUTE_RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS,
+	ATTRIBUTE_RUNTIME_INVISIBLE_PARAMETER_ANNOTATIONS,
+	ATTRIBUTE_ANNOTATION_DEFAULT,
+	ATTRIBUTE_BOOTSTRAP_METHODS,
+	ATTRIBUTE_NONSTANDARD
+};
+
+/**
+ * @brief Identifies the standard attribute type with the given name.
+ *
+ * The result is cached on the name constant, so each name in a constant
+ * pool is only compared against the standard names once.
+ *
+ * @param name The attribute name.
+ * @return The attribute kind, or ATTRIBUTE_NONSTANDARD.
+ **/
+AttributeKind ResolveAttributeKind(ConstantUtf8Info *name);
+
+/**
+ * @brief Returns the bit for an attribute kind in a kind mask.
+ **/
+inline
+uint32_t AttributeMask(AttributeKind kind) {
+	return (uint32_t)1 << kind;
+}
+
 /* Attribute Info */
 
-struct AttributeInfo {
+struct AttributeInfo
+		: public ArenaObject {
 	ConstantUtf8Info *name;
 	uint32_t	attribute_length;
 
+	// Encoded contents in the decoding source, while unmodified.
+	const uint8_t	*source;
+
+	// Whether marked dirty since decoding.
+	bool		modified;
+
 	AttributeInfo()
-		: name(NULL), attribute_length(0) {
+		: name(NULL), attribute_length(0), source(NULL), modified(false) {
 	}
 
 	AttributeInfo(ConstantUtf8Info *name, uint32_t length)
-		: name(name), attribute_length(length) {
+		: name(name), attribute_length(length), source(NULL), modified(false) {
 	}
 
 	virtual
 	~AttributeInfo() {
 	}
 
+	/**
+	 * @brief Checks if this attribute must be encoded field by field.
+	 *
+	 * Attributes decoded from persistent sources with copy_unmodified
+	 * set record their encoded contents, and are encoded by copying
+	 * them until marked dirty.
+	 **/
+	virtual
+	bool IsDirty() {
+		return source == NULL;
+	}
+
+	/**
+	 * @brief Marks this attribute as modified since decoding.
+	 *
+	 * Must be called after changing an attribute decoded with
+	 * copy_unmodified set, or the change is not encoded.
+	 **/
+	inline
+	void MarkDirty() {
+		source = NULL;
+		modified = true;
+	}
+
+	/**
+	 * @brief Checks if this attribute was marked dirty since decoding.
+	 *
+	 * Unlike IsDirty(), this does not depend on whether the contents
+	 * were kept for copy-through.
+	 **/
+	inline
+	bool IsModified() const {
+		return modified;
+	}
+
+	/**
+	 * @brief Computes the exact length of this attribute's contents.
+	 *
+	 * This is the value encoded as attribute_length, and excludes the
+	 * six byte name and length header. Attribute types whose contents
+	 * can change override this; the default reports the decoded length.
+	 **/
+	virtual
+	uint32_t ComputeLength() {
+		return attribute_length;
+	}
+
+	/**
+	 * @brief Computes the exact encoded size of this attribute.
+	 **/
+	inline
+	uint32_t ComputeSize() {
+		return 6 + (IsDirty() ? ComputeLength() : attribute_length);
+	}
+
 	virtual
 	AttributeInfo *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile) = 0;
 
@@ -60,12 +169,18 @@ struct ConstantValueAttribute
 		  constant_value(NULL) {
 	}
 
+	inline
+	uint32_t ComputeLength() {
+		return 2;
+	}
+
 	ConstantValueAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	ConstantValueAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
 };
 
-struct ExceptionTableEntry {
+struct ExceptionTableEntry
+		: public ArenaObject {
 	uint16_t	start_pc;
 	uint16_t	end_pc;
 	uint16_t	handler_pc;
@@ -76,6 +191,11 @@ struct ExceptionTableEntry {
 		  handler_pc(0), catch_type(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 8;
+	}
+
 	ExceptionTableEntry *DecodeEntry(ClassBuffer *buffer);
 
 	ExceptionTableEntry *EncodeEntry(ClassBuilder *builder);
@@ -91,6 +211,12 @@ struct CodeAttribute
 	uint32_t	code_length;
 	uint8_t		*code;
 
+	// Whether code is borrowed from the decoding source, or arena.
+	bool		borrowed;
+
+	// Undecoded contents, while lazily decoded.
+	const uint8_t	*raw;
+
 	// Exception Table
 	std::vector<ExceptionTableEntry *> exception_table;
 
@@ -99,20 +225,49 @@ struct CodeAttribute
 
 	CodeAttribute()
 		: max_stack(0), max_locals(0),
-		  code_length(0), code(NULL) {
+		  code_length(0), code(NULL), borrowed(false), raw(NULL) {
 	}
 
 	CodeAttribute(ConstantUtf8Info *name, uint32_t length)
 		: AttributeInfo(name, length),
 		  max_stack(0), max_locals(0),
-		  code_length(0), code(NULL) {
+		  code_length(0), code(NULL), borrowed(false), raw(NULL) {
 	}
 
 	~CodeAttribute();
 
+	/**
+	 * @brief Checks if the attribute's contents have been decoded.
+	 *
+	 * Code attributes decoded with DecodeOptions::lazy_code only record
+	 * their bytes, and are encoded by copying them back out unchanged.
+	 **/
+	inline
+	bool IsLoaded() {
+		return raw == NULL;
+	}
+
+	/**
+	 * @brief Decodes the attribute's contents, if not yet decoded.
+	 *
+	 * Must be called before reading or modifying a lazily decoded
+	 * attribute. Decoded objects are allocated in the class's arena.
+	 *
+	 * @param classFile The class the attribute was decoded from.
+	 * @return This attribute.
+	 **/
+	CodeAttribute *Load(ClassFile *classFile);
+
+	bool IsDirty();
+
+	uint32_t ComputeLength();
+
 	CodeAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	CodeAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
+
+private:
+	void DecodeContents(ClassBuffer *buffer, ClassFile *classFile);
 };
 
 struct StackMapTableAttribute
@@ -129,6 +284,8 @@ struct StackMapTableAttribute
 
 	~StackMapTableAttribute();
 
+	uint32_t ComputeLength();
+
 	StackMapTableAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	StackMapTableAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -148,6 +305,8 @@ struct ExceptionsAttribute
 
 	~ExceptionsAttribute();
 
+	uint32_t ComputeLength();
+
 	ExceptionsAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	ExceptionsAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -166,7 +325,8 @@ enum InnerClassFlags {
 	INNER_CLASS_ENUM		= 0x4000
 };
 
-struct InnerClassEntry {
+struct InnerClassEntry
+		: public ArenaObject {
 	// Inner Class Info
 	ConstantClassInfo *inner_class_info;
 
@@ -212,6 +372,11 @@ struct InnerClassEntry {
 		else inner_class_access_flags &= ~flag;
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 8;
+	}
+
 	InnerClassEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	InnerClassEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
@@ -231,6 +396,8 @@ struct InnerClassesAttribute
 
 	~InnerClassesAttribute();
 
+	uint32_t ComputeLength();
+
 	InnerClassesAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	InnerClassesAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -253,6 +420,11 @@ struct EnclosingMethodAttribute
 		  enclosing_method(NULL) {
 	}
 
+	inline
+	uint32_t ComputeLength() {
+		return 4;
+	}
+
 	EnclosingMethodAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	EnclosingMethodAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -268,6 +440,11 @@ struct SyntheticAttribute
 		: AttributeInfo(name, length) {
 	}
 
+	inline
+	uint32_t ComputeLength() {
+		return 0;
+	}
+
 	inline
 	SyntheticAttribute *DecodeAttribute(ClassBuffer *, ClassFile *) {
 		return this;
@@ -292,6 +469,11 @@ struct SignatureAttribute
 		: AttributeInfo(name, length), signature(NULL) {
 	}
 
+	inline
+	uint32_t ComputeLength() {
+		return 2;
+	}
+
 	SignatureAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	SignatureAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -310,6 +492,11 @@ struct SourceFileAttribute
 		: AttributeInfo(name, length), source_file(NULL) {
 	}
 
+	inline
+	uint32_t ComputeLength() {
+		return 2;
+	}
+
 	SourceFileAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	SourceFileAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -330,12 +517,18 @@ struct SourceDebugExtensionAttribute
 
 	~SourceDebugExtensionAttribute();
 
+	inline
+	uint32_t ComputeLength() {
+		return attribute_length;
+	}
+
 	SourceDebugExtensionAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	SourceDebugExtensionAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
 };
 
-struct LineNumberTableEntry {
+struct LineNumberTableEntry
+		: public ArenaObject {
 	uint16_t	start_pc;
 	uint16_t	line_number;
 
@@ -343,6 +536,11 @@ struct LineNumberTableEntry {
 		: start_pc(0), line_number(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 4;
+	}
+
 	LineNumberTableEntry *DecodeEntry(ClassBuffer *buffer);
 
 	LineNumberTableEntry *EncodeEntry(ClassBuilder *builder);
@@ -362,12 +560,15 @@ struct LineNumberTableAttribute
 
 	~LineNumberTableAttribute();
 
+	uint32_t ComputeLength();
+
 	LineNumberTableAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	LineNumberTableAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
 };
 
-struct LocalVariableTableEntry {
+struct LocalVariableTableEntry
+		: public ArenaObject {
 	uint16_t	start_pc;
 	uint16_t	length;
 
@@ -384,6 +585,11 @@ struct LocalVariableTableEntry {
 		  descriptor(NULL), index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 10;
+	}
+
 	LocalVariableTableEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	LocalVariableTableEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
@@ -403,12 +609,15 @@ struct LocalVariableTableAttribute
 
 	~LocalVariableTableAttribute();
 
+	uint32_t ComputeLength();
+
 	LocalVariableTableAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	LocalVariableTableAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
 };
 
-struct LocalVariableTypeTableEntry {
+struct LocalVariableTypeTableEntry
+		: public ArenaObject {
 	uint16_t	start_pc;
 	uint16_t	length;
 
@@ -425,6 +634,11 @@ struct LocalVariableTypeTableEntry {
 		  signature(NULL), index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 10;
+	}
+
 	LocalVariableTypeTableEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	LocalVariableTypeTableEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
@@ -444,6 +658,8 @@ struct LocalVariableTypeTableAttribute
 
 	~LocalVariableTypeTableAttribute();
 
+	uint32_t ComputeLength();
+
 	LocalVariableTypeTableAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	LocalVariableTypeTableAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
@@ -459,6 +675,11 @@ struct DeprecatedAttribute
 		: AttributeInfo(name, length) {
 	}
 
+	inline
+	uint32_t ComputeLength() {
+		return 0;
+	}
+
 	inline
 	DeprecatedAttribute *DecodeAttribute(ClassBuffer *, ClassFile *) {
 		return this;
@@ -484,6 +705,8 @@ struct RuntimeAnnotationsAttribute
 
 	~RuntimeAnnotationsAttribute();
 
+	uint32_t ComputeLength();
+
 	RuntimeAnnotationsAttribute *DecodeAttribute(
 			ClassBuffer *buffer, ClassFile *classFile);
 
@@ -513,7 +736,8 @@ struct RuntimeInvisibleAnnotationsAttribute
 	}
 };
 
-struct ParameterAnnotationsEntry {
+struct ParameterAnnotationsEntry
+		: public ArenaObject {
 	// Annotations Table
 	std::vector<AnnotationEntry *> annotations;
 
@@ -522,6 +746,8 @@ struct ParameterAnnotationsEntry {
 
 	~ParameterAnnotationsEntry();
 
+	uint32_t ComputeSize();
+
 	ParameterAnnotationsEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	ParameterAnnotationsEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
@@ -541,6 +767,8 @@ struct RuntimeParameterAnnotationsAttribute
 
 	~RuntimeParameterAnnotationsAttribute();
 
+	uint32_t ComputeLength();
+
 	RuntimeParameterAnnotationsAttribute *DecodeAttribute(
 			ClassBuffer *buffer, ClassFile *classFile);
 
@@ -585,12 +813,15 @@ struct AnnotationDefaultAttribute
 
 	~AnnotationDefaultAttribute();
 
+	uint32_t ComputeLength();
+
 	AnnotationDefaultAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	AnnotationDefaultAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
 };
 
-struct BootstrapMethodEntry {
+struct BootstrapMethodEntry
+		: public ArenaObject {
 	// Bootstrap Method Reference
 	ConstantMethodHandleInfo *bootstrap_method_ref;
 
@@ -603,6 +834,11 @@ struct BootstrapMethodEntry {
 
 	~BootstrapMethodEntry();
 
+	inline
+	uint32_t ComputeSize() {
+		return 4 + 2 * bootstrap_arguments.size();
+	}
+
 	BootstrapMethodEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	BootstrapMethodEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
@@ -622,11 +858,49 @@ struct BootstrapMethodsAttribute
 
 	~BootstrapMethodsAttribute();
 
+	uint32_t ComputeLength();
+
 	BootstrapMethodsAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
 	BootstrapMethodsAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
 };
 
+/**
+ * @struct OpaqueAttribute
+ * @brief An attribute kept as its undecoded contents.
+ *
+ * Used for attributes of unknown types, and for filtered attributes
+ * when requested. Contents are borrowed from persistent decoding sources, and otherwise
+ * copied. They are written back out unchanged when encoding.
+ **/
+struct OpaqueAttribute
+		: public AttributeInfo {
+	// Contents
+	const uint8_t	*bytes;
+
+	// Whether bytes are borrowed from the decoding source, or arena.
+	bool		borrowed;
+
+	OpaqueAttribute()
+		: bytes(NULL), borrowed(false) {
+	}
+
+	OpaqueAttribute(ConstantUtf8Info *name, uint32_t length)
+		: AttributeInfo(name, length), bytes(NULL), borrowed(false) {
+	}
+
+	~OpaqueAttribute();
+
+	inline
+	uint32_t ComputeLength() {
+		return attribute_length;
+	}
+
+	OpaqueAttribute *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
+
+	OpaqueAttribute *EncodeAttribute(ClassBuilder *builder, ClassFile *classFile);
+};
+
 /* Attribute Producers */
 
 typedef AttributeInfo *(* AttributeProducer)(
@@ -638,8 +912,12 @@ void RegisterProducer(std::string name, AttributeProducer producer);
 
 AttributeInfo *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile);
 
+void SkipAttributes(ClassBuffer *buffer);
+
 int EncodeAttribute(ClassBuilder *builder, ClassFile *classFile, AttributeInfo *info);
 
+uint32_t ComputeAttributesSize(const std::vector<AttributeInfo *> &attributes);
+
 } /* JBC */
 
 # endif /* AttributeInfo.h */
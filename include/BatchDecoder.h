@@ -0,0 +1,165 @@
+/**
+ * @file BatchDecoder.h
+ *
+ * @brief Defines decoding of many class files in parallel.
+ **/
+# ifndef __BATCHDECODER_H__
+# define __BATCHDECODER_H__
+
+# include <string>
+# include <vector>
+# include <stddef.h>
+# include <stdint.h>
+
+# include "ClassFile.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class Arena;
+class JarFile;
+struct JarEntry;
+
+/**
+ * @struct ClassSource
+ * @brief The bytes of a class file in memory.
+ **/
+struct ClassSource {
+	const uint8_t *data;
+	size_t		size;
+};
+
+/**
+ * @class ClassBatch
+ * @brief The classes decoded by DecodeClassFiles(), in input order.
+ *
+ * Classes are placed in arenas shared by the classes each worker
+ * decoded, so they are owned by the batch, and released with it.
+ *
+ * Since arenas are not thread safe, classes sharing one, as given by
+ * their arena member, must only be used by one thread at a time once
+ * decoded. Loading lazy code, adding constants, rewriting code and
+ * encoding with computed values all allocate from the arena. Classes
+ * from different arenas may be processed in parallel.
+ **/
+class ClassBatch {
+private:
+	// One per worker.
+	std::vector<Arena *> arenas;
+
+	// NULL where decoding failed.
+	std::vector<ClassFile *> classes;
+	std::vector<std::string> errors;
+
+	// Paths or entry names, where known.
+	std::vector<std::string> names;
+
+public:
+	ClassBatch(size_t count, unsigned workers);
+	~ClassBatch();
+
+private:
+	ClassBatch(const ClassBatch &);
+	ClassBatch &operator=(const ClassBatch &);
+
+public:
+	/**
+	 * @brief Returns the number of inputs in the batch.
+	 **/
+	inline
+	size_t Size() const {
+		return classes.size();
+	}
+
+	/**
+	 * @brief Returns the class decoded from an input, or NULL on failure.
+	 **/
+	inline
+	ClassFile *Get(size_t idx) const {
+		return classes[idx];
+	}
+
+	/**
+	 * @brief Returns the path or entry name of an input, or an empty string.
+	 **/
+	inline
+	const std::string &Name(size_t idx) const {
+		return names[idx];
+	}
+
+	/**
+	 * @brief Returns why an input failed to decode, or an empty string.
+	 **/
+	inline
+	const std::string &Error(size_t idx) const {
+		return errors[idx];
+	}
+
+	/**
+	 * @brief Returns the number of inputs that failed to decode.
+	 **/
+	size_t Failures() const;
+
+private:
+	friend class BatchWorker;
+};
+
+/**
+ * @brief Decodes a list of class files in parallel.
+ *
+ * The inputs are split evenly between the workers, and a worker that
+ * runs out takes half of the remaining inputs of another, so uneven
+ * class sizes still keep every core busy. Each worker reads files into
+ * its own reusable buffer, and decodes into its own arena, so workers
+ * share no state; see ClassBatch for using the classes across threads.
+ * A file that fails to open or decode records an error in its place,
+ * without affecting the rest of the batch.
+ *
+ * @param paths The paths of the class files.
+ * @param threads The number of workers; 0 for one per core.
+ * @param options The settings to decode with. The arena is ignored.
+ * @return The decoded classes, in the order of the paths.
+ **/
+ClassBatch *DecodeClassFiles(const std::vector<std::string> &paths,
+		unsigned threads = 0, const DecodeOptions &options = DecodeOptions());
+
+/**
+ * @brief Decodes a list of class files in memory in parallel.
+ *
+ * Like DecodeClassFiles() over paths. The bytes are copied, and need
+ * not outlive the call.
+ *
+ * @param sources The class file data.
+ * @param threads The number of workers; 0 for one per core.
+ * @param options The settings to decode with. The arena is ignored.
+ * @return The decoded classes, in the order of the sources.
+ **/
+ClassBatch *DecodeClassFiles(const std::vector<ClassSource> &sources,
+		unsigned threads = 0, const DecodeOptions &options = DecodeOptions());
+
+/**
+ * @brief Decodes entries of a jar in parallel.
+ *
+ * Like DecodeClassFiles() over paths, with entries read out of the
+ * mapped archive into per-worker buffers.
+ *
+ * @param jar The archive the entries belong to.
+ * @param entries The entries to decode.
+ * @param threads The number of workers; 0 for one per core.
+ * @param options The settings to decode with. The arena is ignored.
+ * @return The decoded classes, in the order of the entries.
+ **/
+ClassBatch *DecodeClassFiles(JarFile *jar, const std::vector<const JarEntry *> &entries,
+		unsigned threads = 0, const DecodeOptions &options = DecodeOptions());
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* BatchDecoder.h */
@@ -0,0 +1,698 @@
+/**
+ * @file Bytecode.h
+ *
+ * @brief Defines opcode metadata and bytecode instruction iteration.
+ **/
+# ifndef __BYTECODE_H__
+# define __BYTECODE_H__
+
+# include <stddef.h>
+# include <stdint.h>
+
+# include "ConstantInfo.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassFile;
+struct CodeAttribute;
+
+/* Opcodes */
+
+/**
+ * @enum Opcode
+ * @brief The JVM instruction set.
+ **/
+enum Opcode {
+	OP_NOP					= 0x00,
+	OP_ACONST_NULL			= 0x01,
+	OP_ICONST_M1			= 0x02,
+	OP_ICONST_0				= 0x03,
+	OP_ICONST_1				= 0x04,
+	OP_ICONST_2				= 0x05,
+	OP_ICONST_3				= 0x06,
+	OP_ICONST_4				= 0x07,
+	OP_ICONST_5				= 0x08,
+	OP_LCONST_0				= 0x09,
+	OP_LCONST_1				= 0x0A,
+	OP_FCONST_0				= 0x0B,
+	OP_FCONST_1				= 0x0C,
+	OP_FCONST_2				= 0x0D,
+	OP_DCONST_0				= 0x0E,
+	OP_DCONST_1				= 0x0F,
+	OP_BIPUSH				= 0x10,
+	OP_SIPUSH				= 0x11,
+	OP_LDC					= 0x12,
+	OP_LDC_W				= 0x13,
+	OP_LDC2_W				= 0x14,
+	OP_ILOAD				= 0x15,
+	OP_LLOAD				= 0x16,
+	OP_FLOAD				= 0x17,
+	OP_DLOAD				= 0x18,
+	OP_ALOAD				= 0x19,
+	OP_ILOAD_0				= 0x1A,
+	OP_ILOAD_1				= 0x1B,
+	OP_ILOAD_2				= 0x1C,
+	OP_ILOAD_3				= 0x1D,
+	OP_LLOAD_0				= 0x1E,
+	OP_LLOAD_1				= 0x1F,
+	OP_LLOAD_2				= 0x20,
+	OP_LLOAD_3				= 0x21,
+	OP_FLOAD_0				= 0x22,
+	OP_FLOAD_1				= 0x23,
+	OP_FLOAD_2				= 0x24,
+	OP_FLOAD_3				= 0x25,
+	OP_DLOAD_0				= 0x26,
+	OP_DLOAD_1				= 0x27,
+	OP_DLOAD_2				= 0x28,
+	OP_DLOAD_3				= 0x29,
+	OP_ALOAD_0				= 0x2A,
+	OP_ALOAD_1				= 0x2B,
+	OP_ALOAD_2				= 0x2C,
+	OP_ALOAD_3				= 0x2D,
+	OP_IALOAD				= 0x2E,
+	OP_LALOAD				= 0x2F,
+	OP_FALOAD				= 0x30,
+	OP_DALOAD				= 0x31,
+	OP_AALOAD				= 0x32,
+	OP_BALOAD				= 0x33,
+	OP_CALOAD				= 0x34,
+	OP_SALOAD				= 0x35,
+	OP_ISTORE				= 0x36,
+	OP_LSTORE				= 0x37,
+	OP_FSTORE				= 0x38,
+	OP_DSTORE				= 0x39,
+	OP_ASTORE				= 0x3A,
+	OP_ISTORE_0				= 0x3B,
+	OP_ISTORE_1				= 0x3C,
+	OP_ISTORE_2				= 0x3D,
+	OP_ISTORE_3				= 0x3E,
+	OP_LSTORE_0				= 0x3F,
+	OP_LSTORE_1				= 0x40,
+	OP_LSTORE_2				= 0x41,
+	OP_LSTORE_3				= 0x42,
+	OP_FSTORE_0				= 0x43,
+	OP_FSTORE_1				= 0x44,
+	OP_FSTORE_2				= 0x45,
+	OP_FSTORE_3				= 0x46,
+	OP_DSTORE_0				= 0x47,
+	OP_DSTORE_1				= 0x48,
+	OP_DSTORE_2				= 0x49,
+	OP_DSTORE_3				= 0x4A,
+	OP_ASTORE_0				= 0x4B,
+	OP_ASTORE_1				= 0x4C,
+	OP_ASTORE_2				= 0x4D,
+	OP_ASTORE_3				= 0x4E,
+	OP_IASTORE				= 0x4F,
+	OP_LASTORE				= 0x50,
+	OP_FASTORE				= 0x51,
+	OP_DASTORE				= 0x52,
+	OP_AASTORE				= 0x53,
+	OP_BASTORE				= 0x54,
+	OP_CASTORE				= 0x55,
+	OP_SASTORE				= 0x56,
+	OP_POP					= 0x57,
+	OP_POP2					= 0x58,
+	OP_DUP					= 0x59,
+	OP_DUP_X1				= 0x5A,
+	OP_DUP_X2				= 0x5B,
+	OP_DUP2					= 0x5C,
+	OP_DUP2_X1				= 0x5D,
+	OP_DUP2_X2				= 0x5E,
+	OP_SWAP					= 0x5F,
+	OP_IADD					= 0x60,
+	OP_LADD					= 0x61,
+	OP_FADD					= 0x62,
+	OP_DADD					= 0x63,
+	OP_ISUB					= 0x64,
+	OP_LSUB					= 0x65,
+	OP_FSUB					= 0x66,
+	OP_DSUB					= 0x67,
+	OP_IMUL					= 0x68,
+	OP_LMUL					= 0x69,
+	OP_FMUL					= 0x6A,
+	OP_DMUL					= 0x6B,
+	OP_IDIV					= 0x6C,
+	OP_LDIV					= 0x6D,
+	OP_FDIV					= 0x6E,
+	OP_DDIV					= 0x6F,
+	OP_IREM					= 0x70,
+	OP_LREM					= 0x71,
+	OP_FREM					= 0x72,
+	OP_DREM					= 0x73,
+	OP_INEG					= 0x74,
+	OP_LNEG					= 0x75,
+	OP_FNEG					= 0x76,
+	OP_DNEG					= 0x77,
+	OP_ISHL					= 0x78,
+	OP_LSHL					= 0x79,
+	OP_ISHR					= 0x7A,
+	OP_LSHR					= 0x7B,
+	OP_IUSHR				= 0x7C,
+	OP_LUSHR				= 0x7D,
+	OP_IAND					= 0x7E,
+	OP_LAND					= 0x7F,
+	OP_IOR					= 0x80,
+	OP_LOR					= 0x81,
+	OP_IXOR					= 0x82,
+	OP_LXOR					= 0x83,
+	OP_IINC					= 0x84,
+	OP_I2L					= 0x85,
+	OP_I2F					= 0x86,
+	OP_I2D					= 0x87,
+	OP_L2I					= 0x88,
+	OP_L2F					= 0x89,
+	OP_L2D					= 0x8A,
+	OP_F2I					= 0x8B,
+	OP_F2L					= 0x8C,
+	OP_F2D					= 0x8D,
+	OP_D2I					= 0x8E,
+	OP_D2L					= 0x8F,
+	OP_D2F					= 0x90,
+	OP_I2B					= 0x91,
+	OP_I2C					= 0x92,
+	OP_I2S					= 0x93,
+	OP_LCMP					= 0x94,
+	OP_FCMPL				= 0x95,
+	OP_FCMPG				= 0x96,
+	OP_DCMPL				= 0x97,
+	OP_DCMPG				= 0x98,
+	OP_IFEQ					= 0x99,
+	OP_IFNE					= 0x9A,
+	OP_IFLT					= 0x9B,
+	OP_IFGE					= 0x9C,
+	OP_IFGT					= 0x9D,
+	OP_IFLE					= 0x9E,
+	OP_IF_ICMPEQ			= 0x9F,
+	OP_IF_ICMPNE			= 0xA0,
+	OP_IF_ICMPLT			= 0xA1,
+	OP_IF_ICMPGE			= 0xA2,
+	OP_IF_ICMPGT			= 0xA3,
+	OP_IF_ICMPLE			= 0xA4,
+	OP_IF_ACMPEQ			= 0xA5,
+	OP_IF_ACMPNE			= 0xA6,
+	OP_GOTO					= 0xA7,
+	OP_JSR					= 0xA8,
+	OP_RET					= 0xA9,
+	OP_TABLESWITCH			= 0xAA,
+	OP_LOOKUPSWITCH			= 0xAB,
+	OP_IRETURN				= 0xAC,
+	OP_LRETURN				= 0xAD,
+	OP_FRETURN				= 0xAE,
+	OP_DRETURN				= 0xAF,
+	OP_ARETURN				= 0xB0,
+	OP_RETURN				= 0xB1,
+	OP_GETSTATIC			= 0xB2,
+	OP_PUTSTATIC			= 0xB3,
+	OP_GETFIELD				= 0xB4,
+	OP_PUTFIELD				= 0xB5,
+	OP_INVOKEVIRTUAL		= 0xB6,
+	OP_INVOKESPECIAL		= 0xB7,
+	OP_INVOKESTATIC			= 0xB8,
+	OP_INVOKEINTERFACE		= 0xB9,
+	OP_INVOKEDYNAMIC		= 0xBA,
+	OP_NEW					= 0xBB,
+	OP_NEWARRAY				= 0xBC,
+	OP_ANEWARRAY			= 0xBD,
+	OP_ARRAYLENGTH			= 0xBE,
+	OP_ATHROW				= 0xBF,
+	OP_CHECKCAST			= 0xC0,
+	OP_INSTANCEOF			= 0xC1,
+	OP_MONITORENTER			= 0xC2,
+	OP_MONITOREXIT			= 0xC3,
+	OP_WIDE					= 0xC4,
+	OP_MULTIANEWARRAY		= 0xC5,
+	OP_IFNULL				= 0xC6,
+	OP_IFNONNULL			= 0xC7,
+	OP_GOTO_W				= 0xC8,
+	OP_JSR_W				= 0xC9
+};
+
+/**
+ * @enum OperandFormat
+ * @brief The layout of an instruction's operands.
+ **/
+enum OperandFormat {
+	FORMAT_NONE,			/**< No operands.											*/
+	FORMAT_BYTE,			/**< A signed byte immediate.								*/
+	FORMAT_SHORT,			/**< A signed short immediate.								*/
+	FORMAT_LOCAL,			/**< A local variable index; widened by wide.				*/
+	FORMAT_CONSTANT1,		/**< A one byte constant pool index.						*/
+	FORMAT_CONSTANT2,		/**< A two byte constant pool index.						*/
+	FORMAT_IINC,			/**< A local variable index and increment.					*/
+	FORMAT_BRANCH2,			/**< A two byte branch offset.								*/
+	FORMAT_BRANCH4,			/**< A four byte branch offset.								*/
+	FORMAT_TABLESWITCH,		/**< A padded jump table, indexed by key.					*/
+	FORMAT_LOOKUPSWITCH,	/**< A padded jump table of sorted key and offset pairs.	*/
+	FORMAT_INVOKEINTERFACE,	/**< A constant index, argument count and zero byte.		*/
+	FORMAT_INVOKEDYNAMIC,	/**< A constant index and two zero bytes.					*/
+	FORMAT_NEWARRAY,		/**< A primitive array type.								*/
+	FORMAT_MULTIANEWARRAY,	/**< A constant index and array dimensions.					*/
+	FORMAT_WIDE,			/**< Widens the operands of the following instruction.		*/
+	FORMAT_INVALID			/**< Not a valid opcode.									*/
+};
+
+/**
+ * @enum ControlFlow
+ * @brief How control leaves an instruction.
+ **/
+enum ControlFlow {
+	FLOW_NEXT,				/**< Falls through to the next instruction.					*/
+	FLOW_BRANCH,			/**< Branches to a target, or falls through.				*/
+	FLOW_GOTO,				/**< Unconditionally branches to a target.					*/
+	FLOW_JSR,				/**< Calls a subroutine, returning to the next instruction.	*/
+	FLOW_RET,				/**< Returns from a subroutine.								*/
+	FLOW_SWITCH,			/**< Branches to one of a table of targets.					*/
+	FLOW_RETURN,			/**< Returns from the method.								*/
+	FLOW_THROW				/**< Throws an exception.									*/
+};
+
+/**
+ * @struct OpcodeInfo
+ * @brief Static properties of an opcode.
+ *
+ * Stack effects are counted in slots, with long and double values taking
+ * two. Effects that depend on a descriptor or operand are given as -1.
+ **/
+struct OpcodeInfo {
+	// Mnemonic, or NULL for invalid opcodes.
+	const char	*name;
+
+	uint8_t		format;
+	uint8_t		flow;
+
+	// Encoded length, or 0 if variable.
+	uint8_t		length;
+
+	// Stack slots consumed and produced.
+	int8_t		pops;
+	int8_t		pushes;
+};
+
+/**
+ * @brief Opcode properties, indexed by opcode.
+ **/
+inline constexpr
+OpcodeInfo opcode_table[256] = {
+	{ "nop", FORMAT_NONE, FLOW_NEXT, 1, 0, 0 },
+	{ "aconst_null", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_m1", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_3", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_4", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iconst_5", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "lconst_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "lconst_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "fconst_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "fconst_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "fconst_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "dconst_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "dconst_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "bipush", FORMAT_BYTE, FLOW_NEXT, 2, 0, 1 },
+	{ "sipush", FORMAT_SHORT, FLOW_NEXT, 3, 0, 1 },
+	{ "ldc", FORMAT_CONSTANT1, FLOW_NEXT, 2, 0, 1 },
+	{ "ldc_w", FORMAT_CONSTANT2, FLOW_NEXT, 3, 0, 1 },
+	{ "ldc2_w", FORMAT_CONSTANT2, FLOW_NEXT, 3, 0, 2 },
+	{ "iload", FORMAT_LOCAL, FLOW_NEXT, 2, 0, 1 },
+	{ "lload", FORMAT_LOCAL, FLOW_NEXT, 2, 0, 2 },
+	{ "fload", FORMAT_LOCAL, FLOW_NEXT, 2, 0, 1 },
+	{ "dload", FORMAT_LOCAL, FLOW_NEXT, 2, 0, 2 },
+	{ "aload", FORMAT_LOCAL, FLOW_NEXT, 2, 0, 1 },
+	{ "iload_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iload_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iload_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iload_3", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "lload_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "lload_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "lload_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "lload_3", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "fload_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "fload_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "fload_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "fload_3", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "dload_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "dload_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "dload_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "dload_3", FORMAT_NONE, FLOW_NEXT, 1, 0, 2 },
+	{ "aload_0", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "aload_1", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "aload_2", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "aload_3", FORMAT_NONE, FLOW_NEXT, 1, 0, 1 },
+	{ "iaload", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "laload", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "faload", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "daload", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "aaload", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "baload", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "caload", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "saload", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "istore", FORMAT_LOCAL, FLOW_NEXT, 2, 1, 0 },
+	{ "lstore", FORMAT_LOCAL, FLOW_NEXT, 2, 2, 0 },
+	{ "fstore", FORMAT_LOCAL, FLOW_NEXT, 2, 1, 0 },
+	{ "dstore", FORMAT_LOCAL, FLOW_NEXT, 2, 2, 0 },
+	{ "astore", FORMAT_LOCAL, FLOW_NEXT, 2, 1, 0 },
+	{ "istore_0", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "istore_1", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "istore_2", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "istore_3", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "lstore_0", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "lstore_1", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "lstore_2", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "lstore_3", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "fstore_0", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "fstore_1", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "fstore_2", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "fstore_3", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "dstore_0", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "dstore_1", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "dstore_2", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "dstore_3", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "astore_0", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "astore_1", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "astore_2", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "astore_3", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "iastore", FORMAT_NONE, FLOW_NEXT, 1, 3, 0 },
+	{ "lastore", FORMAT_NONE, FLOW_NEXT, 1, 4, 0 },
+	{ "fastore", FORMAT_NONE, FLOW_NEXT, 1, 3, 0 },
+	{ "dastore", FORMAT_NONE, FLOW_NEXT, 1, 4, 0 },
+	{ "aastore", FORMAT_NONE, FLOW_NEXT, 1, 3, 0 },
+	{ "bastore", FORMAT_NONE, FLOW_NEXT, 1, 3, 0 },
+	{ "castore", FORMAT_NONE, FLOW_NEXT, 1, 3, 0 },
+	{ "sastore", FORMAT_NONE, FLOW_NEXT, 1, 3, 0 },
+	{ "pop", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "pop2", FORMAT_NONE, FLOW_NEXT, 1, 2, 0 },
+	{ "dup", FORMAT_NONE, FLOW_NEXT, 1, 1, 2 },
+	{ "dup_x1", FORMAT_NONE, FLOW_NEXT, 1, 2, 3 },
+	{ "dup_x2", FORMAT_NONE, FLOW_NEXT, 1, 3, 4 },
+	{ "dup2", FORMAT_NONE, FLOW_NEXT, 1, 2, 4 },
+	{ "dup2_x1", FORMAT_NONE, FLOW_NEXT, 1, 3, 5 },
+	{ "dup2_x2", FORMAT_NONE, FLOW_NEXT, 1, 4, 6 },
+	{ "swap", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "iadd", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "ladd", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "fadd", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "dadd", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "isub", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lsub", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "fsub", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "dsub", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "imul", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lmul", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "fmul", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "dmul", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "idiv", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "ldiv", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "fdiv", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "ddiv", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "irem", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lrem", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "frem", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "drem", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "ineg", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "lneg", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "fneg", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "dneg", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "ishl", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lshl", FORMAT_NONE, FLOW_NEXT, 1, 3, 2 },
+	{ "ishr", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lshr", FORMAT_NONE, FLOW_NEXT, 1, 3, 2 },
+	{ "iushr", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lushr", FORMAT_NONE, FLOW_NEXT, 1, 3, 2 },
+	{ "iand", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "land", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "ior", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lor", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "ixor", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "lxor", FORMAT_NONE, FLOW_NEXT, 1, 4, 2 },
+	{ "iinc", FORMAT_IINC, FLOW_NEXT, 3, 0, 0 },
+	{ "i2l", FORMAT_NONE, FLOW_NEXT, 1, 1, 2 },
+	{ "i2f", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "i2d", FORMAT_NONE, FLOW_NEXT, 1, 1, 2 },
+	{ "l2i", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "l2f", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "l2d", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "f2i", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "f2l", FORMAT_NONE, FLOW_NEXT, 1, 1, 2 },
+	{ "f2d", FORMAT_NONE, FLOW_NEXT, 1, 1, 2 },
+	{ "d2i", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "d2l", FORMAT_NONE, FLOW_NEXT, 1, 2, 2 },
+	{ "d2f", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "i2b", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "i2c", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "i2s", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "lcmp", FORMAT_NONE, FLOW_NEXT, 1, 4, 1 },
+	{ "fcmpl", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "fcmpg", FORMAT_NONE, FLOW_NEXT, 1, 2, 1 },
+	{ "dcmpl", FORMAT_NONE, FLOW_NEXT, 1, 4, 1 },
+	{ "dcmpg", FORMAT_NONE, FLOW_NEXT, 1, 4, 1 },
+	{ "ifeq", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "ifne", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "iflt", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "ifge", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "ifgt", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "ifle", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "if_icmpeq", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_icmpne", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_icmplt", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_icmpge", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_icmpgt", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_icmple", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_acmpeq", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "if_acmpne", FORMAT_BRANCH2, FLOW_BRANCH, 3, 2, 0 },
+	{ "goto", FORMAT_BRANCH2, FLOW_GOTO, 3, 0, 0 },
+	{ "jsr", FORMAT_BRANCH2, FLOW_JSR, 3, 0, 1 },
+	{ "ret", FORMAT_LOCAL, FLOW_RET, 2, 0, 0 },
+	{ "tableswitch", FORMAT_TABLESWITCH, FLOW_SWITCH, 0, 1, 0 },
+	{ "lookupswitch", FORMAT_LOOKUPSWITCH, FLOW_SWITCH, 0, 1, 0 },
+	{ "ireturn", FORMAT_NONE, FLOW_RETURN, 1, 1, 0 },
+	{ "lreturn", FORMAT_NONE, FLOW_RETURN, 1, 2, 0 },
+	{ "freturn", FORMAT_NONE, FLOW_RETURN, 1, 1, 0 },
+	{ "dreturn", FORMAT_NONE, FLOW_RETURN, 1, 2, 0 },
+	{ "areturn", FORMAT_NONE, FLOW_RETURN, 1, 1, 0 },
+	{ "return", FORMAT_NONE, FLOW_RETURN, 1, 0, 0 },
+	{ "getstatic", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "putstatic", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "getfield", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "putfield", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "invokevirtual", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "invokespecial", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "invokestatic", FORMAT_CONSTANT2, FLOW_NEXT, 3, -1, -1 },
+	{ "invokeinterface", FORMAT_INVOKEINTERFACE, FLOW_NEXT, 5, -1, -1 },
+	{ "invokedynamic", FORMAT_INVOKEDYNAMIC, FLOW_NEXT, 5, -1, -1 },
+	{ "new", FORMAT_CONSTANT2, FLOW_NEXT, 3, 0, 1 },
+	{ "newarray", FORMAT_NEWARRAY, FLOW_NEXT, 2, 1, 1 },
+	{ "anewarray", FORMAT_CONSTANT2, FLOW_NEXT, 3, 1, 1 },
+	{ "arraylength", FORMAT_NONE, FLOW_NEXT, 1, 1, 1 },
+	{ "athrow", FORMAT_NONE, FLOW_THROW, 1, 1, 0 },
+	{ "checkcast", FORMAT_CONSTANT2, FLOW_NEXT, 3, 1, 1 },
+	{ "instanceof", FORMAT_CONSTANT2, FLOW_NEXT, 3, 1, 1 },
+	{ "monitorenter", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "monitorexit", FORMAT_NONE, FLOW_NEXT, 1, 1, 0 },
+	{ "wide", FORMAT_WIDE, FLOW_NEXT, 0, 0, 0 },
+	{ "multianewarray", FORMAT_MULTIANEWARRAY, FLOW_NEXT, 4, -1, 1 },
+	{ "ifnull", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "ifnonnull", FORMAT_BRANCH2, FLOW_BRANCH, 3, 1, 0 },
+	{ "goto_w", FORMAT_BRANCH4, FLOW_GOTO, 5, 0, 0 },
+	{ "jsr_w", FORMAT_BRANCH4, FLOW_JSR, 5, 0, 1 },
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xCA
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xCB
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xCC
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xCD
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xCE
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xCF
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD0
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD1
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD2
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD3
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD4
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD5
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD6
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD7
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD8
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xD9
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xDA
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xDB
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xDC
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xDD
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xDE
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xDF
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE0
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE1
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE2
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE3
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE4
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE5
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE6
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE7
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE8
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xE9
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xEA
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xEB
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xEC
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xED
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xEE
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xEF
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF0
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF1
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF2
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF3
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF4
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF5
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF6
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF7
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF8
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xF9
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xFA
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xFB
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xFC
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xFD
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xFE
+	{ NULL, FORMAT_INVALID, FLOW_NEXT, 0, 0, 0 },	// 0xFF
+};
+
+/* Instructions */
+
+/**
+ * @struct Instruction
+ * @brief A single decoded instruction.
+ *
+ * Switch tables are not copied; their cases are read from the code the
+ * instruction was decoded from, which must outlive it.
+ **/
+struct Instruction {
+	uint32_t	pc;
+	uint32_t	length;
+	uint8_t		opcode;
+
+	// Whether prefixed by wide.
+	bool		wide;
+
+	// Local variable or constant pool index.
+	uint16_t	index;
+
+	// Immediate operand; the constant for pushes, the increment for
+	// iinc, the type for newarray, the dimensions for multianewarray,
+	// and the argument count for invokeinterface.
+	int32_t		value;
+
+	// Branch target, or default target for switches.
+	uint32_t	target;
+
+	// The referenced constant, if resolved.
+	ConstantInfo *constant;
+
+	// Switch Tables
+	int32_t		low;
+	uint32_t	count;
+	const uint8_t *table;
+
+	/**
+	 * @brief Returns the static properties of this instruction.
+	 **/
+	inline
+	const OpcodeInfo &Info() const {
+		return opcode_table[opcode];
+	}
+
+	/**
+	 * @brief Returns the key of a switch case.
+	 *
+	 * @param idx The case number, less than count.
+	 **/
+	int32_t CaseKey(uint32_t idx) const;
+
+	/**
+	 * @brief Returns the target of a switch case.
+	 *
+	 * @param idx The case number, less than count.
+	 **/
+	uint32_t CaseTarget(uint32_t idx) const;
+};
+
+/**
+ * @class InstructionIterator
+ * @brief Decodes the instructions of a method in order.
+ *
+ * Decoding is table driven and never allocates. Malformed code, such as
+ * truncated instructions, invalid opcodes or out of range branches,
+ * raises a DecodeError.
+ *
+ * @code
+ * Instruction insn;
+ * InstructionIterator itr(code, classFile);
+ * while(itr.Next(insn)) {
+ *     ...
+ * }
+ * @endcode
+ **/
+class InstructionIterator {
+private:
+	const uint8_t *code;
+	uint32_t	length;
+	uint32_t	pc;
+
+	// For resolving constants; may be NULL.
+	ClassFile	*classFile;
+
+public:
+	/**
+	 * @brief Constructs an iterator over raw bytecode.
+	 *
+	 * @param code The bytecode to decode.
+	 * @param length The length of the bytecode.
+	 * @param classFile The class to resolve constants against, or NULL.
+	 **/
+	InstructionIterator(const uint8_t *code, uint32_t length,
+			ClassFile *classFile = NULL);
+
+	/**
+	 * @brief Constructs an iterator over a method's code.
+	 *
+	 * Lazily decoded attributes are loaded if a class is given.
+	 *
+	 * @param code The Code attribute to decode.
+	 * @param classFile The class to resolve constants against, or NULL.
+	 **/
+	InstructionIterator(CodeAttribute *code, ClassFile *classFile = NULL);
+
+public:
+	/**
+	 * @brief Returns the offset of the next instruction.
+	 **/
+	inline
+	uint32_t Position() {
+		return pc;
+	}
+
+	/**
+	 * @brief Continues decoding from an instruction boundary.
+	 *
+	 * @param offset The offset of the next instruction to decode.
+	 **/
+	inline
+	void Seek(uint32_t offset) {
+		pc = offset;
+	}
+
+	/**
+	 * @brief Decodes the next instruction.
+	 *
+	 * @param insn The instruction to decode into.
+	 * @return False at the end of the code.
+	 **/
+	bool Next(Instruction &insn);
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* Bytecode.h */
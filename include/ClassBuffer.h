@@ -1,3 +1,4 @@
+
 # ifndef __CLASSBUFFER_H__
 # define __CLASSBUFFER_H__
 
@@ -16,13 +17,52 @@ struct BufferError
 	}
 };
 
+/**
+ * @class ClassBuffer
+ * @brief A read cursor over the bytes of a class file.
+ *
+ * The buffer always decodes from a contiguous span of memory; values
+ * are read with plain loads and a bounds check, without going through
+ * stdio. When constructed from a FILE, the file is read into memory
+ * in full and closed before decoding begins.
+ **/
 class ClassBuffer {
 private:
-	FILE *input;
+	const uint8_t *data;
+	size_t size;
+	size_t position;
+
+	// Backing storage, if owned by the buffer.
+	uint8_t *storage;
 	unsigned reads;
 
+	// Whether the data outlives decoded objects.
+	bool persistent;
+
 public:
+	/**
+	 * @brief Creates a buffer from the contents of a file.
+	 *
+	 * The file is read in full and closed, even if reading fails.
+	 *
+	 * @param input The file to read from.
+	 **/
 	ClassBuffer(FILE *input);
+
+	/**
+	 * @brief Creates a buffer over a span of memory.
+	 *
+	 * The bytes are not copied, and must remain valid for the
+	 * lifetime of the buffer. If the buffer is persistent, the bytes
+	 * must also outlive any objects decoded from it, which may then
+	 * reference them directly rather than holding a copy.
+	 *
+	 * @param data The start of the class data.
+	 * @param size The length of the class data, in bytes.
+	 * @param persistent Whether decoded objects may borrow the data.
+	 **/
+	ClassBuffer(const uint8_t *data, size_t size, bool persistent = false);
+
 	~ClassBuffer();
 
 public:
@@ -31,18 +71,111 @@ public:
 		return reads;
 	}
 
+	/**
+	 * @brief Returns the total length of the class data.
+	 **/
+	inline
+	size_t Size() {
+		return size;
+	}
+
+	/**
+	 * @brief Returns the number of bytes left to be read.
+	 **/
+	inline
+	size_t Remaining() {
+		return size - position;
+	}
+
+	/**
+	 * @brief Checks if decoded objects may reference the buffer's bytes.
+	 **/
+	inline
+	bool IsPersistent() {
+		return persistent;
+	}
+
+	/**
+	 * @brief Returns a pointer to the next unread byte.
+	 **/
+	inline
+	const uint8_t *Current() {
+		return data + position;
+	}
+
 public:
-	size_t Position();
+	inline
+	size_t Position() {
+		return position;
+	}
 
 	void Skip(size_t count);
 
 	uint8_t *Next(uint8_t *dst, size_t count);
 
-	uint8_t NextByte();
+	/**
+	 * @brief Consumes a run of bytes without copying them.
+	 *
+	 * The returned pointer is only valid beyond the lifetime of the
+	 * buffer if the buffer is persistent.
+	 *
+	 * @param count The number of bytes to consume.
+	 * @return A pointer to the first of the consumed bytes.
+	 **/
+	inline
+	const uint8_t *Borrow(size_t count) {
+		const uint8_t *src;
+
+		Require(count);
+		reads += count;
+
+		src = data + position;
+		position += count;
+		return src;
+	}
+
+	inline
+	uint8_t NextByte() {
+		Require(1);
+		reads++;
+
+		return data[position++];
+	}
+
+	inline
+	uint16_t NextShort() {
+		const uint8_t *src;
+
+		Require(2);
+		reads++;
 
-	uint16_t NextShort();
+		src = data + position;
+		position += 2;
+		return (uint16_t)((src[0] << 8) | src[1]);
+	}
+
+	inline
+	uint32_t NextInt() {
+		const uint8_t *src;
+
+		Require(4);
+		reads++;
+
+		src = data + position;
+		position += 4;
+		return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16)
+				| ((uint32_t)src[2] << 8) | (uint32_t)src[3];
+	}
+
+private:
+	inline
+	void Require(size_t count) {
+		if(count > size - position) {
+			Underflow(count);
+		}
+	}
 
-	uint32_t NextInt();
+	void Underflow(size_t count);
 };
 
 } /* JBC */
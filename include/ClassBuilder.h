@@ -1,6 +1,8 @@
+
 # ifndef __CLASSBUILDER_H__
 # define __CLASSBUILDER_H__
 
+# include <vector>
 # include <stdio.h>
 # include <stdint.h>
 
@@ -16,33 +18,154 @@ struct BuilderError
 	}
 };
 
+/**
+ * @class ClassBuilder
+ * @brief A write cursor that encodes a class file into memory.
+ *
+ * Values are appended to a contiguous, growable buffer in big-endian
+ * order. The buffer may be inspected with Data() and Size(), handed
+ * off with Take(), or cleared with Reset() for reuse, which keeps its
+ * capacity. When constructed with a FILE, the buffered bytes are
+ * written out in one call by Flush(), or when the builder is destroyed.
+ **/
 class ClassBuilder {
 private:
-	FILE *output;
+	std::vector<uint8_t> output;
+
+	// Target file, if any.
+	FILE *target;
 	unsigned writes;
 
 public:
+	/**
+	 * @brief Creates a builder that encodes into memory only.
+	 **/
+	ClassBuilder();
+
+	/**
+	 * @brief Creates a builder that is flushed into a file.
+	 *
+	 * The file is closed when the builder is destroyed.
+	 *
+	 * @param output The file to write to.
+	 **/
 	ClassBuilder(FILE *output);
 	~ClassBuilder();
 
+private:
+	ClassBuilder(const ClassBuilder &);
+	ClassBuilder &operator=(const ClassBuilder &);
+
 public:
 	inline
 	unsigned GetWrites() {
 		return writes;
 	}
 
+	/**
+	 * @brief Returns a pointer to the encoded bytes.
+	 **/
+	inline
+	const uint8_t *Data() {
+		return output.empty() ? NULL : &output[0];
+	}
+
+	/**
+	 * @brief Returns the number of encoded bytes.
+	 **/
+	inline
+	size_t Size() {
+		return output.size();
+	}
+
+	/**
+	 * @brief Ensures room for a number of bytes without regrowing.
+	 *
+	 * @param count The total number of bytes expected.
+	 **/
+	inline
+	void Reserve(size_t count) {
+		output.reserve(count);
+	}
+
+	/**
+	 * @brief Hands off the encoded bytes, leaving the builder empty.
+	 *
+	 * @return The encoded bytes.
+	 **/
+	std::vector<uint8_t> Take();
+
+	/**
+	 * @brief Discards the encoded bytes, keeping the allocated capacity.
+	 **/
+	void Reset();
+
+	/**
+	 * @brief Writes the encoded bytes out to the target file, if any.
+	 *
+	 * The builder is left empty once the bytes are written.
+	 **/
+	void Flush();
+
 public:
-	size_t Position();
+	inline
+	size_t Position() {
+		return output.size();
+	}
 
 	ClassBuilder *Skip(size_t count);
 
-	ClassBuilder *Next(uint8_t *src, size_t count);
+	ClassBuilder *Next(const uint8_t *src, size_t count);
 
-	ClassBuilder *NextByte(uint8_t byte);
+	inline
+	ClassBuilder *NextByte(uint8_t byte) {
+		writes++;
+		output.push_back(byte);
+		return this;
+	}
 
-	ClassBuilder *NextShort(uint16_t word);
+	inline
+	ClassBuilder *NextShort(uint16_t word) {
+		uint8_t *dst = Grow(2);
+
+		writes++;
+		dst[0] = (uint8_t)(word >> 8);
+		dst[1] = (uint8_t)word;
+		return this;
+	}
+
+	inline
+	ClassBuilder *NextInt(uint32_t dword) {
+		uint8_t *dst = Grow(4);
 
-	ClassBuilder *NextInt(uint32_t dword);
+		writes++;
+		dst[0] = (uint8_t)(dword >> 24);
+		dst[1] = (uint8_t)(dword >> 16);
+		dst[2] = (uint8_t)(dword >> 8);
+		dst[3] = (uint8_t)dword;
+		return this;
+	}
+
+	/**
+	 * @brief Overwrites a short already written, such as a count.
+	 *
+	 * @param position The position of the short.
+	 * @param word The value to write.
+	 **/
+	inline
+	ClassBuilder *PatchShort(size_t position, uint16_t word) {
+		output[position] = (uint8_t)(word >> 8);
+		output[position + 1] = (uint8_t)word;
+		return this;
+	}
+
+private:
+	inline
+	uint8_t *Grow(size_t count) {
+		size_t position = output.size();
+		output.resize(position + count);
+		return &output[position];
+	}
 };
 
 } /* JBC */
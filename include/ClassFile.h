@@ -9,10 +9,13 @@
 
 # include <vector>
 # include <stdio.h>
+# include <string_view>
 # include <stdlib.h>
 
 # include "ClassBuffer.h"
 # include "ClassBuilder.h"
+# include "MemberIndex.h"
+# include "ConstantIndex.h"
 
 /**
  * @addtogroup ClassFile
@@ -28,11 +31,124 @@ namespace JBC {
 # define JAVA_MAGIC 0xCAFEBABE
 
 struct ConstantInfo;
+struct ConstantUtf8Info;
+class ClassHierarchy;
 struct ConstantClassInfo;
+struct ConstantStringInfo;
+struct ConstantIntegerInfo;
+struct ConstantFloatInfo;
+struct ConstantLongInfo;
+struct ConstantDoubleInfo;
+struct ConstantNameAndTypeInfo;
+struct ConstantFieldRefInfo;
+struct ConstantMethodRefInfo;
+struct ConstantInterfaceMethodRefInfo;
+
+class Arena;
+class MappedFile;
+class ProducerRegistry;
 
 class MemberInfo;
 struct AttributeInfo;
 
+/**
+ * @brief How much of a class file to decode.
+ **/
+enum DecodeDepth {
+	// Constants, flags, class names and interfaces.
+	DECODE_HEADER,
+	// The header, and member flags, names and descriptors.
+	DECODE_MEMBERS,
+	// The entire class file.
+	DECODE_FULL
+};
+
+/**
+ * @enum ComputeFlags
+ * @brief Values recomputed for modified methods when encoding.
+ **/
+enum ComputeFlags {
+	COMPUTE_NONE	= 0x0000,	/**< Encode values as they are.				*/
+	COMPUTE_LIMITS	= 0x0001,	/**< Recompute max_stack and max_locals.	*/
+	COMPUTE_FRAMES	= 0x0002	/**< Also recompute stack map frames.		*/
+};
+
+/**
+ * @struct DecodeOptions
+ * @brief Settings controlling how a class file is decoded.
+ **/
+struct DecodeOptions {
+	/**
+	 * @brief The magic number to check for when decoding.
+	 **/
+	uint32_t	magic;
+
+	/**
+	 * @brief The arena to decode into, or NULL for a private one.
+	 **/
+	Arena		*arena;
+
+	/**
+	 * @brief Whether to defer decoding the contents of Code attributes.
+	 *
+	 * When set, Code attributes only record their encoded contents,
+	 * which are decoded by CodeAttribute::Load(), and written back
+	 * unchanged if never loaded.
+	 **/
+	bool		lazy_code;
+
+	/**
+	 * @brief The sections of the class file to decode.
+	 *
+	 * Decoding stops after the requested section, leaving the rest of
+	 * the class unread. Partially decoded classes cannot be encoded.
+	 **/
+	DecodeDepth	depth;
+
+	/**
+	 * @brief Standard attribute kinds to drop, as an AttributeMask() set.
+	 **/
+	uint32_t	attribute_filter;
+
+	/**
+	 * @brief Selects nonstandard attributes to drop, by name; may be NULL.
+	 **/
+	bool		(*name_filter)(std::string_view name);
+
+	/**
+	 * @brief Whether filtered attributes are kept as OpaqueAttributes.
+	 *
+	 * Filtered attributes are otherwise skipped, and are missing from
+	 * the class when it is encoded.
+	 **/
+	bool		keep_filtered;
+
+	/**
+	 * @brief Producers for nonstandard constants and attributes; may be NULL.
+	 *
+	 * These are consulted before the global producers, and are only
+	 * seen by decodes given them. The registry must outlive the decode.
+	 **/
+	const ProducerRegistry *producers;
+
+	/**
+	 * @brief Whether unmodified members and attributes are copied on encode.
+	 *
+	 * Only applies to persistent sources, whose encoded members and
+	 * attributes are recorded while decoding. Changes made inside an
+	 * attribute are not detected, so with this set, modified attributes
+	 * must be marked with AttributeInfo::MarkDirty() or are lost.
+	 **/
+	bool		copy_unmodified;
+
+	inline
+	DecodeOptions()
+		: magic(JAVA_MAGIC), arena(NULL), lazy_code(false), depth(DECODE_FULL),
+		  attribute_filter(0), name_filter(NULL), keep_filtered(false),
+		  producers(NULL), copy_unmodified(false) {
+	}
+};
+
 enum ClassFlags {
 	CLASS_PUBLIC		= 0x0001,
 	CLASS_FINAL			= 0x0010,
@@ -157,6 +273,61 @@ public:
 	 **/
 	std::vector<AttributeInfo *> attributes;
 
+	// Source Mapping
+	/**
+	 * @brief The mapped file this class was decoded from, or NULL.
+	 *
+	 * Only set when the mapping was retained during decoding, in which
+	 * case constants and code in this ClassFile may reference the mapped
+	 * bytes directly. The mapping is released along with the ClassFile.
+	 **/
+	MappedFile *mapping;
+
+	// Allocation
+	/**
+	 * @brief The arena this class was decoded into, or NULL.
+	 *
+	 * Constants, members, attributes, and their contents are allocated
+	 * from this arena while decoding, and deleting them only runs their
+	 * destructors. Unless supplied by the caller, the arena is created
+	 * by the first decode, and released along with the ClassFile.
+	 **/
+	Arena *arena;
+
+	/**
+	 * @brief The options this class was decoded with.
+	 **/
+	DecodeOptions options;
+
+	/**
+	 * @brief Values to recompute when encoding, a set of ComputeFlags.
+	 *
+	 * Only methods whose Code attribute was modified, as marked by
+	 * InstructionList::Link() or AttributeInfo::MarkDirty(), are
+	 * recomputed; other code is left as decoded.
+	 **/
+	uint32_t	compute;
+
+	/**
+	 * @brief Resolves common superclasses for COMPUTE_FRAMES.
+	 *
+	 * NULL uses the base ClassHierarchy, which knows no classes.
+	 **/
+	ClassHierarchy *hierarchy;
+
+private:
+	bool owns_arena;
+
+	// Whether source bytes may be copied while encoding.
+	bool reuse_source;
+
+	// Member Lookup
+	MemberIndex field_index;
+	MemberIndex method_index;
+
+	// Constant Lookup
+	ConstantIndex constant_index;
+
 public:
 	// Constructors
 	/**
@@ -175,6 +346,14 @@ public:
 	 * @param magic The magic number to check for when decoding.
 	 **/
 	ClassFile(ClassBuffer *buffer, uint32_t magic = JAVA_MAGIC);
+	/**
+	 * @brief Constructor for a class file decoded into a shared arena.
+	 *
+	 * The arena is not released with the class file, and must outlive it.
+	 *
+	 * @param arena The arena to allocate decoded data from.
+	 **/
+	ClassFile(Arena *arena);
 
 	/**
 	 * @brief Destructor for the class file type.
@@ -210,12 +389,127 @@ public:
 	 * @brief Adds a Constant to this Class File.
 	 *
 	 * This also sets the index field of the attribute to its
-	 * position within the constant pool.
+	 * position within the constant pool. 'Long' constants are
+	 * followed by a NULL entry, as they take up two indexes.
 	 *
 	 * @return A refernce to the Constant.
 	 */
 	ConstantInfo *&AddConstant(ConstantInfo *info);
 
+	/**
+	 * @brief Looks up a UTF-8 constant, adding it if not present.
+	 *
+	 * Like the other FindOrAdd functions, this goes through a hash
+	 * index over the constant pool, built on first use, so that the
+	 * pool gains no duplicates. Constants referenced by the new entry
+	 * are looked up, and added, in turn.
+	 *
+	 * @param value The string value of the constant.
+	 * @return The existing or newly added constant.
+	 **/
+	ConstantUtf8Info *FindOrAddUtf8(std::string_view value);
+
+	/**
+	 * @brief Looks up a class constant, adding it if not present.
+	 *
+	 * @param name The internal name of the class.
+	 **/
+	ConstantClassInfo *FindOrAddClass(std::string_view name);
+
+	/**
+	 * @brief Looks up a string constant, adding it if not present.
+	 *
+	 * @param value The string value of the constant.
+	 **/
+	ConstantStringInfo *FindOrAddString(std::string_view value);
+
+	/**
+	 * @brief Looks up an integer constant, adding it if not present.
+	 **/
+	ConstantIntegerInfo *FindOrAddInteger(int32_t value);
+
+	/**
+	 * @brief Looks up a float constant, adding it if not present.
+	 *
+	 * Floats are compared by their bit patterns.
+	 **/
+	ConstantFloatInfo *FindOrAddFloat(float value);
+
+	/**
+	 * @brief Looks up a long constant, adding it if not present.
+	 **/
+	ConstantLongInfo *FindOrAddLong(int64_t value);
+
+	/**
+	 * @brief Looks up a double constant, adding it if not present.
+	 *
+	 * Doubles are compared by their bit patterns.
+	 **/
+	ConstantDoubleInfo *FindOrAddDouble(double value);
+
+	/**
+	 * @brief Looks up a name and type constant, adding it if not present.
+	 *
+	 * @param name The member name.
+	 * @param descriptor The member descriptor.
+	 **/
+	ConstantNameAndTypeInfo *FindOrAddNameAndType(std::string_view name,
+			std::string_view descriptor);
+
+	/**
+	 * @brief Looks up a field reference, adding it if not present.
+	 *
+	 * @param owner The internal name of the declaring class.
+	 * @param name The field name.
+	 * @param descriptor The field descriptor.
+	 **/
+	ConstantFieldRefInfo *FindOrAddFieldRef(std::string_view owner,
+			std::string_view name, std::string_view descriptor);
+
+	/**
+	 * @brief Looks up a method reference, adding it if not present.
+	 *
+	 * @param owner The internal name of the declaring class.
+	 * @param name The method name.
+	 * @param descriptor The method descriptor.
+	 **/
+	ConstantMethodRefInfo *FindOrAddMethodRef(std::string_view owner,
+			std::string_view name, std::string_view descriptor);
+
+	/**
+	 * @brief Looks up an interface method reference, adding it if not present.
+	 *
+	 * @param owner The internal name of the declaring interface.
+	 * @param name The method name.
+	 * @param descriptor The method descriptor.
+	 **/
+	ConstantInterfaceMethodRefInfo *FindOrAddInterfaceMethodRef(
+			std::string_view owner, std::string_view name,
+			std::string_view descriptor);
+
+	/**
+	 * @brief Discards the constant pool lookup index.
+	 *
+	 * Adding constants keeps the index up to date. This is only needed
+	 * after modifying or reordering constants already in the pool.
+	 **/
+	inline
+	void InvalidateConstants() {
+		constant_index.Invalidate();
+	}
+
+	/**
+	 * @brief Checks if unmodified members may be encoded by copying.
+	 *
+	 * Source bytes reference constants by index, so can only be reused
+	 * while every constant is still at its original index. Only
+	 * meaningful while encoding.
+	 **/
+	inline
+	bool CanReuseSource() {
+		return reuse_source;
+	}
+
 	/**
 	 * @brief Returns a reference to this class's flags.
 	 **/
@@ -295,10 +589,21 @@ public:
 	/**
 	 * @brief Looks up a field, by name.
 	 *
+	 * Lookups go through a hash index, built on first use.
+	 *
 	 * @param name The name of the field to find.
 	 * @return A reference to the named field, if found.
 	 **/
-	MemberInfo *&FindField(std::string &name);
+	MemberInfo *&FindField(std::string_view name);
+
+	/**
+	 * @brief Looks up a field, by name and descriptor.
+	 *
+	 * @param name The name of the field to find.
+	 * @param descriptor The descriptor of the field to find.
+	 * @return A reference to the matching field, if found.
+	 **/
+	MemberInfo *&FindField(std::string_view name, std::string_view descriptor);
 
 	/**
 	 * @brief Adds a method to this class.
@@ -308,10 +613,34 @@ public:
 	/**
 	 * @brief Looks up a method, by name.
 	 *
+	 * Lookups go through a hash index, built on first use. If the
+	 * method is overloaded, the first declaration is returned.
+	 *
 	 * @param name The name of the method to find.
 	 * @return A reference to the named method, if found.
 	 **/
-	MemberInfo *&FindMethod(std::string &name);
+	MemberInfo *&FindMethod(std::string_view name);
+
+	/**
+	 * @brief Looks up a method, by name and descriptor.
+	 *
+	 * @param name The name of the method to find.
+	 * @param descriptor The descriptor of the method to find.
+	 * @return A reference to the matching method, if found.
+	 **/
+	MemberInfo *&FindMethod(std::string_view name, std::string_view descriptor);
+
+	/**
+	 * @brief Discards the member lookup indices.
+	 *
+	 * Adding members keeps the indices up to date. This is only needed
+	 * after renaming members, or reordering the member tables in place.
+	 **/
+	inline
+	void InvalidateMembers() {
+		field_index.Invalidate();
+		method_index.Invalidate();
+	}
 
 	/**
 	 * @brief Attaches an Attribute to this class.
@@ -414,6 +743,16 @@ public:
 	 **/
 	void EncodeClassFile(ClassBuilder *builder);
 
+	/**
+	 * @brief Computes the exact encoded size of the class file.
+	 *
+	 * Walks the class file tree without writing anything, so that
+	 * an output buffer can be sized once before encoding.
+	 *
+	 * @return The size of the encoded class file, in bytes.
+	 **/
+	uint32_t ComputeSize();
+
 private:
 	void DecodeConstants(ClassBuffer *buffer);
 	void EncodeConstants(ClassBuilder *builder);
@@ -432,6 +771,14 @@ private:
 
 	void DecodeAttributes(ClassBuffer *buffer);
 	void EncodeAttributes(ClassBuilder *builder);
+
+	bool ConstantsInPlace();
+
+	// Releases members, constants and the private arena.
+	void Release();
+
+	template<typename Constant>
+	Constant *FindOrAdd(Constant &key);
 };
 
 /**
@@ -444,9 +791,104 @@ private:
  *
  * @param source The file to create the ClassBuffer from.
  * @param magic The magic number to check for when decoding.
+ * @param arena The arena to decode into, or NULL for a private one.
  * @return The class file representation of the input file.
  **/
-ClassFile *DecodeClassFile(FILE *source, uint32_t magic = JAVA_MAGIC);
+ClassFile *DecodeClassFile(FILE *source, uint32_t magic = JAVA_MAGIC,
+		Arena *arena = NULL);
+
+/**
+ * @brief Reads and creates a class file from an input file.
+ *
+ * @param source The file to create the ClassBuffer from.
+ * @param options The settings to decode with.
+ * @return The class file representation of the input file.
+ **/
+ClassFile *DecodeClassFile(FILE *source, const DecodeOptions &options);
+
+/**
+ * @brief Reads and creates a class file from bytes in memory.
+ *
+ * Decoder helper function. Creates a ClassBuffer over the given span,
+ * and uses it to populate a new ClassFile object. The bytes are read
+ * in place, and are not retained once the method returns.
+ *
+ * @param data The start of the class file data.
+ * @param size The length of the class file data, in bytes.
+ * @param magic The magic number to check for when decoding.
+ * @param arena The arena to decode into, or NULL for a private one.
+ * @return The class file representation of the input data.
+ **/
+ClassFile *DecodeClassFile(const uint8_t *data, size_t size,
+		uint32_t magic = JAVA_MAGIC, Arena *arena = NULL);
+
+/**
+ * @brief Reads and creates a class file from bytes in memory.
+ *
+ * @param data The start of the class file data.
+ * @param size The length of the class file data, in bytes.
+ * @param options The settings to decode with.
+ * @return The class file representation of the input data.
+ **/
+ClassFile *DecodeClassFile(const uint8_t *data, size_t size,
+		const DecodeOptions &options);
+
+/**
+ * @brief Reads and creates a class file that references bytes in memory.
+ *
+ * Decoder helper function. Like DecodeClassFile(), but UTF-8 constants
+ * and bytecode reference the given bytes instead of being copied, and
+ * are only copied if later modified. The bytes must remain valid and
+ * unchanged for the lifetime of the returned ClassFile.
+ *
+ * @param data The start of the class file data.
+ * @param size The length of the class file data, in bytes.
+ * @param magic The magic number to check for when decoding.
+ * @param arena The arena to decode into, or NULL for a private one.
+ * @return The class file representation of the input data.
+ **/
+ClassFile *DecodeClassFileInPlace(const uint8_t *data, size_t size,
+		uint32_t magic = JAVA_MAGIC, Arena *arena = NULL);
+
+/**
+ * @brief Reads and creates a class file that references bytes in memory.
+ *
+ * @param data The start of the class file data.
+ * @param size The length of the class file data, in bytes.
+ * @param options The settings to decode with.
+ * @return The class file representation of the input data.
+ **/
+ClassFile *DecodeClassFileInPlace(const uint8_t *data, size_t size,
+		const DecodeOptions &options);
+
+/**
+ * @brief Reads and creates a class file from a memory mapped file.
+ *
+ * Decoder helper function. Maps the file read-only, and decodes
+ * directly out of the mapping. If the mapping is retained, it is
+ * handed to the new ClassFile, and UTF-8 constants and bytecode
+ * reference the mapped bytes instead of being copied. Otherwise,
+ * the file is unmapped when the method exits.
+ *
+ * @param path The path to the class file.
+ * @param retain Whether to keep the mapping alive with the ClassFile.
+ * @param magic The magic number to check for when decoding.
+ * @param arena The arena to decode into, or NULL for a private one.
+ * @return The class file representation of the mapped file.
+ **/
+ClassFile *DecodeClassFileMapped(const char *path, bool retain = false,
+		uint32_t magic = JAVA_MAGIC, Arena *arena = NULL);
+
+/**
+ * @brief Reads and creates a class file from a memory mapped file.
+ *
+ * @param path The path to the class file.
+ * @param retain Whether to keep the mapping alive with the ClassFile.
+ * @param options The settings to decode with.
+ * @return The class file representation of the mapped file.
+ **/
+ClassFile *DecodeClassFileMapped(const char *path, bool retain,
+		const DecodeOptions &options);
 
 /**
  * @brief Writes a class file into an output file.
@@ -461,6 +903,19 @@ ClassFile *DecodeClassFile(FILE *source, uint32_t magic = JAVA_MAGIC);
  **/
 void EncodeClassFile(FILE *target, ClassFile *classFile);
 
+/**
+ * @brief Encodes a class file into memory.
+ *
+ * Encoder helper function. Creates a memory backed ClassBuilder,
+ * and uses it to write information for the ClassFile. To reuse one
+ * buffer across many classes, create a ClassBuilder directly, and
+ * Reset() it between calls to ClassFile::EncodeClassFile().
+ *
+ * @param classFile The class file to be written.
+ * @return The encoded class file.
+ **/
+std::vector<uint8_t> EncodeClassFile(ClassFile *classFile);
+
 } /* JBC */
 
 /**
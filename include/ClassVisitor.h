@@ -0,0 +1,296 @@
+/**
+ * @file ClassVisitor.h
+ *
+ * @brief Defines streaming decoding of class files into visitor events.
+ **/
+# ifndef __CLASSVISITOR_H__
+# define __CLASSVISITOR_H__
+
+# include <vector>
+# include <stdint.h>
+# include <string_view>
+
+# include "Bytecode.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassBuffer;
+
+/**
+ * @struct ConstantView
+ * @brief A constant pool entry, as it appears in the class data.
+ **/
+struct ConstantView {
+	uint16_t	index;
+	uint8_t		tag;
+
+	// The bytes following the tag.
+	const uint8_t *data;
+	uint32_t	length;
+
+	/**
+	 * @brief Returns the text of a CONSTANT_UTF8 entry.
+	 **/
+	inline
+	std::string_view Utf8() const {
+		return std::string_view((const char *)data + 2, length - 2);
+	}
+};
+
+/**
+ * @struct ClassView
+ * @brief The access flags, names and interfaces of a class.
+ **/
+struct ClassView {
+	uint16_t	access_flags;
+	uint16_t	this_class;
+	uint16_t	super_class;
+
+	// Resolved class names; super_name is empty for java/lang/Object.
+	std::string_view name;
+	std::string_view super_name;
+
+	// Interface indices, as raw shorts.
+	uint16_t	interfaces_count;
+	const uint8_t *interfaces;
+
+	/**
+	 * @brief Returns the constant pool index of an interface.
+	 **/
+	inline
+	uint16_t Interface(uint16_t idx) const {
+		const uint8_t *src = interfaces + 2 * idx;
+		return (uint16_t)((src[0] << 8) | src[1]);
+	}
+};
+
+/**
+ * @struct MemberView
+ * @brief The header of a field or method.
+ **/
+struct MemberView {
+	uint16_t	access_flags;
+	uint16_t	name_index;
+	uint16_t	descriptor_index;
+	uint16_t	attributes_count;
+
+	std::string_view name;
+	std::string_view descriptor;
+};
+
+/**
+ * @struct AttributeView
+ * @brief An attribute, as it appears in the class data.
+ **/
+struct AttributeView {
+	uint16_t	name_index;
+	std::string_view name;
+
+	// The bytes following the attribute length.
+	const uint8_t *data;
+	uint32_t	length;
+};
+
+/**
+ * @struct CodeView
+ * @brief The Code attribute of a method.
+ **/
+struct CodeView {
+	uint16_t	max_stack;
+	uint16_t	max_locals;
+
+	const uint8_t *code;
+	uint32_t	code_length;
+
+	// Exception entries, as four raw shorts each.
+	uint16_t	exception_table_length;
+	const uint8_t *exception_table;
+
+	// Nested attributes, as raw attribute data.
+	uint16_t	attributes_count;
+	const uint8_t *attributes;
+
+	// The whole attribute.
+	AttributeView attribute;
+};
+
+/**
+ * @class ClassVisitor
+ * @brief Receives the parts of a class file as they are decoded.
+ *
+ * Events are delivered in class file order :
+ *
+ * @code
+ * VisitHeader VisitConstant* VisitClass
+ * (VisitField VisitAttribute* VisitMemberEnd)*
+ * (VisitMethod (VisitAttribute | VisitCode VisitInstruction* VisitTryCatch*)*
+ *     VisitMemberEnd)*
+ * VisitAttribute* VisitEnd
+ * @endcode
+ *
+ * Visitors may be chained into a pipeline, each forwarding events to the
+ * next, as by a ClassWriter at the end. The default implementations
+ * forward every event unchanged, or do nothing at the end of a chain;
+ * subclasses override the events they need, and may drop, alter or
+ * inject events by calling the next visitor themselves. Views point into
+ * the class data, and are only valid until the event returns.
+ **/
+class ClassVisitor {
+protected:
+	// The next stage of the pipeline; may be NULL.
+	ClassVisitor *next;
+
+public:
+	/**
+	 * @brief Creates a visitor.
+	 *
+	 * @param next The visitor to forward events to, or NULL.
+	 **/
+	ClassVisitor(ClassVisitor *next = NULL);
+
+	virtual
+	~ClassVisitor();
+
+	virtual
+	void VisitHeader(uint32_t magic, uint16_t minor_version, uint16_t major_version);
+
+	virtual
+	void VisitConstant(const ConstantView &constant);
+
+	virtual
+	void VisitClass(const ClassView &info);
+
+	/**
+	 * @brief Visits a field.
+	 *
+	 * @return Whether to visit its attributes; if false, they are
+	 *		skipped, but VisitMemberEnd is still visited.
+	 **/
+	virtual
+	bool VisitField(const MemberView &field);
+
+	/**
+	 * @brief Visits a method.
+	 *
+	 * @return Whether to visit its attributes; if false, they are
+	 *		skipped, but VisitMemberEnd is still visited.
+	 **/
+	virtual
+	bool VisitMethod(const MemberView &method);
+
+	/**
+	 * @brief Visits an attribute of the class, a field or a method.
+	 *
+	 * Code attributes of methods are visited with VisitCode instead.
+	 **/
+	virtual
+	void VisitAttribute(const AttributeView &attribute);
+
+	/**
+	 * @brief Visits the code of a method.
+	 *
+	 * @return Whether to visit its instructions and exception table.
+	 **/
+	virtual
+	bool VisitCode(const CodeView &code);
+
+	/**
+	 * @brief Visits an instruction of the current method's code.
+	 *
+	 * Constants are not resolved; the instruction's index refers to
+	 * the constant pool, which may be queried through the ClassReader.
+	 **/
+	virtual
+	void VisitInstruction(const Instruction &insn);
+
+	virtual
+	void VisitTryCatch(uint16_t start_pc, uint16_t end_pc,
+			uint16_t handler_pc, uint16_t catch_type);
+
+	virtual
+	void VisitMemberEnd();
+
+	virtual
+	void VisitEnd();
+};
+
+/**
+ * @class ClassReader
+ * @brief Decodes a class file as a stream of visitor events.
+ *
+ * Unlike DecodeClassFile(), no objects are built; the reader walks the
+ * class data once, handing out views of the raw bytes. Its only state
+ * is the position of each constant, kept so names can be resolved, so
+ * a reader reused across classes runs in constant memory.
+ *
+ * @code
+ * ClassReader reader;
+ * ClassBuffer buffer(data, size);
+ * reader.Accept(&buffer, &visitor);
+ * @endcode
+ **/
+class ClassReader {
+private:
+	// Position of each constant's tag; NULL for unusable slots.
+	std::vector<const uint8_t *> constants;
+
+public:
+	/**
+	 * @brief Decodes a class, delivering its parts to a visitor.
+	 *
+	 * Malformed class data raises a DecodeError, possibly after some
+	 * events have been delivered.
+	 *
+	 * @param buffer The class data, positioned at the magic number.
+	 * @param visitor The visitor to deliver events to.
+	 **/
+	void Accept(ClassBuffer *buffer, ClassVisitor *visitor);
+
+public:
+	/**
+	 * @brief Returns the number of constant pool slots of the current class.
+	 **/
+	inline
+	uint32_t ConstantCount() const {
+		return constants.size();
+	}
+
+	/**
+	 * @brief Returns the tag of a constant, or 0 if there is none.
+	 **/
+	uint8_t ConstantTag(uint32_t index) const;
+
+	/**
+	 * @brief Returns the text of a CONSTANT_UTF8 entry.
+	 *
+	 * Raises a DecodeError if the index is not a UTF8 constant.
+	 **/
+	std::string_view Utf8(uint32_t index) const;
+
+	/**
+	 * @brief Returns the name of a CONSTANT_CLASS entry.
+	 *
+	 * Raises a DecodeError if the index is not a class constant.
+	 **/
+	std::string_view ClassName(uint32_t index) const;
+
+private:
+	void AcceptConstants(ClassBuffer *buffer, ClassVisitor *visitor);
+	void AcceptMember(ClassBuffer *buffer, ClassVisitor *visitor, bool method);
+	void AcceptAttributes(ClassBuffer *buffer, ClassVisitor *visitor,
+			uint16_t attributes_count, bool method);
+	void AcceptCode(const AttributeView &attribute, ClassVisitor *visitor);
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* ClassVisitor.h */
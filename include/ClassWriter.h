@@ -0,0 +1,151 @@
+/**
+ * @file ClassWriter.h
+ *
+ * @brief Defines encoding of class files from visitor events.
+ **/
+# ifndef __CLASSWRITER_H__
+# define __CLASSWRITER_H__
+
+# include <string>
+# include <vector>
+# include <string_view>
+# include <unordered_map>
+
+# include "ClassBuilder.h"
+# include "ClassVisitor.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+/**
+ * @class ClassWriter
+ * @brief Encodes the events of a ClassReader back into a class file.
+ *
+ * The writer ends a pipeline of visitors, so a class can be rewritten
+ * in a single pass without decoding it into a ClassFile :
+ *
+ * @code
+ * ClassBuilder output;
+ * ClassWriter writer(&output);
+ * RenameStage rename(&writer);
+ * reader.Accept(&buffer, &rename);
+ * @endcode
+ *
+ * Constants, interfaces and attributes, including Code, are copied as
+ * the raw byte ranges of their views, and members are encoded from their
+ * constant indices; names in views are ignored. Stages rename or inject
+ * elements by passing views with new indices and data, adding constants
+ * with the FindOrAdd functions. All constants of the source class must
+ * be forwarded in order, since copied attributes refer to them by index;
+ * new constants are appended after them, so may only be added once the
+ * source constants have been forwarded, from VisitClass on.
+ *
+ * A member is written once its VisitField or VisitMethod reaches the
+ * writer, with the attributes forwarded after it, even if a stage then
+ * returns false to skip the rest; to drop a member, do not forward it.
+ *
+ * Code is written only from the raw attribute passed to VisitCode, which
+ * returns false; instruction and exception table events are not
+ * encoded, and are ignored if a stage forwards them. To change code, a
+ * stage must pass VisitCode an attribute view holding the new contents.
+ *
+ * The writer keeps its buffers between classes, so reusing one writer
+ * across a jar runs in constant memory.
+ **/
+class ClassWriter
+		: public ClassVisitor {
+private:
+	enum Section {
+		SECTION_FIELDS,
+		SECTION_METHODS,
+		SECTION_ATTRIBUTES
+	};
+
+private:
+	ClassBuilder *output;
+
+	// Constants, and everything following them.
+	ClassBuilder pool;
+	ClassBuilder body;
+
+	uint32_t	magic;
+	uint16_t	minor_version;
+	uint16_t	major_version;
+
+	// The next free constant pool slot.
+	uint32_t	constant_count;
+
+	// Offset of each constant in the pool; built for lookups.
+	std::vector<uint32_t> offsets;
+	std::unordered_map<std::string, uint16_t> entries;
+	bool		indexed;
+
+	// Counts being written, and the positions to patch them at.
+	Section		section;
+	uint32_t	count;
+	size_t		count_position;
+	uint32_t	member_attributes;
+	size_t		member_attributes_position;
+	bool		in_member;
+
+public:
+	/**
+	 * @brief Creates a writer.
+	 *
+	 * @param output The builder each class is appended to, at VisitEnd.
+	 **/
+	ClassWriter(ClassBuilder *output);
+
+public:
+	void VisitHeader(uint32_t magic, uint16_t minor_version, uint16_t major_version);
+	void VisitConstant(const ConstantView &constant);
+	void VisitClass(const ClassView &info);
+	bool VisitField(const MemberView &field);
+	bool VisitMethod(const MemberView &method);
+	void VisitAttribute(const AttributeView &attribute);
+	bool VisitCode(const CodeView &code);
+	void VisitMemberEnd();
+	void VisitEnd();
+
+public:
+	/**
+	 * @brief Finds or adds a constant given its raw bytes.
+	 *
+	 * @param tag The constant tag.
+	 * @param data The bytes following the tag.
+	 * @param length The number of bytes following the tag.
+	 * @return The constant pool index of the constant.
+	 **/
+	uint16_t FindOrAdd(uint8_t tag, const uint8_t *data, uint32_t length);
+
+	uint16_t FindOrAddUtf8(std::string_view value);
+	uint16_t FindOrAddClass(std::string_view name);
+	uint16_t FindOrAddString(std::string_view value);
+	uint16_t FindOrAddNameAndType(std::string_view name, std::string_view descriptor);
+	uint16_t FindOrAddFieldRef(std::string_view owner,
+			std::string_view name, std::string_view descriptor);
+	uint16_t FindOrAddMethodRef(std::string_view owner,
+			std::string_view name, std::string_view descriptor);
+	uint16_t FindOrAddInterfaceMethodRef(std::string_view owner,
+			std::string_view name, std::string_view descriptor);
+
+private:
+	void IndexConstants();
+	void Enter(Section section);
+	void WriteMember(const MemberView &member);
+	void CloseMember();
+	void WriteCount(size_t position, uint32_t count, const char *kind);
+	uint16_t FindOrAddReference(uint8_t tag, std::string_view owner,
+			std::string_view name, std::string_view descriptor);
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* ClassWriter.h */
@@ -0,0 +1,82 @@
+/**
+ * @file ConstantIndex.h
+ *
+ * @brief Defines the hash index over constant pool values.
+ **/
+# ifndef __CONSTANTINDEX_H__
+# define __CONSTANTINDEX_H__
+
+# include <vector>
+# include <stddef.h>
+# include <stdint.h>
+# include <unordered_map>
+
+namespace JBC {
+
+struct ConstantInfo;
+
+/**
+ * @class ConstantIndex
+ * @brief A hash index over the values in a constant pool.
+ *
+ * Constants are indexed by their tag and contents, as encoded; entries
+ * that reference other constants are keyed by the referenced indices.
+ * Like MemberIndex, only hashes and pool positions are stored, and hits
+ * are checked against the constant itself. The index is built on first
+ * lookup, extended as constants are appended, and rebuilt if the pool
+ * changes size. Constants modified in place require an Invalidate().
+ *
+ * Constants of nonstandard types are never indexed.
+ **/
+class ConstantIndex {
+private:
+	typedef std::unordered_multimap<size_t, uint16_t> Table;
+
+	// Hashes to pool indices.
+	Table constants;
+
+	// Number of pool slots indexed.
+	size_t count;
+	bool valid;
+
+public:
+	inline
+	ConstantIndex()
+		: count(0), valid(false) {
+	}
+
+public:
+	/**
+	 * @brief Discards the index, to be rebuilt by the next lookup.
+	 **/
+	inline
+	void Invalidate() {
+		valid = false;
+	}
+
+	/**
+	 * @brief Records a constant appended to the end of the pool.
+	 *
+	 * Does nothing until the index is first built.
+	 *
+	 * @param pool The indexed constant pool.
+	 * @param info The constant that was appended.
+	 **/
+	void Append(std::vector<ConstantInfo *> &pool, ConstantInfo *info);
+
+	/**
+	 * @brief Finds the first constant equal to the given one.
+	 *
+	 * @param pool The indexed constant pool.
+	 * @param key A constant with the value to look for.
+	 * @return The matching constant in the pool, or NULL.
+	 **/
+	ConstantInfo *Find(std::vector<ConstantInfo *> &pool, ConstantInfo *key);
+
+private:
+	void Rebuild(std::vector<ConstantInfo *> &pool);
+};
+
+} /* JBC */
+
+# endif /* ConstantIndex.h */
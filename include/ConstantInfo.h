@@ -10,8 +10,10 @@
 # define __CONSTANTINFO_H__
 
 # include <string>
+# include <string_view>
 # include <stdint.h>
 
+# include "Arena.h"
 # include "ClassBuffer.h"
 # include "ClassBuilder.h"
 
@@ -25,6 +27,9 @@
  **/
 namespace JBC {
 
+// Forward Declarations.
+class ProducerRegistry;
+
 /**
  * @enum ConstantType
  * @brief An enumeration of the constant types found in Java class files.
@@ -63,7 +68,8 @@ enum ConstantType {
  * including the definition of their identifier tag, and the position
  * of the constant in the constant pool (which is used when encoding).
  **/
-struct ConstantInfo {
+struct ConstantInfo
+		: public ArenaObject {
 	/**
 	 * @brief The identifier tag, used to differenciate constant types.
 	 **/
@@ -124,6 +130,18 @@ struct ConstantInfo {
 		return false;
 	}
 
+	/**
+	 * @brief Computes the exact encoded size of this constant.
+	 *
+	 * The default implementation encodes the constant into a scratch
+	 * ClassBuilder and measures the result. Standard constant types
+	 * override this with their fixed layouts.
+	 *
+	 * @return The size of the encoded constant, including its tag.
+	 **/
+	virtual
+	uint32_t ComputeSize();
+
 	/**
 	 * @brief Used to decode constant information from a ClassBuffer.
 	 *
@@ -166,6 +184,11 @@ struct ConstantClassInfo
 		: ConstantInfo(CONSTANT_CLASS), name_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
+
 	ConstantClassInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantClassInfo *EncodeConstant(ClassBuilder *builder);
@@ -201,6 +224,11 @@ struct ConstantFieldRefInfo
 		  name_and_type_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantFieldRefInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantFieldRefInfo *EncodeConstant(ClassBuilder *builder);
@@ -236,6 +264,11 @@ struct ConstantMethodRefInfo
 		  name_and_type_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantMethodRefInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantMethodRefInfo *EncodeConstant(ClassBuilder *builder);
@@ -271,6 +304,11 @@ struct ConstantInterfaceMethodRefInfo
 		  name_and_type_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantInterfaceMethodRefInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantInterfaceMethodRefInfo *EncodeConstant(ClassBuilder *builder);
@@ -299,6 +337,11 @@ struct ConstantStringInfo
 		: ConstantInfo(CONSTANT_STRING), string_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
+
 	ConstantStringInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantStringInfo *EncodeConstant(ClassBuilder *builder);
@@ -325,6 +368,11 @@ struct ConstantIntegerInfo
 		: ConstantInfo(CONSTANT_INTEGER), bytes(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantIntegerInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantIntegerInfo *EncodeConstant(ClassBuilder *builder);
@@ -351,6 +399,11 @@ struct ConstantFloatInfo
 		: ConstantInfo(CONSTANT_FLOAT), bytes(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantFloatInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantFloatInfo *EncodeConstant(ClassBuilder *builder);
@@ -389,6 +442,11 @@ struct ConstantLongInfo
 		return true;
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 9;
+	}
+
 	ConstantLongInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantLongInfo *EncodeConstant(ClassBuilder *builder);
@@ -427,6 +485,11 @@ struct ConstantDoubleInfo
 		return true;
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 9;
+	}
+
 	ConstantDoubleInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantDoubleInfo *EncodeConstant(ClassBuilder *builder);
@@ -462,6 +525,11 @@ struct ConstantNameAndTypeInfo
 		  descriptor_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantNameAndTypeInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantNameAndTypeInfo *EncodeConstant(ClassBuilder *builder);
@@ -478,12 +546,26 @@ struct ConstantUtf8Info
 	 **/
 	uint16_t	length;
 	/**
-	 * @brief The UTF-8 encoded string, in a null-terminated form.
+	 * @brief The UTF-8 encoded string.
 	 *
-	 * This field is null-terminated for convinience and simplicity. This value
-	 * is stored without the null-terminator in its encoded form.
+	 * When decoded into a copy, this field is null-terminated for convinience
+	 * and simplicity. When borrowed from a persistent source, it points
+	 * directly into the source bytes, and is neither null-terminated nor
+	 * writable; use the length field to find its end, and MutableBytes()
+	 * or SetBytes() to modify it.
 	 **/
 	uint8_t		*bytes;
+	/**
+	 * @brief Whether the string is borrowed from the decoding source.
+	 *
+	 * Borrowed strings are not released with the constant. Strings
+	 * copied into the decoding arena are borrowed from the arena.
+	 **/
+	bool		borrowed;
+	/**
+	 * @brief The AttributeKind named by this string, once resolved.
+	 **/
+	uint8_t		attribute_kind;
 
 	/**
 	 * @brief Constructor for ConstantUtf8Info.
@@ -492,16 +574,58 @@ struct ConstantUtf8Info
 	 * of CONSTANT_UTF8_INFO.
 	 **/
 	ConstantUtf8Info()
-		: ConstantInfo(CONSTANT_UTF8), length(0), bytes(NULL) {
+		: ConstantInfo(CONSTANT_UTF8), length(0), bytes(NULL),
+		  borrowed(false), attribute_kind(0) {
 	}
 
 	/**
 	 * @brief Destructor for ConstantUtf8Info.
 	 *
-	 * Deletes the the UTF-8 encoded string from memory.
+	 * Deletes the the UTF-8 encoded string from memory, unless borrowed.
 	 **/
 	~ConstantUtf8Info();
 
+	/**
+	 * @brief Returns a view of the string, valid until it is modified.
+	 **/
+	inline
+	std::string_view View() {
+		return std::string_view(reinterpret_cast<char *>(bytes), length);
+	}
+
+	/**
+	 * @brief Returns a writable, null-terminated copy of the string.
+	 *
+	 * Borrowed strings are first copied into memory owned by the
+	 * constant, after which the source bytes are no longer referenced.
+	 * The length of the string may not be changed through this pointer.
+	 *
+	 * @return The owned UTF-8 encoded string.
+	 **/
+	uint8_t *MutableBytes();
+
+	/**
+	 * @brief Replaces the string value with a copy of the given bytes.
+	 *
+	 * @param data The new UTF-8 encoded string.
+	 * @param length The length of the new string, in bytes.
+	 **/
+	void SetBytes(const uint8_t *data, uint16_t length);
+
+	/**
+	 * @brief Replaces the string value with a copy of the given string.
+	 *
+	 * Raises a JBCError if the string is longer than 65535 bytes.
+	 *
+	 * @param value The new UTF-8 encoded string.
+	 **/
+	void SetString(const std::string &value);
+
+	inline
+	uint32_t ComputeSize() {
+		return 3 + length;
+	}
+
 	ConstantUtf8Info *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantUtf8Info *EncodeConstant(ClassBuilder *builder);
@@ -538,6 +662,11 @@ struct ConstantMethodHandleInfo
 		  reference_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 4;
+	}
+
 	ConstantMethodHandleInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantMethodHandleInfo *EncodeConstant(ClassBuilder *builder);
@@ -566,6 +695,11 @@ struct ConstantMethodTypeInfo
 		: ConstantInfo(CONSTANT_METHOD_TYPE), descriptor_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
+
 	ConstantMethodTypeInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantMethodTypeInfo *EncodeConstant(ClassBuilder *builder);
@@ -602,6 +736,11 @@ struct ConstantInvokeDynamicInfo
 		  name_and_type_index(0) {
 	}
 
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
+
 	ConstantInvokeDynamicInfo *DecodeConstant(ClassBuffer *buffer);
 
 	ConstantInvokeDynamicInfo *EncodeConstant(ClassBuilder *builder);
@@ -624,7 +763,8 @@ typedef ConstantInfo *(* ConstantProducer)(uint8_t tag, ClassBuffer *);
  *			for reading nonstandard Constant types.
  *
  * ConstantProducers registered with this fuction can be unhooked by
- * registering @c NULL to the same tag index.
+ * registering @c NULL to the same tag index. They are held in the
+ * global ProducerRegistry, which decoding threads read without locks.
  *
  * @code{.cpp}
  *	ConstantInfo *MyConstantProducer(uint8_t, ClassBuffer *buffer) {
@@ -654,9 +794,11 @@ void RegisterProducer(uint8_t tag, ConstantProducer producer);
  * type, if able.
  *
  * @param buffer The ClassBuffer to be read from.
+ * @param producers Producers to consult before the global ones; may be NULL.
  * @return The newly read constant.
  **/
-ConstantInfo *DecodeConstant(ClassBuffer *buffer);
+ConstantInfo *DecodeConstant(ClassBuffer *buffer,
+		const ProducerRegistry *producers = NULL);
 
 /**
  * @brief Writes a constant info a ClassBuilder.
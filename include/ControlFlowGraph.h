@@ -0,0 +1,160 @@
+/**
+ * @file ControlFlowGraph.h
+ *
+ * @brief Defines control flow graphs over method bytecode.
+ **/
+# ifndef __CONTROLFLOWGRAPH_H__
+# define __CONTROLFLOWGRAPH_H__
+
+# include <vector>
+# include <stdint.h>
+
+# include "Bytecode.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassFile;
+struct CodeAttribute;
+struct ExceptionTableEntry;
+
+/**
+ * @enum EdgeKind
+ * @brief How control passes along an edge.
+ **/
+enum EdgeKind {
+	EDGE_FALLTHROUGH,	/**< Into the following block.						*/
+	EDGE_BRANCH,		/**< By a branch, goto or switch.					*/
+	EDGE_JSR,			/**< Into a subroutine.								*/
+	EDGE_EXCEPTION		/**< To a handler covering the source block.		*/
+};
+
+/**
+ * @struct ControlFlowEdge
+ * @brief An edge to or from a basic block.
+ **/
+struct ControlFlowEdge {
+	// The block at the other end of the edge.
+	uint32_t	block;
+	uint8_t		kind;
+};
+
+/**
+ * @struct BasicBlock
+ * @brief A maximal run of instructions entered only at the top.
+ **/
+struct BasicBlock {
+	// Offsets of the first instruction, and past the last.
+	uint32_t	start;
+	uint32_t	end;
+
+	// Offset of the last instruction.
+	uint32_t	last;
+
+	// Ranges in the graph's edge tables.
+	uint32_t	first_successor;
+	uint32_t	successor_count;
+	uint32_t	first_predecessor;
+	uint32_t	predecessor_count;
+};
+
+/**
+ * @class ControlFlowGraph
+ * @brief The basic blocks of a method, and the edges between them.
+ *
+ * Blocks and edges are stored in flat tables, with each block's edges
+ * in one contiguous range, so building a graph allocates nothing per
+ * block. A graph may be rebuilt for another method, reusing its tables.
+ *
+ * Blocks start at offset 0, at branch, switch and handler targets, after
+ * instructions that do not fall through, and at the bounds of protected
+ * ranges, so each block is either entirely in or out of each range.
+ * Exception edges run from every block in a protected range to its
+ * handler. Subroutine returns (ret) have no successors.
+ **/
+class ControlFlowGraph {
+private:
+	std::vector<BasicBlock> blocks;
+	std::vector<ControlFlowEdge> successors;
+	std::vector<ControlFlowEdge> predecessors;
+
+	// Scratch tables, indexed by offset.
+	std::vector<uint8_t> marks;
+	std::vector<uint32_t> block_at;
+
+public:
+	/**
+	 * @brief Constructs an empty graph.
+	 **/
+	ControlFlowGraph();
+
+	/**
+	 * @brief Constructs the graph of a method.
+	 *
+	 * @param code The Code attribute of the method.
+	 * @param classFile The class, to load lazily decoded code; may be NULL.
+	 **/
+	ControlFlowGraph(CodeAttribute *code, ClassFile *classFile = NULL);
+
+public:
+	/**
+	 * @brief Rebuilds the graph for the given method.
+	 *
+	 * Malformed code, or protected ranges not on instruction boundaries,
+	 * raise a DecodeError.
+	 *
+	 * @param code The Code attribute of the method.
+	 * @param classFile The class, to load lazily decoded code; may be NULL.
+	 **/
+	void Build(CodeAttribute *code, ClassFile *classFile = NULL);
+
+	/**
+	 * @brief Rebuilds the graph for raw bytecode.
+	 *
+	 * @param code The bytecode of the method.
+	 * @param length The length of the bytecode.
+	 * @param exception_table The method's exception table.
+	 **/
+	void Build(const uint8_t *code, uint32_t length,
+			const std::vector<ExceptionTableEntry *> &exception_table);
+
+	inline
+	uint32_t BlockCount() const {
+		return blocks.size();
+	}
+
+	inline
+	const BasicBlock &Block(uint32_t block) const {
+		return blocks[block];
+	}
+
+	inline
+	const ControlFlowEdge *Successors(uint32_t block) const {
+		return successors.data() + blocks[block].first_successor;
+	}
+
+	inline
+	const ControlFlowEdge *Predecessors(uint32_t block) const {
+		return predecessors.data() + blocks[block].first_predecessor;
+	}
+
+	/**
+	 * @brief Finds the block containing an offset.
+	 *
+	 * @param pc An offset in the method's code.
+	 * @return The index of the block, or BlockCount() if out of range.
+	 **/
+	uint32_t BlockAt(uint32_t pc) const;
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* ControlFlowGraph.h */
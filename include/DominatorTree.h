@@ -0,0 +1,120 @@
+/**
+ * @file DominatorTree.h
+ *
+ * @brief Defines dominator trees over control flow graphs.
+ **/
+# ifndef __DOMINATORTREE_H__
+# define __DOMINATORTREE_H__
+
+# include <vector>
+# include <stdint.h>
+
+# include "ControlFlowGraph.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+/**
+ * @class DominatorTree
+ * @brief The immediate dominators of the blocks of a control flow graph.
+ *
+ * Computed with the iterative algorithm of Cooper, Harvey and Kennedy
+ * over a reverse postorder of the graph, treating exception edges like
+ * any other. Blocks unreachable from the entry block have no dominators.
+ * The tree is then numbered in preorder, so dominance queries take
+ * constant time.
+ **/
+class DominatorTree {
+public:
+	// Marks a missing block.
+	static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+private:
+	std::vector<uint32_t> idom;
+
+	// Reverse postorder of the reachable blocks, and each block's position.
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> position;
+
+	// Preorder number of each block in the tree, and the size of its subtree.
+	std::vector<uint32_t> preorder;
+	std::vector<uint32_t> subtree;
+
+	// Scratch tables.
+	std::vector<uint32_t> stack;
+	std::vector<uint32_t> children;
+
+public:
+	/**
+	 * @brief Constructs an empty tree.
+	 **/
+	DominatorTree();
+
+	/**
+	 * @brief Constructs the dominator tree of a graph.
+	 **/
+	DominatorTree(const ControlFlowGraph &graph);
+
+public:
+	/**
+	 * @brief Rebuilds the tree for the given graph, reusing storage.
+	 **/
+	void Build(const ControlFlowGraph &graph);
+
+	inline
+	bool IsReachable(uint32_t block) const {
+		return position[block] != NONE;
+	}
+
+	/**
+	 * @brief Returns a block's immediate dominator.
+	 *
+	 * @return The dominator, or NONE for the entry and unreachable blocks.
+	 **/
+	inline
+	uint32_t ImmediateDominator(uint32_t block) const {
+		return idom[block];
+	}
+
+	/**
+	 * @brief Checks whether every path from the entry to one block passes
+	 * through another. Blocks dominate themselves.
+	 *
+	 * @param dominator The dominating block.
+	 * @param block The dominated block.
+	 **/
+	inline
+	bool Dominates(uint32_t dominator, uint32_t block) const {
+		return IsReachable(dominator) && IsReachable(block)
+			&& preorder[block] - preorder[dominator] < subtree[dominator];
+	}
+
+	/**
+	 * @brief Returns the reachable blocks in reverse postorder.
+	 **/
+	inline
+	const std::vector<uint32_t> &ReversePostorder() const {
+		return order;
+	}
+
+	/**
+	 * @brief Returns a block's index in the reverse postorder.
+	 *
+	 * @return The index, or NONE for unreachable blocks.
+	 **/
+	inline
+	uint32_t PostorderPosition(uint32_t block) const {
+		return position[block];
+	}
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* DominatorTree.h */
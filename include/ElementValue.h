@@ -12,6 +12,7 @@
 # include <vector>
 
 # include "ClassFile.h"
+# include "Arena.h"
 # include "ClassBuffer.h"
 # include "ClassBuilder.h"
 # include "ConstantInfo.h"
@@ -20,7 +21,8 @@ namespace JBC {
 
 struct AnnotationEntry;
 
-struct ElementValue {
+struct ElementValue
+		: public ArenaObject {
 	uint8_t		tag;
 
 	ElementValue()
@@ -40,6 +42,12 @@ struct ElementValue {
 
 	virtual
 	ElementValue *EncodeValue(ClassBuilder *builder, ClassFile *classFile) = 0;
+
+	/**
+	 * @brief Computes the encoded size of the value, including its tag.
+	 **/
+	virtual
+	uint32_t ComputeSize() = 0;
 };
 
 struct ConstantElementValue
@@ -58,6 +66,11 @@ struct ConstantElementValue
 	ConstantElementValue *DecodeValue(ClassBuffer *buffer, ClassFile *classFile);
 
 	ConstantElementValue *EncodeValue(ClassBuilder *builder, ClassFile *classFile);
+
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
 };
 
 struct EnumConstantElementValue
@@ -79,6 +92,11 @@ struct EnumConstantElementValue
 	EnumConstantElementValue *DecodeValue(ClassBuffer *buffer, ClassFile *classFile);
 
 	EnumConstantElementValue *EncodeValue(ClassBuilder *builder, ClassFile *classFile);
+
+	inline
+	uint32_t ComputeSize() {
+		return 5;
+	}
 };
 
 struct ClassElementValue
@@ -97,6 +115,11 @@ struct ClassElementValue
 	ClassElementValue *DecodeValue(ClassBuffer *buffer, ClassFile *classFile);
 
 	ClassElementValue *EncodeValue(ClassBuilder *builder, ClassFile *classFile);
+
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
 };
 
 struct AnnotationElementValue
@@ -117,6 +140,8 @@ struct AnnotationElementValue
 	AnnotationElementValue *DecodeValue(ClassBuffer *buffer, ClassFile *classFile);
 
 	AnnotationElementValue *EncodeValue(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
 struct ArrayElementValue
@@ -136,9 +161,12 @@ struct ArrayElementValue
 	ArrayElementValue *DecodeValue(ClassBuffer *buffer, ClassFile *classFile);
 
 	ArrayElementValue *EncodeValue(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
-struct ElementValuePairsEntry {
+struct ElementValuePairsEntry
+		: public ArenaObject {
 	// Name
 	ConstantUtf8Info *element_name;
 
@@ -154,9 +182,12 @@ struct ElementValuePairsEntry {
 	ElementValuePairsEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	ElementValuePairsEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
-struct AnnotationEntry {
+struct AnnotationEntry
+		: public ArenaObject {
 	// Type
 	ConstantUtf8Info *type;
 
@@ -172,6 +203,8 @@ struct AnnotationEntry {
 	AnnotationEntry *DecodeEntry(ClassBuffer *buffer, ClassFile *classFile);
 
 	AnnotationEntry *EncodeEntry(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
 ElementValue *DecodeElementValue(ClassBuffer *buffer, ClassFile *classFile);
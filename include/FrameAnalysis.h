@@ -0,0 +1,108 @@
+/**
+ * @file FrameAnalysis.h
+ *
+ * @brief Defines computation of stack map frames from method code.
+ **/
+# ifndef __FRAMEANALYSIS_H__
+# define __FRAMEANALYSIS_H__
+
+# include <string>
+# include <string_view>
+# include <unordered_map>
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassFile;
+class MemberInfo;
+
+/**
+ * @class ClassHierarchy
+ * @brief Answers class hierarchy queries while computing frames.
+ *
+ * Merging two object types in a frame needs their closest common
+ * superclass. The base resolver knows no classes, and answers
+ * java/lang/Object for any two different classes; override it to
+ * consult a class path, or use ClassSetHierarchy.
+ **/
+class ClassHierarchy {
+public:
+	virtual
+	~ClassHierarchy();
+
+	/**
+	 * @brief Returns the closest common superclass of two classes.
+	 *
+	 * Interfaces are treated as java/lang/Object, as by the verifier.
+	 *
+	 * @param first The internal name of a class, such as java/lang/String.
+	 * @param second The internal name of a different class.
+	 * @return The internal name of the common superclass.
+	 **/
+	virtual
+	std::string CommonSuperclass(std::string_view first, std::string_view second);
+};
+
+/**
+ * @class ClassSetHierarchy
+ * @brief Resolves the hierarchy from a known set of classes.
+ *
+ * Superclass chains are followed through the added classes; classes
+ * not added are taken to extend java/lang/Object directly.
+ **/
+class ClassSetHierarchy
+		: public ClassHierarchy {
+private:
+	// Superclass of each known class.
+	std::unordered_map<std::string, std::string> supers;
+
+public:
+	/**
+	 * @brief Adds a class, and its superclass, to the set.
+	 **/
+	void AddClass(ClassFile *classFile);
+
+	/**
+	 * @brief Adds a class to the set by name.
+	 *
+	 * @param name The internal name of the class.
+	 * @param super The internal name of its superclass.
+	 **/
+	void AddClass(std::string_view name, std::string_view super);
+
+	std::string CommonSuperclass(std::string_view first, std::string_view second);
+};
+
+/**
+ * @brief Recomputes the StackMapTable of a method.
+ *
+ * Infers the types of locals and stack slots at every branch target,
+ * handler and instruction following an unconditional transfer, and
+ * encodes them as a new StackMapTable, choosing the smallest frame type
+ * for each from the previous frame. The method's max_stack and
+ * max_locals must be correct, as by UpdateCodeLimits().
+ *
+ * Unreachable code is replaced with nop instructions ending in athrow,
+ * and removed from exception ranges, as the verifier cannot type it.
+ * Code using subroutines (jsr and ret) cannot be described by stack map
+ * frames; such methods are left as they are in classes before version
+ * 51, which may still use them, and raise an EncodeError otherwise.
+ *
+ * @param method The method to compute frames for.
+ * @param classFile The class the method belongs to.
+ * @param hierarchy The resolver for common superclasses; NULL for the base resolver.
+ **/
+void ComputeStackMapFrames(MemberInfo *method, ClassFile *classFile,
+		ClassHierarchy *hierarchy = NULL);
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* FrameAnalysis.h */
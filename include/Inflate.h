@@ -0,0 +1,47 @@
+/**
+ * @file Inflate.h
+ *
+ * @brief Defines decompression of deflate streams, as used by jar files.
+ **/
+# ifndef __INFLATE_H__
+# define __INFLATE_H__
+
+# include <stddef.h>
+# include <stdint.h>
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+/**
+ * @brief Decompresses a raw deflate stream into a buffer.
+ *
+ * The whole stream is decoded in one call, as the decompressed size of
+ * jar entries is known up front. Malformed streams, and streams that
+ * decompress to more than the buffer holds, raise a DecodeError.
+ *
+ * @param src The compressed data.
+ * @param src_size The length of the compressed data.
+ * @param dst The buffer to decompress into.
+ * @param dst_size The length of the buffer.
+ * @return The number of bytes decompressed.
+ **/
+size_t Inflate(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size);
+
+/**
+ * @brief Computes the CRC-32 checksum used by zip archives.
+ *
+ * @param data The data to checksum.
+ * @param size The length of the data.
+ **/
+uint32_t Crc32(const uint8_t *data, size_t size);
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* Inflate.h */
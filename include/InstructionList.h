@@ -0,0 +1,301 @@
+/**
+ * @file InstructionList.h
+ *
+ * @brief Defines an editable representation of method bytecode.
+ **/
+# ifndef __INSTRUCTIONLIST_H__
+# define __INSTRUCTIONLIST_H__
+
+# include <vector>
+# include <stdint.h>
+
+# include "Arena.h"
+# include "Bytecode.h"
+# include "ClassBuilder.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassFile;
+struct CodeAttribute;
+struct StackMapTableAttribute;
+struct ExceptionTableEntry;
+struct VariableInfo;
+struct UninitializedVariableInfo;
+
+/**
+ * @enum CodeNodeKind
+ * @brief The types of node in an instruction list.
+ **/
+enum CodeNodeKind {
+	NODE_LABEL,			/**< A position in the code, referenced by branches and tables.	*/
+	NODE_INSTRUCTION	/**< A single instruction.										*/
+};
+
+/**
+ * @struct CodeNode
+ * @brief An instruction or label in an InstructionList.
+ *
+ * Instructions are stored by operand value rather than encoding; wide
+ * prefixes, ldc_w and wide branches are chosen when the list is linked.
+ * Nodes are allocated by, and live as long as, their list.
+ **/
+struct CodeNode {
+	CodeNode	*prev;
+	CodeNode	*next;
+
+	uint8_t		kind;
+	uint8_t		opcode;
+
+	// Whether the node is in the list.
+	bool		attached;
+
+	// Whether a branch needs a four byte offset.
+	bool		widened;
+
+	// Offset assigned when linked.
+	uint32_t	pc;
+
+	// Local variable or constant pool index.
+	uint16_t	index;
+
+	// Immediate operand, as in Instruction.
+	int32_t		value;
+
+	// Branch target, or default switch target.
+	CodeNode	*target;
+
+	// Switch Tables
+	int32_t		low;
+	uint32_t	count;
+	int32_t		*keys;
+	CodeNode	**targets;
+
+	inline
+	bool IsLabel() const {
+		return kind == NODE_LABEL;
+	}
+
+	inline
+	const OpcodeInfo &Info() const {
+		return opcode_table[opcode];
+	}
+};
+
+/**
+ * @class InstructionList
+ * @brief A linked list of instructions and labels for a method's code.
+ *
+ * Decoding a CodeAttribute places labels at every branch target, and at
+ * every offset referenced by the exception table, line number, local
+ * variable and stack map tables. Instructions can then be inserted and
+ * removed in constant time, and Link() re-encodes the code in linear
+ * time, widening branches that no longer reach their targets, and
+ * rewriting the tables in terms of the labels.
+ *
+ * Attributes of types not listed above are not updated, and max_stack
+ * and max_locals are left unchanged.
+ **/
+class InstructionList {
+private:
+	// Tracks a table field holding an offset.
+	struct OffsetFixup {
+		uint16_t	*field;
+		CodeNode	*label;
+	};
+
+	// Tracks a table field holding the length of a range.
+	struct LengthFixup {
+		uint16_t	*field;
+		CodeNode	*start;
+		CodeNode	*end;
+	};
+
+	// Tracks the offset of a stack map frame.
+	struct FrameFixup {
+		size_t		frame;
+		CodeNode	*label;
+	};
+
+	// Tracks the offset of the instruction creating an uninitialized value.
+	struct UninitializedFixup {
+		UninitializedVariableInfo *info;
+		CodeNode	*node;
+	};
+
+	Arena		arena;
+
+	CodeNode	*head;
+	CodeNode	*tail;
+
+	CodeAttribute *code;
+	ClassFile	*classFile;
+
+	// Nodes at original offsets.
+	std::vector<CodeNode *> labels;
+	std::vector<CodeNode *> instructions;
+
+	std::vector<OffsetFixup> offsets;
+	std::vector<LengthFixup> lengths;
+	std::vector<FrameFixup> frames;
+	std::vector<UninitializedFixup> uninitialized;
+
+	StackMapTableAttribute *stack_map;
+
+	// Handlers added since the last link.
+	std::vector<ExceptionTableEntry *> handlers;
+
+	// Nodes are owned by the list's arena.
+	InstructionList(const InstructionList &) = delete;
+	InstructionList &operator=(const InstructionList &) = delete;
+
+public:
+	/**
+	 * @brief Decodes a method's code into an instruction list.
+	 *
+	 * Lazily decoded code is loaded first. Malformed code, or tables
+	 * referencing offsets between instructions, raise a DecodeError.
+	 *
+	 * @param code The Code attribute to edit.
+	 * @param classFile The class the attribute belongs to.
+	 **/
+	InstructionList(CodeAttribute *code, ClassFile *classFile);
+
+public:
+	inline
+	CodeNode *First() {
+		return head;
+	}
+
+	inline
+	CodeNode *Last() {
+		return tail;
+	}
+
+	/**
+	 * @brief Returns the label at an offset in the original code.
+	 *
+	 * @param pc An instruction offset, or the code length.
+	 * @return The label placed before the instruction at the offset.
+	 **/
+	CodeNode *LabelAt(uint32_t pc);
+
+	/**
+	 * @brief Creates a new, unattached label.
+	 **/
+	CodeNode *NewLabel();
+
+	/**
+	 * @brief Creates a new, unattached instruction.
+	 *
+	 * Branches and switches need targets, so raise a JBCError; they are
+	 * created with NewBranch(), NewTableSwitch() and NewLookupSwitch().
+	 *
+	 * @param opcode The instruction's opcode.
+	 * @param index The local variable or constant index, if any.
+	 * @param value The immediate operand, if any.
+	 **/
+	CodeNode *NewInstruction(uint8_t opcode, uint16_t index = 0, int32_t value = 0);
+
+	/**
+	 * @brief Creates a new, unattached branch instruction.
+	 *
+	 * @param opcode The instruction's opcode.
+	 * @param target The label to branch to.
+	 **/
+	CodeNode *NewBranch(uint8_t opcode, CodeNode *target);
+
+	/**
+	 * @brief Creates a new, unattached tableswitch instruction.
+	 *
+	 * @param low The key of the first case.
+	 * @param count The number of cases.
+	 * @param targets The label for each case.
+	 * @param fallback The label for keys without a case.
+	 **/
+	CodeNode *NewTableSwitch(int32_t low, uint32_t count,
+			CodeNode **targets, CodeNode *fallback);
+
+	/**
+	 * @brief Creates a new, unattached lookupswitch instruction.
+	 *
+	 * @param count The number of cases.
+	 * @param keys The key of each case, in ascending order.
+	 * @param targets The label for each case.
+	 * @param fallback The label for keys without a case.
+	 **/
+	CodeNode *NewLookupSwitch(uint32_t count, int32_t *keys,
+			CodeNode **targets, CodeNode *fallback);
+
+	CodeNode *InsertBefore(CodeNode *position, CodeNode *node);
+	CodeNode *InsertAfter(CodeNode *position, CodeNode *node);
+	CodeNode *Append(CodeNode *node);
+
+	/**
+	 * @brief Removes a node from the list.
+	 *
+	 * Removed labels must no longer be referenced when linking.
+	 **/
+	CodeNode *Remove(CodeNode *node);
+
+	/**
+	 * @brief Adds an entry to the exception table.
+	 *
+	 * @param start The label starting the protected range.
+	 * @param end The label ending the protected range, exclusive.
+	 * @param handler The label starting the handler.
+	 * @param catch_type The caught class constant index, or 0 for all.
+	 **/
+	ExceptionTableEntry *AddExceptionHandler(CodeNode *start, CodeNode *end,
+			CodeNode *handler, uint16_t catch_type);
+
+	/**
+	 * @brief Encodes the list back into its Code attribute.
+	 *
+	 * Updates the code, and the offsets in the exception table, line
+	 * number, local variable and stack map tables, and marks them as
+	 * modified. Raises an EncodeError if the code is too long, or a
+	 * referenced node is not in the list, leaving the attribute as is.
+	 *
+	 * Branches that no longer reach their targets are widened. A widened
+	 * conditional becomes the inverted branch around a goto_w, and the
+	 * instruction after the goto_w is then a branch target without a
+	 * stack map frame. If that happens in a class from version 50, its
+	 * frames must be recomputed before encoding, by setting
+	 * COMPUTE_FRAMES on the class or calling ComputeStackMapFrames().
+	 *
+	 * Stack map frames left at the same offset by removed code are
+	 * merged, keeping the last. It is rewritten as a full frame when the
+	 * frames dropped before it changed the locals.
+	 *
+	 * @return The new code length.
+	 **/
+	uint32_t Link();
+
+private:
+	CodeNode *NewNode(uint8_t kind);
+	CodeNode *NewOpcode(uint8_t opcode);
+
+	uint32_t SizeAt(CodeNode *node, uint32_t pc);
+	uint32_t Layout();
+	void Emit(CodeNode *node, ClassBuilder *builder);
+
+	void Decode();
+	void DecodeTables();
+
+	void InitialLocals(std::vector<VariableInfo *> &locals);
+	VariableInfo *CopyInfo(VariableInfo *info);
+	void MergeFrames(std::vector<VariableInfo *> &initial, bool rebase);
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* InstructionList.h */
@@ -0,0 +1,158 @@
+/**
+ * @file JarFile.h
+ *
+ * @brief Defines reading of class files out of jar and zip archives.
+ **/
+# ifndef __JARFILE_H__
+# define __JARFILE_H__
+
+# include <vector>
+# include <stdint.h>
+# include <string_view>
+
+# include "ClassFile.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassBatch;
+class MappedFile;
+
+/**
+ * @brief Compression methods supported in jar entries.
+ **/
+enum JarMethod {
+	JAR_STORED		= 0,	/**< Stored without compression.	*/
+	JAR_DEFLATED	= 8		/**< Compressed with deflate.		*/
+};
+
+/**
+ * @struct JarEntry
+ * @brief An entry of a jar's central directory.
+ **/
+struct JarEntry {
+	// Points into the mapped archive.
+	std::string_view name;
+
+	uint16_t	flags;
+	uint16_t	method;
+	uint32_t	crc32;
+
+	uint64_t	compressed_size;
+	uint64_t	size;
+
+	// Offset of the local header.
+	uint64_t	offset;
+};
+
+/**
+ * @class JarFile
+ * @brief A read-only view of a jar or zip archive.
+ *
+ * The archive is memory mapped, and its central directory is read up
+ * front; entries are located and decompressed on demand. Stored and
+ * deflated entries are supported, including ZIP64 archives. Reading
+ * entries does not modify the JarFile, so a jar may be read by many
+ * threads at once, each with its own buffer.
+ *
+ * @code
+ * JarFile jar("rt.jar");
+ * ClassBatch *batch = DecodeJarFile(&jar, NULL, 0);
+ * @endcode
+ **/
+class JarFile {
+private:
+	MappedFile *mapping;
+	std::vector<JarEntry> entries;
+
+public:
+	/**
+	 * @brief Maps an archive, and reads its central directory.
+	 *
+	 * Raises a DecodeError if the file is not a valid archive.
+	 *
+	 * @param path The path to the archive.
+	 **/
+	JarFile(const char *path);
+	~JarFile();
+
+private:
+	JarFile(const JarFile &);
+	JarFile &operator=(const JarFile &);
+
+public:
+	/**
+	 * @brief Returns the number of entries in the archive.
+	 **/
+	inline
+	size_t EntryCount() const {
+		return entries.size();
+	}
+
+	/**
+	 * @brief Returns an entry, in central directory order.
+	 **/
+	inline
+	const JarEntry &Entry(size_t idx) const {
+		return entries[idx];
+	}
+
+	/**
+	 * @brief Finds an entry by name.
+	 *
+	 * @return The entry, or NULL if there is none.
+	 **/
+	const JarEntry *Find(std::string_view name) const;
+
+	/**
+	 * @brief Selects the class file entries of the archive.
+	 *
+	 * @param filter Selects entries by name; NULL for all class files.
+	 * @return The entries whose names end in .class, and pass the filter.
+	 **/
+	std::vector<const JarEntry *> Select(bool (*filter)(std::string_view name) = NULL) const;
+
+	/**
+	 * @brief Reads the contents of an entry.
+	 *
+	 * Stored entries are returned in place; deflated entries are
+	 * decompressed into the buffer, and their checksum verified.
+	 * Malformed entries raise a DecodeError.
+	 *
+	 * @param entry An entry of this archive.
+	 * @param buffer Receives decompressed contents; reused between calls.
+	 * @return The contents of the entry, entry.size bytes long.
+	 **/
+	const uint8_t *Read(const JarEntry &entry, std::vector<uint8_t> &buffer) const;
+
+private:
+	void ReadDirectory();
+};
+
+/**
+ * @brief Decodes the class files of a jar.
+ *
+ * Entries are read out of the mapped archive into per-worker buffers,
+ * and decoded as by DecodeClassFiles(), so a failing entry records an
+ * error in its place. The batch names each class by its entry name.
+ *
+ * @param jar The archive to decode from.
+ * @param filter Selects entries by name; NULL for all class files.
+ * @param threads The number of workers; 0 for one per core.
+ * @param options The settings to decode with. The arena is ignored.
+ * @return The decoded classes, in central directory order.
+ **/
+ClassBatch *DecodeJarFile(JarFile *jar, bool (*filter)(std::string_view name) = NULL,
+		unsigned threads = 1, const DecodeOptions &options = DecodeOptions());
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* JarFile.h */
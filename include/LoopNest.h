@@ -0,0 +1,146 @@
+/**
+ * @file LoopNest.h
+ *
+ * @brief Defines natural loop detection over method bytecode.
+ **/
+# ifndef __LOOPNEST_H__
+# define __LOOPNEST_H__
+
+# include <vector>
+# include <stdint.h>
+
+# include "ControlFlowGraph.h"
+# include "DominatorTree.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+/**
+ * @struct Loop
+ * @brief A natural loop, identified by its header block.
+ **/
+struct Loop {
+	uint32_t	header;
+
+	// The enclosing loop, or LoopNest::NONE.
+	uint32_t	parent;
+
+	// Outermost loops have depth 1.
+	uint32_t	depth;
+
+	// Whether no other loop is nested inside this one.
+	bool		innermost;
+};
+
+/**
+ * @class LoopNest
+ * @brief The forest of natural loops in a method.
+ *
+ * A back edge is an edge whose target dominates its source; the loop of
+ * a header holds the header and every block reaching one of its back
+ * edges without passing through it. Back edges sharing a header form a
+ * single loop. Cycles entered at more than one block (irreducible flow,
+ * which javac does not produce) are not reported as loops.
+ *
+ * Loops are numbered innermost first, so a loop's parent always has a
+ * higher index.
+ **/
+class LoopNest {
+public:
+	// Marks a missing loop.
+	static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+private:
+	ControlFlowGraph graph;
+	DominatorTree dominators;
+
+	std::vector<Loop> loops;
+
+	// The innermost loop containing each block.
+	std::vector<uint32_t> block_loop;
+
+	// Scratch table.
+	std::vector<uint32_t> worklist;
+
+public:
+	/**
+	 * @brief Constructs an empty loop nest.
+	 **/
+	LoopNest();
+
+	/**
+	 * @brief Finds the loops in a method.
+	 *
+	 * @param code The Code attribute of the method.
+	 * @param classFile The class, to load lazily decoded code; may be NULL.
+	 **/
+	LoopNest(CodeAttribute *code, ClassFile *classFile = NULL);
+
+public:
+	/**
+	 * @brief Rebuilds the loop nest for another method, reusing storage.
+	 **/
+	void Build(CodeAttribute *code, ClassFile *classFile = NULL);
+
+	inline
+	const ControlFlowGraph &Graph() const {
+		return graph;
+	}
+
+	inline
+	const DominatorTree &Dominators() const {
+		return dominators;
+	}
+
+	inline
+	uint32_t LoopCount() const {
+		return loops.size();
+	}
+
+	inline
+	const Loop &GetLoop(uint32_t loop) const {
+		return loops[loop];
+	}
+
+	/**
+	 * @brief Returns the innermost loop containing a block, or NONE.
+	 **/
+	inline
+	uint32_t LoopOf(uint32_t block) const {
+		return block_loop[block];
+	}
+
+	/**
+	 * @brief Returns the number of loops containing a block.
+	 **/
+	inline
+	uint32_t BlockDepth(uint32_t block) const {
+		return block_loop[block] == NONE ? 0 : loops[block_loop[block]].depth;
+	}
+
+	/**
+	 * @brief Returns the number of loops containing an instruction.
+	 *
+	 * @param pc The offset of the instruction.
+	 **/
+	uint32_t DepthAt(uint32_t pc) const;
+
+	/**
+	 * @brief Checks whether an edge closes a loop.
+	 **/
+	inline
+	bool IsBackEdge(uint32_t from, uint32_t to) const {
+		return dominators.Dominates(to, from);
+	}
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* LoopNest.h */
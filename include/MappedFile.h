@@ -0,0 +1,55 @@
+/**
+ * @file MappedFile.h
+ *
+ * @brief Defines read-only memory mapping of input files.
+ **/
+# ifndef __MAPPEDFILE_H__
+# define __MAPPEDFILE_H__
+
+# include <stdint.h>
+# include <stddef.h>
+
+# include "ClassBuffer.h"
+
+namespace JBC {
+
+/**
+ * @class MappedFile
+ * @brief A read-only memory mapping of a file.
+ *
+ * The mapping remains valid for the lifetime of the object, and
+ * is released by its destructor.
+ **/
+class MappedFile {
+private:
+	uint8_t *data;
+	size_t size;
+
+public:
+	/**
+	 * @brief Maps a file into memory, read-only.
+	 *
+	 * @param path The path to the file to be mapped.
+	 **/
+	MappedFile(const char *path);
+	~MappedFile();
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+public:
+	inline
+	const uint8_t *Data() {
+		return data;
+	}
+
+	inline
+	size_t Size() {
+		return size;
+	}
+};
+
+} /* JBC */
+
+# endif /* MappedFile.h */
@@ -0,0 +1,93 @@
+/**
+ * @file MemberIndex.h
+ *
+ * @brief Defines the hash index over class member tables.
+ **/
+# ifndef __MEMBERINDEX_H__
+# define __MEMBERINDEX_H__
+
+# include <vector>
+# include <stddef.h>
+# include <string_view>
+# include <unordered_map>
+
+namespace JBC {
+
+class MemberInfo;
+
+/**
+ * @class MemberIndex
+ * @brief A hash index over a table of class members.
+ *
+ * Members are indexed by name, and by name and descriptor together.
+ * The index only stores hashes and table positions, and every hit is
+ * checked against the member itself, so it never references member
+ * names directly. It is built on first lookup, extended as members are
+ * appended, and rebuilt if the table changes size. Members that are
+ * renamed, or tables reordered in place, require an Invalidate().
+ **/
+class MemberIndex {
+private:
+	typedef std::unordered_multimap<size_t, size_t> Table;
+
+	// Hashes to table positions.
+	Table names;
+	Table signatures;
+
+	// Number of table entries indexed.
+	size_t count;
+	bool valid;
+
+public:
+	inline
+	MemberIndex()
+		: count(0), valid(false) {
+	}
+
+public:
+	/**
+	 * @brief Discards the index, to be rebuilt by the next lookup.
+	 **/
+	inline
+	void Invalidate() {
+		valid = false;
+	}
+
+	/**
+	 * @brief Records a member appended to the end of the table.
+	 *
+	 * Does nothing until the index is first built.
+	 *
+	 * @param members The indexed member table.
+	 **/
+	void Append(std::vector<MemberInfo *> &members);
+
+	/**
+	 * @brief Finds the first member with the given name.
+	 *
+	 * @param members The indexed member table.
+	 * @param name The name of the member.
+	 * @return The table entry for the member, or NULL.
+	 **/
+	MemberInfo **Find(std::vector<MemberInfo *> &members,
+			std::string_view name);
+
+	/**
+	 * @brief Finds the member with the given name and descriptor.
+	 *
+	 * @param members The indexed member table.
+	 * @param name The name of the member.
+	 * @param descriptor The descriptor of the member.
+	 * @return The table entry for the member, or NULL.
+	 **/
+	MemberInfo **Find(std::vector<MemberInfo *> &members,
+			std::string_view name, std::string_view descriptor);
+
+private:
+	void Insert(MemberInfo *member, size_t position);
+	void Rebuild(std::vector<MemberInfo *> &members);
+};
+
+} /* JBC */
+
+# endif /* MemberIndex.h */
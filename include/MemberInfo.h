@@ -12,6 +12,7 @@
 # include <vector>
 # include <stdint.h>
 
+# include "Arena.h"
 # include "ClassBuffer.h"
 # include "ClassBuilder.h"
 
@@ -26,6 +27,7 @@ namespace JBC {
 // Forward Declarations.
 class ClassFile;
 struct AttributeInfo;
+struct CodeAttribute;
 
 /* Access Flags */
 
@@ -68,7 +70,8 @@ enum MemberFlags {
  * @brief An object representation of Java class members,
  *			such as methods or fields.
  **/
-class MemberInfo {
+class MemberInfo
+		: public ArenaObject {
 public:
 	/**
 	 * @brief Access permissions and property flags.
@@ -96,6 +99,17 @@ public:
 	 **/
 	std::vector<AttributeInfo *> attributes;
 
+	// Source
+	/**
+	 * @brief The encoded member in the decoding source, or NULL.
+	 *
+	 * Only recorded for persistent sources decoded with copy_unmodified
+	 * set. While the member and its attributes are unmodified, it is
+	 * encoded by copying these bytes.
+	 **/
+	const uint8_t *source;
+	uint32_t	source_length;
+
 public:
 	/**
 	 * @brief Constructor for MemverInfo.
@@ -142,7 +156,7 @@ public:
 	 **/
 	std::string Name() {
 		if(name == NULL) return NULL;
-		return reinterpret_cast<char *>(name->bytes);
+		return std::string(reinterpret_cast<char *>(name->bytes), name->length);
 	}
 
 	/**
@@ -152,7 +166,8 @@ public:
 	 **/
 	std::string Descriptor() {
 		if(descriptor == NULL) return NULL;
-		return reinterpret_cast<char *>(descriptor->bytes);
+		return std::string(reinterpret_cast<char *>(descriptor->bytes),
+				descriptor->length);
 	}
 
 public:
@@ -326,9 +341,38 @@ public:
 		return GetFlag(METHOD_STRICT);
 	}
 
+	/**
+	 * @brief Returns this method's Code attribute.
+	 *
+	 * @return The attribute, or NULL for abstract and native methods.
+	 **/
+	CodeAttribute *GetCode();
+
+public:
+	/**
+	 * @brief Checks if this member must be encoded field by field.
+	 *
+	 * Changes to the flags, name, descriptor or number of attributes
+	 * are detected, as are attributes marked dirty.
+	 **/
+	bool IsDirty();
+
+	/**
+	 * @brief Marks this member as modified since decoding.
+	 **/
+	inline
+	void MarkDirty() {
+		source = NULL;
+	}
+
 public:
 	MemberInfo *DecodeMember(ClassBuffer *buffer, ClassFile *classFile);
 	MemberInfo *EncodeMember(ClassBuilder *builder, ClassFile *classFile);
+
+	/**
+	 * @brief Computes the encoded size of this member, in bytes.
+	 **/
+	uint32_t ComputeSize();
 };
 
 } /* JBC */
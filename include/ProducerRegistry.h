@@ -0,0 +1,105 @@
+/**
+ * @file ProducerRegistry.h
+ *
+ * @brief Defines registries of producers for nonstandard types.
+ **/
+# ifndef __PRODUCERREGISTRY_H__
+# define __PRODUCERREGISTRY_H__
+
+# include <atomic>
+# include <string>
+# include <vector>
+# include <string_view>
+
+# include "ConstantInfo.h"
+# include "AttributeInfo.h"
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+/**
+ * @class ProducerRegistry
+ * @brief Maps nonstandard constant tags and attribute names to producers.
+ *
+ * Lookups never lock, so any number of decoding threads may share a
+ * registry. The registry is an immutable snapshot, and registering a
+ * producer publishes a modified copy with an atomic compare and swap.
+ * Replaced snapshots may still be in use by readers, so they are only
+ * released with the registry; producers are meant to be registered up
+ * front, not while decoding.
+ *
+ * The global registry, filled by RegisterProducer(), is consulted by
+ * every decode. A registry may also be given in DecodeOptions, to make
+ * producers visible to only those decodes; it is consulted first.
+ **/
+class ProducerRegistry {
+private:
+	struct Snapshot {
+		ConstantProducer constants[256];
+		std::vector<std::pair<std::string, AttributeProducer> > attributes;
+
+		// The snapshot this one replaced.
+		const Snapshot *previous;
+	};
+
+	std::atomic<const Snapshot *> current;
+
+public:
+	ProducerRegistry();
+	~ProducerRegistry();
+
+private:
+	ProducerRegistry(const ProducerRegistry &);
+	ProducerRegistry &operator=(const ProducerRegistry &);
+
+public:
+	/**
+	 * @brief Returns the registry used by all decodes.
+	 **/
+	static
+	ProducerRegistry &Global();
+
+	/**
+	 * @brief Hooks a producer for a nonstandard constant tag.
+	 *
+	 * @param tag The tag to register the producer with.
+	 * @param producer The producer, or NULL to unhook the tag.
+	 **/
+	void Register(uint8_t tag, ConstantProducer producer);
+
+	/**
+	 * @brief Hooks a producer for a nonstandard attribute name.
+	 *
+	 * @param name The attribute name to register the producer with.
+	 * @param producer The producer, or NULL to unhook the name.
+	 **/
+	void Register(std::string_view name, AttributeProducer producer);
+
+	/**
+	 * @brief Returns the producer for a constant tag, or NULL.
+	 **/
+	inline
+	ConstantProducer Find(uint8_t tag) const {
+		return current.load(std::memory_order_acquire)->constants[tag];
+	}
+
+	/**
+	 * @brief Returns the producer for an attribute name, or NULL.
+	 **/
+	AttributeProducer Find(std::string_view name) const;
+
+private:
+	template<typename Modify>
+	void Publish(Modify modify);
+};
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* ProducerRegistry.h */
@@ -0,0 +1,82 @@
+/**
+ * @file StackAnalysis.h
+ *
+ * @brief Defines computation of a method's operand stack and local sizes.
+ **/
+# ifndef __STACKANALYSIS_H__
+# define __STACKANALYSIS_H__
+
+# include <stdint.h>
+
+/**
+ * @addtogroup Bytecode
+ * @{
+ **/
+namespace JBC {
+
+// Forward Declarations.
+class ClassFile;
+class MemberInfo;
+struct CodeAttribute;
+struct ConstantInfo;
+struct ConstantUtf8Info;
+struct ConstantNameAndTypeInfo;
+
+/**
+ * @struct CodeLimits
+ * @brief The frame sizes a method's code needs.
+ **/
+struct CodeLimits {
+	uint16_t	max_stack;
+	uint16_t	max_locals;
+};
+
+/**
+ * @brief Counts the local variable slots taken by a method's arguments.
+ *
+ * @param descriptor The method descriptor.
+ * @param returns Receives the stack slots taken by the return value; may be NULL.
+ * @return The slots taken by the arguments, excluding any receiver.
+ **/
+uint32_t ArgumentSlots(ConstantUtf8Info *descriptor, uint32_t *returns = NULL);
+
+/**
+ * @brief Resolves the name and type of a member or call site reference.
+ *
+ * @param constant A field, method, interface method or invokedynamic constant.
+ * @param classFile The class the constant belongs to.
+ * @return The name and type, or NULL if the reference is invalid.
+ **/
+ConstantNameAndTypeInfo *ReferenceNameAndType(ConstantInfo *constant, ClassFile *classFile);
+
+/**
+ * @brief Computes the max_stack and max_locals a method's code needs.
+ *
+ * Stack depths are propagated once along each edge of the method's
+ * control flow graph, starting handlers with the exception on the stack,
+ * so the analysis is linear in the size of the code. Field and method
+ * descriptors are resolved through the constant pool. Stack underflow,
+ * or branches merging different stack depths, raise a DecodeError.
+ *
+ * @param method The method the code belongs to.
+ * @param code The method's Code attribute.
+ * @param classFile The class the method belongs to.
+ **/
+CodeLimits ComputeCodeLimits(MemberInfo *method, CodeAttribute *code, ClassFile *classFile);
+
+/**
+ * @brief Recomputes and stores max_stack and max_locals for a method.
+ *
+ * @param method The method to update.
+ * @param classFile The class the method belongs to.
+ * @return Whether either value changed. Methods without code return false.
+ **/
+bool UpdateCodeLimits(MemberInfo *method, ClassFile *classFile);
+
+} /* JBC */
+
+/**
+ * }@
+ **/
+
+# endif /* StackAnalysis.h */
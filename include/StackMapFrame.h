@@ -11,13 +11,31 @@
 
 # include <stdint.h>
 
+# include "Arena.h"
 # include "ClassBuffer.h"
 # include "ClassBuilder.h"
 # include "ConstantInfo.h"
 
 namespace JBC {
 
-struct VariableInfo {
+/**
+ * @enum VerificationType
+ * @brief The tags of verification types in stack map frames.
+ **/
+enum VerificationType {
+	ITEM_TOP				= 0,
+	ITEM_INTEGER			= 1,
+	ITEM_FLOAT				= 2,
+	ITEM_DOUBLE				= 3,
+	ITEM_LONG				= 4,
+	ITEM_NULL				= 5,
+	ITEM_UNINITIALIZED_THIS	= 6,
+	ITEM_OBJECT				= 7,
+	ITEM_UNINITIALIZED		= 8
+};
+
+struct VariableInfo
+		: public ArenaObject {
 	uint8_t		tag;
 
 	VariableInfo()
@@ -43,6 +61,14 @@ struct VariableInfo {
 		// Placeholder prototype for children.
 		return this;
 	}
+
+	/**
+	 * @brief Computes the encoded size of the info, including its tag.
+	 **/
+	virtual inline
+	uint32_t ComputeSize() {
+		return 1;
+	}
 };
 
 struct ObjectVariableInfo
@@ -60,6 +86,11 @@ struct ObjectVariableInfo
 	ObjectVariableInfo *DecodeInfo(ClassBuffer *buffer, ClassFile *classFile);
 
 	ObjectVariableInfo *EncodeInfo(ClassBuilder *builder, ClassFile *classFile);
+
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
 };
 
 struct UninitializedVariableInfo
@@ -77,13 +108,19 @@ struct UninitializedVariableInfo
 	UninitializedVariableInfo *DecodeInfo(ClassBuffer *buffer, ClassFile *classFile);
 
 	UninitializedVariableInfo *EncodeInfo(ClassBuilder *builder, ClassFile *classFile);
+
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
 };
 
 VariableInfo *DecodeVariableInfo(ClassBuffer *buffer, ClassFile *classFile);
 
 void EncodeVariableInfo(ClassBuilder *builder, ClassFile *classFile, VariableInfo *info);
 
-struct StackMapFrame {
+struct StackMapFrame
+		: public ArenaObject {
 	uint8_t		tag;
 
 	StackMapFrame()
@@ -106,6 +143,14 @@ struct StackMapFrame {
 	StackMapFrame *EncodeFrame(ClassBuilder *, ClassFile *) {
 		return this;
 	}
+
+	/**
+	 * @brief Computes the encoded size of the frame, including its tag.
+	 **/
+	virtual inline
+	uint32_t ComputeSize() {
+		return 1;
+	}
 };
 
 struct StackMapOffFrame
@@ -123,6 +168,11 @@ struct StackMapOffFrame
 	StackMapOffFrame *DecodeFrame(ClassBuffer *buffer, ClassFile *classFile);
 
 	StackMapOffFrame *EncodeFrame(ClassBuilder *builder, ClassFile *classFile);
+
+	inline
+	uint32_t ComputeSize() {
+		return 3;
+	}
 };
 
 struct StackMapItemFrame
@@ -143,6 +193,8 @@ struct StackMapItemFrame
 	StackMapItemFrame *DecodeFrame(ClassBuffer *buffer, ClassFile *classFile);
 
 	StackMapItemFrame *EncodeFrame(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
 struct StackMapExtFrame
@@ -165,6 +217,8 @@ struct StackMapExtFrame
 	StackMapExtFrame *DecodeFrame(ClassBuffer *buffer, ClassFile *classFile);
 
 	StackMapExtFrame *EncodeFrame(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
 struct StackMapListFrame
@@ -187,6 +241,8 @@ struct StackMapListFrame
 	StackMapListFrame *DecodeFrame(ClassBuffer *buffer, ClassFile *classFile);
 
 	StackMapListFrame *EncodeFrame(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
 struct StackMapFullFrame
@@ -212,12 +268,32 @@ struct StackMapFullFrame
 	StackMapFullFrame *DecodeFrame(ClassBuffer *buffer, ClassFile *classFile);
 
 	StackMapFullFrame *EncodeFrame(ClassBuilder *builder, ClassFile *classFile);
+
+	uint32_t ComputeSize();
 };
 
 StackMapFrame *DecodeStackMapFrame(ClassBuffer *buffer, ClassFile *classFile);
 
 void EncodeStackMapFrame(ClassBuilder *builder, ClassFile *classFile, StackMapFrame *frame);
 
+/**
+ * @brief Returns the offset delta encoded by a frame.
+ **/
+uint16_t GetFrameOffsetDelta(StackMapFrame *frame);
+
+/**
+ * @brief Changes the offset delta encoded by a frame.
+ *
+ * Frames that encode their delta in their tag are replaced with their
+ * extended forms if the delta no longer fits, in which case the old
+ * frame is deleted, and its verification types moved to the new one.
+ *
+ * @param frame The frame to modify.
+ * @param delta The new offset delta.
+ * @return The modified frame, or its replacement.
+ **/
+StackMapFrame *SetFrameOffsetDelta(StackMapFrame *frame, uint16_t delta);
+
 } /* JBC */
 
 # endif /* StackMapFrame.h */
@@ -13,5 +13,18 @@
 # include "MemberInfo.h"
 # include "ConstantInfo.h"
 # include "AttributeInfo.h"
+# include "Bytecode.h"
+# include "InstructionList.h"
+# include "ControlFlowGraph.h"
+# include "DominatorTree.h"
+# include "LoopNest.h"
+# include "StackAnalysis.h"
+# include "FrameAnalysis.h"
+# include "ClassVisitor.h"
+# include "ClassWriter.h"
+# include "BatchDecoder.h"
+# include "ProducerRegistry.h"
+# include "Inflate.h"
+# include "JarFile.h"
 
 # endif /* Types.h */
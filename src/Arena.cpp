@@ -0,0 +1,118 @@
+
+# include <new>
+# include <stdlib.h>
+
+# include "Arena.h"
+
+namespace JBC {
+
+static thread_local
+Arena *current_arena = NULL;
+
+Arena::Arena(size_t chunk_size)
+		: chunks(NULL), cursor(NULL), limit(NULL),
+		  chunk_size(chunk_size), allocated(0) {
+}
+
+Arena::~Arena() {
+	while(chunks != NULL) {
+		Chunk *next = chunks->next;
+		free(chunks);
+		chunks = next;
+	}
+}
+
+void *Arena::Refill(size_t size) {
+	size_t header, length;
+	Chunk *chunk;
+
+	header = (sizeof(Chunk) + (alignof(max_align_t) - 1))
+			& ~(alignof(max_align_t) - 1);
+
+	// Oversized blocks get a chunk of their own.
+	length = size > chunk_size / 4 ? size : chunk_size;
+	if((chunk = (Chunk *)malloc(header + length)) == NULL) {
+		throw std::bad_alloc();
+	}
+	chunk->size = length;
+	allocated += size;
+
+	if(length != chunk_size && chunks != NULL) {
+		// Keep bumping through the current chunk.
+		chunk->next = chunks->next;
+		chunks->next = chunk;
+		return (uint8_t *)chunk + header;
+	}
+
+	chunk->next = chunks;
+	chunks = chunk;
+
+	cursor = (uint8_t *)chunk + header + size;
+	limit = (uint8_t *)chunk + header + length;
+	return (uint8_t *)chunk + header;
+}
+
+void Arena::Reset() {
+	size_t header;
+
+	if(chunks == NULL) return;
+
+	while(chunks->next != NULL) {
+		Chunk *next = chunks->next->next;
+		free(chunks->next);
+		chunks->next = next;
+	}
+
+	header = (sizeof(Chunk) + (alignof(max_align_t) - 1))
+			& ~(alignof(max_align_t) - 1);
+
+	cursor = (uint8_t *)chunks + header;
+	limit = cursor + chunks->size;
+	allocated = 0;
+}
+
+Arena *Arena::Current() {
+	return current_arena;
+}
+
+Arena *Arena::Select(Arena *arena) {
+	Arena *saved = current_arena;
+	current_arena = arena;
+	return saved;
+}
+
+/* Arena Objects */
+
+// Prefixes every object, recording where it was allocated.
+union ObjectHeader {
+	Arena *arena;
+	max_align_t align;
+};
+
+void *ArenaObject::operator new(size_t size) {
+	Arena *arena = current_arena;
+	ObjectHeader *header;
+
+	if(arena != NULL) {
+		header = (ObjectHeader *)arena->Allocate(sizeof(ObjectHeader) + size);
+	} else if((header = (ObjectHeader *)malloc(sizeof(ObjectHeader) + size)) == NULL) {
+		throw std::bad_alloc();
+	}
+
+	header->arena = arena;
+	return header + 1;
+}
+
+void ArenaObject::operator delete(void *ptr) {
+	ObjectHeader *header;
+
+	if(ptr == NULL) return;
+	header = (ObjectHeader *)ptr - 1;
+
+	// Arena memory is reclaimed with the arena.
+	if(header->arena == NULL) {
+		free(header);
+	}
+}
+
+} /* JBC */
@@ -1,20 +1,17 @@
 
-# include <map>
 # include <string.h>
 
 # include "Debug.h"
 # include "ClassFile.h"
 # include "AttributeInfo.h"
+# include "ProducerRegistry.h"
 
 namespace JBC {
 
 /* Attribute Producers */
 
-static
-std::map<std::string, AttributeProducer> producer_map;
-
 void RegisterProducer(std::string name, AttributeProducer producer) {
-	producer_map[name] = producer;
+	ProducerRegistry::Global().Register(name, producer);
 }
 
 /* Attribute Decoders */
@@ -46,10 +43,49 @@ ExceptionTableEntry *ExceptionTableEntry
 
 CodeAttribute *CodeAttribute
 		::DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile) {
-	uint16_t length;
-
 	debug_printf(level3, "Decoding Code Attribute.\n");
 
+	if(classFile->options.lazy_code) {
+		if(buffer->IsPersistent()) {
+			// Reference the source until loaded.
+			raw = buffer->Borrow(attribute_length);
+			debug_printf(level3, "Deferred %u bytes of code.\n", attribute_length);
+			return this;
+		} else if(Arena *arena = Arena::Current()) {
+			uint8_t *copy = (uint8_t *)arena->Allocate(attribute_length);
+
+			buffer->Next(copy, attribute_length);
+			debug_printf(level3, "Deferred %u bytes of code.\n", attribute_length);
+			raw = copy;
+			return this;
+		}
+	}
+
+	DecodeContents(buffer, classFile);
+	return this;
+}
+
+CodeAttribute *CodeAttribute::Load(ClassFile *classFile) {
+	if(raw == NULL) return this;
+
+	debug_printf(level3, "Loading Code Attribute.\n");
+	ArenaScope scope(classFile->arena);
+
+	// Raw bytes live as long as the class.
+	ClassBuffer buffer(raw, attribute_length, true);
+	DecodeContents(&buffer, classFile);
+
+	if(buffer.Remaining() != 0) {
+		throw DecodeError("Code attribute length mismatch.");
+	}
+
+	raw = NULL;
+	return this;
+}
+
+void CodeAttribute::DecodeContents(ClassBuffer *buffer, ClassFile *classFile) {
+	uint16_t length;
+
 	// Maximums
 	max_stack = buffer->NextShort();
 	max_locals = buffer->NextShort();
@@ -58,13 +94,25 @@ CodeAttribute *CodeAttribute
 	code_length = buffer->NextInt();
 	debug_printf(level2, "Code length : %u.\n", code_length);
 
-	code = new uint8_t[code_length];
-	buffer->Next(code, code_length);
+	if(buffer->IsPersistent()) {
+		// Reference the source directly.
+		code = const_cast<uint8_t *>(buffer->Borrow(code_length));
+		borrowed = true;
+	} else if(Arena *arena = Arena::Current()) {
+		// Released along with the arena.
+		code = (uint8_t *)arena->Allocate(code_length);
+		buffer->Next(code, code_length);
+		borrowed = true;
+	} else {
+		code = new uint8_t[code_length];
+		buffer->Next(code, code_length);
+	}
 
 	// Exception Table
 	length = buffer->NextShort();
 	debug_printf(level2, "Code Exception table length : %hu.\n", length);
 
+	exception_table.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Code Exception table entry %u :\n", idx);
 		exception_table.push_back((new ExceptionTableEntry)->DecodeEntry(buffer));
@@ -74,12 +122,13 @@ CodeAttribute *CodeAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Code Attributes count : %hu.\n", length);
 
+	attributes.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Code Attribute %u :\n", idx);
-		attributes.push_back(JBC::DecodeAttribute(buffer, classFile));
+		if(AttributeInfo *info = JBC::DecodeAttribute(buffer, classFile)) {
+			attributes.push_back(info);
+		}
 	}
-
-	return this;
 }
 
 StackMapTableAttribute *StackMapTableAttribute
@@ -92,6 +141,7 @@ StackMapTableAttribute *StackMapTableAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Stack Frame count : %d.\n", length);
 
+	entries.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Stack Map Frame %d :\n", idx);
 		entries.push_back(DecodeStackMapFrame(buffer, classFile));
@@ -112,6 +162,7 @@ ExceptionsAttribute *ExceptionsAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Exceptions count : %d.\n", length);
 
+	exception_table.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		uint16_t index = buffer->NextShort();
 		debug_printf(level2, "Exception entry %d :\n", idx);
@@ -142,7 +193,8 @@ InnerClassEntry *InnerClassEntry
 	inner_class_name = static_cast<ConstantUtf8Info *>(
 			classFile->constant_pool[index]);
 
-	debug_printf(level2, "Inner class name : %s.\n",
+	debug_printf(level2, "Inner class name : %.*s.\n",
+			(index != 0 ? inner_class_name->length : 17),
 			(index != 0 ? (char *)inner_class_name->bytes
 			: "<anonymous class>"));
 
@@ -163,6 +215,7 @@ InnerClassesAttribute *InnerClassesAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Inner classes count : %d.\n", length);
 
+	classes.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Inner class %d :\n", idx);
 		classes.push_back((new InnerClassEntry)->DecodeEntry(buffer, classFile));
@@ -213,7 +266,7 @@ SourceFileAttribute *SourceFileAttribute
 	source_file = static_cast<ConstantUtf8Info *>(
 			classFile->constant_pool[index]);
 
-	debug_printf(level2, "Source file name : %s.\n", source_file->bytes);
+	debug_printf(level2, "Source file name : %.*s.\n", source_file->length, source_file->bytes);
 
 	return this;
 }
@@ -249,6 +302,7 @@ LineNumberTableAttribute *LineNumberTableAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Line Number Table length : %hu.\n", length);
 
+	line_number_table.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		line_number_table.push_back((new LineNumberTableEntry)
 				->DecodeEntry(buffer));
@@ -269,12 +323,12 @@ LocalVariableTableEntry *LocalVariableTableEntry
 	// Variable Name
 	index = buffer->NextShort();
 	name = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level3, "Local variable name : %s.\n", name->bytes);
+	debug_printf(level3, "Local variable name : %.*s.\n", name->length, name->bytes);
 
 	// Variable Descriptor
 	index = buffer->NextShort();
 	descriptor = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level3, "Local variable descriptor : %s.\n", descriptor->bytes);
+	debug_printf(level3, "Local variable descriptor : %.*s.\n", descriptor->length, descriptor->bytes);
 
 	this->index = buffer->NextShort();
 	debug_printf(level3, "Index : %d.\n", this->index);
@@ -292,6 +346,7 @@ LocalVariableTableAttribute *LocalVariableTableAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Local Variable Table length : %d.\n", length);
 
+	local_variable_table.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		local_variable_table.push_back((new LocalVariableTableEntry)
 				->DecodeEntry(buffer, classFile));
@@ -312,12 +367,12 @@ LocalVariableTypeTableEntry *LocalVariableTypeTableEntry
 	// Variable Type Name
 	index = buffer->NextShort();
 	name = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level3, "Local variable name : %s.\n", name->bytes);
+	debug_printf(level3, "Local variable name : %.*s.\n", name->length, name->bytes);
 
 	// Variable Type Signature
 	index = buffer->NextShort();
 	signature = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level3, "Local variable signature : %s.\n", signature->bytes);
+	debug_printf(level3, "Local variable signature : %.*s.\n", signature->length, signature->bytes);
 
 	this->index = buffer->NextShort();
 	debug_printf(level3, "Index : %d.\n", this->index);
@@ -335,6 +390,7 @@ LocalVariableTypeTableAttribute *LocalVariableTypeTableAttribute
 	length = buffer->NextShort();
 	debug_printf(level2, "Local Variable Type Table length : %d.\n", length);
 
+	local_variable_type_table.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		local_variable_type_table.push_back((new LocalVariableTypeTableEntry)
 				->DecodeEntry(buffer, classFile));
@@ -349,6 +405,7 @@ RuntimeAnnotationsAttribute *RuntimeAnnotationsAttribute
 
 	// Annotations Table
 	length = buffer->NextShort();
+	annotations.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		annotations.push_back((new AnnotationEntry)
 				->DecodeEntry(buffer, classFile));
@@ -365,6 +422,7 @@ ParameterAnnotationsEntry *ParameterAnnotationsEntry
 	length = buffer->NextShort();
 	debug_printf(level2, "Parameter Annotations entry count : %u.\n", length);
 
+	annotations.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Parameter Annotation entry %u :\n", idx);
 		annotations.push_back((new AnnotationEntry)
@@ -382,6 +440,7 @@ RuntimeParameterAnnotationsAttribute *RuntimeParameterAnnotationsAttribute
 	length = buffer->NextByte();
 	debug_printf(level2, "Parameter Annotation count : %u.\n", length);
 
+	parameter_annotations.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Parameter Annotation %u :\n", idx);
 		parameter_annotations.push_back((new ParameterAnnotationsEntry)
@@ -411,6 +470,7 @@ BootstrapMethodEntry *BootstrapMethodEntry
 
 	// Bootstrap Method Parameters Table
 	length = buffer->NextShort();
+	bootstrap_arguments.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		uint16_t index = buffer->NextShort();
 		bootstrap_arguments.push_back(classFile->constant_pool[index]);
@@ -427,6 +487,7 @@ BootstrapMethodsAttribute *BootstrapMethodsAttribute
 
 	// Bootstrap Method Table
 	length = buffer->NextShort();
+	bootstrap_methods.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		bootstrap_methods.push_back((new BootstrapMethodEntry)
 				->DecodeEntry(buffer, classFile));
@@ -435,135 +496,204 @@ BootstrapMethodsAttribute *BootstrapMethodsAttribute
 	return this;
 }
 
-AttributeInfo *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile) {
-	size_t initpos = buffer->Position();
+OpaqueAttribute *OpaqueAttribute
+		::DecodeAttribute(ClassBuffer *buffer, ClassFile *) {
+	debug_printf(level3, "Decoding Opaque Attribute.\n");
+
+	if(buffer->IsPersistent()) {
+		// Reference the source directly.
+		bytes = buffer->Borrow(attribute_length);
+		borrowed = true;
+	} else if(Arena *arena = Arena::Current()) {
+		// Released along with the arena.
+		uint8_t *copy = (uint8_t *)arena->Allocate(attribute_length);
+		buffer->Next(copy, attribute_length);
+		bytes = copy;
+		borrowed = true;
+	} else {
+		uint8_t *copy = new uint8_t[attribute_length];
+		buffer->Next(copy, attribute_length);
+		bytes = copy;
+	}
+
+	return this;
+}
+
+/* Attribute Kinds */
+
+template<typename Attribute>
+static
+AttributeInfo *CreateAttribute(ConstantUtf8Info *name, uint32_t attribute_length) {
+	return new Attribute(name, attribute_length);
+}
+
+struct AttributeType {
+	const char *name;
+	size_t length;
+
+	AttributeProducer create;
+};
+
+# define ATTRIBUTE_TYPE(name, type) \
+	{ name, sizeof(name) - 1, CreateAttribute<type> }
+
+// Indexed by AttributeKind.
+static
+const AttributeType attribute_types[ATTRIBUTE_NONSTANDARD] = {
+	{ NULL, 0, NULL },
+	ATTRIBUTE_TYPE("ConstantValue", ConstantValueAttribute),
+	ATTRIBUTE_TYPE("Code", CodeAttribute),
+	ATTRIBUTE_TYPE("StackMapTable", StackMapTableAttribute),
+	ATTRIBUTE_TYPE("Exceptions", ExceptionsAttribute),
+	ATTRIBUTE_TYPE("InnerClasses", InnerClassesAttribute),
+	ATTRIBUTE_TYPE("EnclosingMethod", EnclosingMethodAttribute),
+	ATTRIBUTE_TYPE("Synthetic", SyntheticAttribute),
+	ATTRIBUTE_TYPE("Signature", SignatureAttribute),
+	ATTRIBUTE_TYPE("SourceFile", SourceFileAttribute),
+	ATTRIBUTE_TYPE("SourceDebugExtension", SourceDebugExtensionAttribute),
+	ATTRIBUTE_TYPE("LineNumberTable", LineNumberTableAttribute),
+	ATTRIBUTE_TYPE("LocalVariableTable", LocalVariableTableAttribute),
+	ATTRIBUTE_TYPE("LocalVariableTypeTable", LocalVariableTypeTableAttribute),
+	ATTRIBUTE_TYPE("Deprecated", DeprecatedAttribute),
+	ATTRIBUTE_TYPE("RuntimeVisibleAnnotations",
+			RuntimeVisibleAnnotationsAttribute),
+	ATTRIBUTE_TYPE("RuntimeInvisibleAnnotations",
+			RuntimeInvisibleAnnotationsAttribute),
+	ATTRIBUTE_TYPE("RuntimeVisibleParameterAnnotations",
+			RuntimeVisibleParameterAnnotationsAttribute),
+	ATTRIBUTE_TYPE("RuntimeInvisibleParameterAnnotations",
+			RuntimeInvisibleParameterAnnotationsAttribute),
+	ATTRIBUTE_TYPE("AnnotationDefault", AnnotationDefaultAttribute),
+	ATTRIBUTE_TYPE("BootstrapMethods", BootstrapMethodsAttribute)
+};
+
+# undef ATTRIBUTE_TYPE
+
+AttributeKind ResolveAttributeKind(ConstantUtf8Info *name) {
+	if(name->attribute_kind == ATTRIBUTE_UNRESOLVED) {
+		name->attribute_kind = ATTRIBUTE_NONSTANDARD;
+
+		for(unsigned kind = 1; kind < ATTRIBUTE_NONSTANDARD; kind++) {
+			const AttributeType &type = attribute_types[kind];
+
+			if(name->length == type.length
+					&& !memcmp(name->bytes, type.name, type.length)) {
+				name->attribute_kind = kind;
+				break;
+			}
+		}
+	}
+
+	return (AttributeKind)name->attribute_kind;
+}
+
+static inline
+bool IsFiltered(const DecodeOptions &options, ConstantUtf8Info *name,
+		AttributeKind kind) {
+	if(kind != ATTRIBUTE_NONSTANDARD) {
+		return (options.attribute_filter & AttributeMask(kind)) != 0;
+	}
+
+	return options.name_filter != NULL && options.name_filter(name->View());
+}
+
+static
+AttributeInfo *DecodeAttributeInfo(ClassBuffer *buffer, ClassFile *classFile) {
 	uint16_t name_index = buffer->NextShort();
 	uint32_t attribute_length = buffer->NextInt();
-	ConstantUtf8Info *name = static_cast<ConstantUtf8Info *>(
-			classFile->constant_pool[name_index]);
-
-	if(name == NULL) {
-		fprintf(stderr, "Error : Attribute with no name entry!\n");
-		exit(EXIT_FAILURE);
+	ConstantUtf8Info *name;
+	AttributeKind kind;
+
+	if(name_index >= classFile->constant_pool.size()
+			|| classFile->constant_pool[name_index] == NULL
+			|| classFile->constant_pool[name_index]->tag != CONSTANT_UTF8) {
+		char tmp[64];
+		sprintf(tmp, "Attribute name (index %u) is not a UTF-8 constant.", name_index);
+		throw DecodeError(tmp);
 	}
 
-	debug_printf(level1, "Decoding Attribute type : %s.\n", name->bytes);
+	name = static_cast<ConstantUtf8Info *>(classFile->constant_pool[name_index]);
+	debug_printf(level1, "Decoding Attribute type : %.*s.\n", name->length, name->bytes);
 
-	// Constant Value Attribute
-	if(!strcmp("ConstantValue", (char *)name->bytes)) {
-		return (new ConstantValueAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Code Attribute
-	if(!strcmp("Code", (char *)name->bytes)) {
-		return (new CodeAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Stack Map Table Attribute
-	if(!strcmp("StackMapTable", (char *)name->bytes)) {
-		return (new StackMapTableAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Exceptions Attribute
-	if(!strcmp("Exceptions", (char *)name->bytes)) {
-		return (new ExceptionsAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Inner Classes Attribute
-	if(!strcmp("InnerClasses", (char *)name->bytes)) {
-		return (new InnerClassesAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Enclosing Method Attribute
-	if(!strcmp("EnclosingMethod", (char *)name->bytes)) {
-		return (new EnclosingMethodAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Synthetic Attribute
-	if(!strcmp("Synthetic", (char *)name->bytes)) {
-		return new SyntheticAttribute(name, attribute_length);
-	} else
-	// Signature Attribute
-	if(!strcmp("Signature", (char *)name->bytes)) {
-		return (new SignatureAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Source File Attribute
-	if(!strcmp("SourceFile", (char *)name->bytes)) {
-		return (new SourceFileAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Source Debug Extension Attribute
-	if(!strcmp("SourceDebugExtension", (char *)name->bytes)) {
-		return (new SourceDebugExtensionAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Line Number Table Attribute
-	if(!strcmp("LineNumberTable", (char *)name->bytes)) {
-		return (new LineNumberTableAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Local Variable Table Attribute
-	if(!strcmp("LocalVariableTable", (char *)name->bytes)) {
-		return (new LocalVariableTableAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Local Variable Type Table Attribute
-	if(!strcmp("LocalVariableTypeTable", (char *)name->bytes)) {
-		return (new LocalVariableTypeTableAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Deprecated Attribute
-	if(!strcmp("Deprecated", (char *)name->bytes)) {
-		return new DeprecatedAttribute(name, attribute_length);
-	} else
-	// Runtime Visible Annotations Attribute
-	if(!strcmp("RuntimeVisibleAnnotations", (char *)name->bytes)) {
-		return (new RuntimeVisibleAnnotationsAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Runtime Invisible Annotations Attribute
-	if(!strcmp("RuntimeInvisibleAnnotations", (char *)name->bytes)) {
-		return (new RuntimeVisibleAnnotationsAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Runtime Visible Parameter Annotations Attribute
-	if(!strcmp("RuntimeVisibleParameterAnnotations", (char *)name->bytes)) {
-		return (new RuntimeVisibleParameterAnnotationsAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Runtime Visible Parameter Annotations Attribute
-	if(!strcmp("RuntimeInvisibleParameterAnnotations", (char *)name->bytes)) {
-		return (new RuntimeVisibleParameterAnnotationsAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Annotation Default Attribute
-	if(!strcmp("AnnotationDefault", (char *)name->bytes)) {
-		return (new AnnotationDefaultAttribute(name, attribute_length))
-				->DecodeAttribute(buffer, classFile);
-	} else
-	// Bootstrap Methods Attribute
-	if(!strcmp("BootstrapMethods", (char *)name->bytes)) {
-		return (new BootstrapMethodsAttribute(name, attribute_length))
+	kind = ResolveAttributeKind(name);
+	if(IsFiltered(classFile->options, name, kind)) {
+		if(classFile->options.keep_filtered) {
+			debug_printf(level2, "Keeping filtered Attribute as opaque.\n");
+			return (new OpaqueAttribute(name, attribute_length))
+					->DecodeAttribute(buffer, classFile);
+		}
+
+		debug_printf(level2, "Skipping filtered Attribute.\n");
+		buffer->Skip(attribute_length);
+		return NULL;
+	}
+
+	// Standard Attributes
+	if(kind != ATTRIBUTE_NONSTANDARD) {
+		return attribute_types[kind].create(name, attribute_length)
 				->DecodeAttribute(buffer, classFile);
 	} else {
-		char *elem_name = reinterpret_cast<char *>(name->bytes);
-		AttributeProducer producer = producer_map[elem_name];
+		const ProducerRegistry *producers = classFile->options.producers;
+		AttributeProducer producer = NULL;
+
+		// Context producers take precedence.
+		if(producers != NULL) {
+			producer = producers->Find(name->View());
+		}
+
+		if(producer == NULL) {
+			producer = ProducerRegistry::Global().Find(name->View());
+		}
 
 		if(producer != NULL) {
-			debug_printf(level2, "Custom Attribute from Producer (%s).\n", elem_name);
+			debug_printf(level2, "Custom Attribute from Producer (%.*s).\n",
+					name->length, name->bytes);
 			return producer(name, attribute_length)->DecodeAttribute(buffer, classFile);
 		} else {
-			size_t difference;
+			// Preserved as is, for encoding.
+			debug_printf(level2, "Unknown Attribute type : %.*s; Keeping as opaque.\n",
+					name->length, name->bytes);
+			return (new OpaqueAttribute(name, attribute_length))
+					->DecodeAttribute(buffer, classFile);
+		}
+	}
+}
 
-			debug_printf(level2, "Unknown Attribute type : %s; Skipping.\n", name->bytes);
-			if((difference = buffer->Position() - initpos) < attribute_length) {
-				buffer->Skip(difference);
-			}
+AttributeInfo *DecodeAttribute(ClassBuffer *buffer, ClassFile *classFile) {
+	const uint8_t *source = NULL;
+	size_t start = buffer->Position() + 6;
+	AttributeInfo *info;
+
+	if(buffer->IsPersistent() && classFile->options.copy_unmodified) {
+		// Contents follow the name and length.
+		source = buffer->Current() + 6;
+	}
+
+	if((info = DecodeAttributeInfo(buffer, classFile)) != NULL) {
+		// Contents are copied through as recorded, so must match.
+		if(buffer->Position() - start != info->attribute_length) {
+			char tmp[96];
+			sprintf(tmp, "Attribute length mismatch; expected %u bytes, decoded %zu.",
+					info->attribute_length, buffer->Position() - start);
+			delete info;
+			throw DecodeError(tmp);
 		}
+
+		info->source = source;
 	}
 
-	return NULL;
+	return info;
+}
+
+void SkipAttributes(ClassBuffer *buffer) {
+	uint16_t length = buffer->NextShort();
+
+	debug_printf(level2, "Skipping %hu attributes.\n", length);
+	for(unsigned idx = 0; idx < length; idx++) {
+		// Name index, then contents.
+		buffer->Skip(2);
+		buffer->Skip(buffer->NextInt());
+	}
 }
 
 } /* JBC */
@@ -26,12 +26,56 @@ ExceptionTableEntry *ExceptionTableEntry
 	return this;
 }
 
+bool CodeAttribute::IsDirty() {
+	size_t offset;
+
+	if(source == NULL) return true;
+	if(raw != NULL) return false;
+
+	// Attributes may have been filtered while decoding.
+	offset = 2 + 2 + 4 + code_length + 2 + 8 * exception_table.size();
+	if(attributes.size() != (size_t)((source[offset] << 8) | source[offset + 1])) {
+		return true;
+	}
+
+	// Nested attributes are encoded with this one.
+	for(unsigned idx = 0; idx < attributes.size(); idx++) {
+		if(attributes[idx]->IsDirty()) return true;
+	}
+
+	return false;
+}
+
+uint32_t CodeAttribute::ComputeLength() {
+	uint32_t size = 2 + 2 + 4 + code_length;
+
+	// Untouched since decoding.
+	if(raw != NULL) return attribute_length;
+
+	// Exception Table
+	size += 2;
+	for(unsigned idx = 0; idx < exception_table.size(); idx++) {
+		size += exception_table[idx]->ComputeSize();
+	}
+
+	// Attribute Table
+	size += ComputeAttributesSize(attributes);
+
+	return size;
+}
+
 CodeAttribute *CodeAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
 
 	debug_printf(level3, "Encoding Code Attribute.\n");
 
+	if(raw != NULL) {
+		// Copy out the undecoded contents.
+		builder->Next(raw, attribute_length);
+		return this;
+	}
+
 	// Maximums
 	builder->NextShort(max_stack);
 	builder->NextShort(max_locals);
@@ -62,6 +106,16 @@ CodeAttribute *CodeAttribute
 	return this;
 }
 
+uint32_t StackMapTableAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < entries.size(); idx++) {
+		size += entries[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 StackMapTableAttribute *StackMapTableAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -78,6 +132,10 @@ StackMapTableAttribute *StackMapTableAttribute
 	return this;
 }
 
+uint32_t ExceptionsAttribute::ComputeLength() {
+	return 2 + 2 * exception_table.size();
+}
+
 ExceptionsAttribute *ExceptionsAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *) {
 	uint16_t length;
@@ -107,6 +165,16 @@ InnerClassEntry *InnerClassEntry
 	return this;
 }
 
+uint32_t InnerClassesAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < classes.size(); idx++) {
+		size += classes[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 InnerClassesAttribute *InnerClassesAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -170,6 +238,16 @@ LineNumberTableEntry *LineNumberTableEntry
 	return this;
 }
 
+uint32_t LineNumberTableAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < line_number_table.size(); idx++) {
+		size += line_number_table[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 LineNumberTableAttribute *LineNumberTableAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *) {
 	uint16_t length;
@@ -202,6 +280,16 @@ LocalVariableTableEntry *LocalVariableTableEntry
 	return 0;
 }
 
+uint32_t LocalVariableTableAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < local_variable_table.size(); idx++) {
+		size += local_variable_table[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 LocalVariableTableAttribute *LocalVariableTableAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	debug_printf(level3, "Encoding Local Variable Table Attribute.\n");
@@ -233,6 +321,16 @@ LocalVariableTypeTableEntry *LocalVariableTypeTableEntry
 	return this;
 }
 
+uint32_t LocalVariableTypeTableAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < local_variable_type_table.size(); idx++) {
+		size += local_variable_type_table[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 LocalVariableTypeTableAttribute *LocalVariableTypeTableAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -249,6 +347,16 @@ LocalVariableTypeTableAttribute *LocalVariableTypeTableAttribute
 	return this;
 }
 
+uint32_t RuntimeAnnotationsAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < annotations.size(); idx++) {
+		size += annotations[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 RuntimeAnnotationsAttribute *RuntimeAnnotationsAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -265,6 +373,16 @@ RuntimeAnnotationsAttribute *RuntimeAnnotationsAttribute
 	return 0;
 }
 
+uint32_t ParameterAnnotationsEntry::ComputeSize() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < annotations.size(); idx++) {
+		size += annotations[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 ParameterAnnotationsEntry *ParameterAnnotationsEntry
 		::EncodeEntry(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -281,6 +399,16 @@ ParameterAnnotationsEntry *ParameterAnnotationsEntry
 	return this;
 }
 
+uint32_t RuntimeParameterAnnotationsAttribute::ComputeLength() {
+	uint32_t size = 1;
+
+	for(unsigned idx = 0; idx < parameter_annotations.size(); idx++) {
+		size += parameter_annotations[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 RuntimeParameterAnnotationsAttribute *RuntimeParameterAnnotationsAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -297,6 +425,10 @@ RuntimeParameterAnnotationsAttribute *RuntimeParameterAnnotationsAttribute
 	return this;
 }
 
+uint32_t AnnotationDefaultAttribute::ComputeLength() {
+	return default_value->ComputeSize();
+}
+
 AnnotationDefaultAttribute *AnnotationDefaultAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	debug_printf(level3, "Encoding Annotation Default Attribute.\n");
@@ -325,6 +457,16 @@ BootstrapMethodEntry *BootstrapMethodEntry
 	return this;
 }
 
+uint32_t BootstrapMethodsAttribute::ComputeLength() {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < bootstrap_methods.size(); idx++) {
+		size += bootstrap_methods[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 BootstrapMethodsAttribute *BootstrapMethodsAttribute
 		::EncodeAttribute(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
@@ -341,9 +483,29 @@ BootstrapMethodsAttribute *BootstrapMethodsAttribute
 	return this;
 }
 
+OpaqueAttribute *OpaqueAttribute
+		::EncodeAttribute(ClassBuilder *builder, ClassFile *) {
+	debug_printf(level3, "Encoding Opaque Attribute.\n");
+
+	builder->Next(bytes, attribute_length);
+
+	return this;
+}
+
 int EncodeAttribute(ClassBuilder *builder, ClassFile *classFile, AttributeInfo *info) {
 	debug_printf(level3, "Encoding Attribute.\n");
 
+	if(classFile->CanReuseSource() && !info->IsDirty()) {
+		// Unmodified since decoding.
+		builder->NextShort(info->name->index);
+		builder->NextInt(info->attribute_length);
+		builder->Next(info->source, info->attribute_length);
+		return 0;
+	}
+
+	// Contents may have changed since decoding.
+	info->attribute_length = info->ComputeLength();
+
 	builder->NextShort(info->name->index);
 	builder->NextInt(info->attribute_length);
 	info->EncodeAttribute(builder, classFile);
@@ -351,4 +513,14 @@ int EncodeAttribute(ClassBuilder *builder, ClassFile *classFile, AttributeInfo *
 	return 0;
 }
 
+uint32_t ComputeAttributesSize(const std::vector<AttributeInfo *> &attributes) {
+	uint32_t size = 2;
+
+	for(unsigned idx = 0; idx < attributes.size(); idx++) {
+		size += attributes[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 } /* JBC */
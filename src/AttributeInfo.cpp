@@ -10,8 +10,8 @@ namespace JBC {
 
 CodeAttribute::~CodeAttribute() {
 	debug_printf(level3, "Deleting Code Attribute.\n");
-	if(code != NULL)
-		delete code;
+	if(code != NULL && !borrowed)
+		delete[] code;
 	if(!exception_table.empty()) {
 		debug_printf(level3, "Deleting exception table.\n");
 		for(std::vector<ExceptionTableEntry *>::iterator itr = exception_table.begin();
@@ -61,7 +61,7 @@ SourceDebugExtensionAttribute::~SourceDebugExtensionAttribute() {
 	debug_printf(level3, "Deleting Source Debug Extension Attribute.\n");
 
 	if(debug_extension != NULL) {
-		delete debug_extension;
+		delete[] debug_extension;
 	}
 }
 
@@ -90,7 +90,7 @@ LocalVariableTableAttribute::~LocalVariableTableAttribute() {
 LocalVariableTypeTableAttribute::~LocalVariableTypeTableAttribute() {
 	debug_printf(level3, "Deleting Local Variable Type Table Attribute.\n");
 
-	if(!local_variable_type_table.size()) {
+	if(!local_variable_type_table.empty()) {
 		for(std::vector<LocalVariableTypeTableEntry *>::iterator itr = local_variable_type_table
 				.begin(); itr != local_variable_type_table.end(); itr++) {
 			delete *itr;
@@ -142,12 +142,8 @@ AnnotationDefaultAttribute::~AnnotationDefaultAttribute() {
 BootstrapMethodEntry::~BootstrapMethodEntry() {
 	debug_printf(level3, "Deleting Bootstrap Method Entry.\n");
 
-	if(!bootstrap_arguments.empty()) {
-		for(std::vector<ConstantInfo *>::iterator itr = bootstrap_arguments.begin();
-				itr != bootstrap_arguments.end(); itr++) {
-			delete *itr;
-		}
-	}
+	// ConstantInfo entries are deallocated elsewhere.
+	bootstrap_arguments.clear();
 }
 
 BootstrapMethodsAttribute::~BootstrapMethodsAttribute() {
@@ -160,4 +156,12 @@ BootstrapMethodsAttribute::~BootstrapMethodsAttribute() {
 	}
 }
 
+OpaqueAttribute::~OpaqueAttribute() {
+	debug_printf(level3, "Deleting Opaque Attribute.\n");
+
+	if(bytes != NULL && !borrowed) {
+		delete[] bytes;
+	}
+}
+
 } /* JBC */
@@ -0,0 +1,293 @@
+
+# include <errno.h>
+# include <stdio.h>
+# include <string.h>
+
+# include <atomic>
+# include <memory>
+# include <thread>
+# include <system_error>
+
+# include "Arena.h"
+# include "JarFile.h"
+# include "ErrorTypes.h"
+# include "BatchDecoder.h"
+
+namespace JBC {
+
+/**
+ * @struct JarInput
+ * @brief An entry of a jar to decode.
+ **/
+struct JarInput {
+	JarFile		*jar;
+	const JarEntry *entry;
+};
+
+static inline
+std::string InputName(const std::string &path) {
+	return path;
+}
+
+static inline
+std::string InputName(const ClassSource &) {
+	return std::string();
+}
+
+static inline
+std::string InputName(const JarInput &input) {
+	return std::string(input.entry->name);
+}
+
+/**
+ * @struct WorkRange
+ * @brief The inputs left to a worker, packed to be updated atomically.
+ *
+ * The owner takes inputs from the start of its range, and thieves take
+ * the back half of it, both with a compare and swap.
+ **/
+struct alignas(64) WorkRange {
+	std::atomic<uint64_t> range;
+};
+
+static inline
+uint64_t PackRange(uint32_t begin, uint32_t end) {
+	return ((uint64_t)begin << 32) | end;
+}
+
+/**
+ * @class BatchWorker
+ * @brief Decodes inputs of a batch on one thread.
+ **/
+class BatchWorker {
+private:
+	ClassBatch *batch;
+	WorkRange *ranges;
+	unsigned	id;
+	unsigned	count;
+
+	DecodeOptions options;
+
+	// Reused for every file read.
+	std::vector<uint8_t> buffer;
+
+public:
+	BatchWorker(ClassBatch *batch, WorkRange *ranges, unsigned id, unsigned count,
+			const DecodeOptions &options)
+		: batch(batch), ranges(ranges), id(id), count(count), options(options) {
+		this->options.arena = batch->arenas[id];
+	}
+
+public:
+	template<typename Input>
+	void Run(const std::vector<Input> &inputs) {
+		uint32_t idx;
+
+		while(Take(idx) || Steal(idx)) {
+			try {
+				const uint8_t *data;
+				size_t size;
+
+				batch->names[idx] = InputName(inputs[idx]);
+				Load(inputs[idx], data, size);
+				batch->classes[idx] = DecodeClassFile(data, size, options);
+			} catch(JBCError &ex) {
+				batch->errors[idx] = ex.msg;
+			} catch(std::exception &ex) {
+				batch->errors[idx] = ex.what();
+			}
+		}
+	}
+
+private:
+	bool Take(uint32_t &idx) {
+		std::atomic<uint64_t> &range = ranges[id].range;
+		uint64_t current = range.load();
+
+		for(;;) {
+			uint32_t begin = (uint32_t)(current >> 32);
+			uint32_t end = (uint32_t)current;
+
+			if(begin >= end) return false;
+
+			if(range.compare_exchange_weak(current, PackRange(begin + 1, end))) {
+				idx = begin;
+				return true;
+			}
+		}
+	}
+
+	bool Steal(uint32_t &idx) {
+		for(unsigned offset = 1; offset < count; offset++) {
+			std::atomic<uint64_t> &range = ranges[(id + offset) % count].range;
+			uint64_t current = range.load();
+
+			for(;;) {
+				uint32_t begin = (uint32_t)(current >> 32);
+				uint32_t end = (uint32_t)current;
+				uint32_t middle = begin + (end - begin) / 2;
+
+				if(begin >= end) break;
+
+				if(range.compare_exchange_weak(current, PackRange(begin, middle))) {
+					// Keep the rest of the stolen half for ourselves.
+					ranges[id].range.store(PackRange(middle + 1, end));
+					idx = middle;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	void Load(const std::string &path, const uint8_t *&data, size_t &size) {
+		if(!ReadFile(path.c_str(), size)) {
+			std::string message = path + " : " + strerror(errno);
+			throw DecodeError(message.c_str());
+		}
+
+		data = buffer.data();
+	}
+
+	void Load(const ClassSource &source, const uint8_t *&data, size_t &size) {
+		data = source.data;
+		size = source.size;
+	}
+
+	void Load(const JarInput &input, const uint8_t *&data, size_t &size) {
+		data = input.jar->Read(*input.entry, buffer);
+		size = input.entry->size;
+	}
+
+	bool ReadFile(const char *path, size_t &size) {
+		FILE *input = fopen(path, "rb");
+		size = 0;
+
+		if(input == NULL) {
+			return false;
+		}
+
+		if(buffer.size() < 4096) {
+			buffer.resize(4096);
+		}
+
+		for(;;) {
+			size += fread(&buffer[size], sizeof(uint8_t), buffer.size() - size, input);
+			if(size < buffer.size()) break;
+
+			buffer.resize(buffer.size() * 2);
+		}
+
+		bool failed = ferror(input);
+		fclose(input);
+
+		if(failed) errno = EIO;
+		return !failed;
+	}
+};
+
+ClassBatch::ClassBatch(size_t count, unsigned workers)
+	: classes(count, (ClassFile *)NULL), errors(count), names(count) {
+	for(unsigned idx = 0; idx < workers; idx++) {
+		arenas.push_back(new Arena);
+	}
+}
+
+ClassBatch::~ClassBatch() {
+	// Classes are released before their arenas.
+	for(std::vector<ClassFile *>::iterator itr = classes.begin();
+			itr != classes.end(); itr++) {
+		delete *itr;
+	}
+
+	for(std::vector<Arena *>::iterator itr = arenas.begin();
+			itr != arenas.end(); itr++) {
+		delete *itr;
+	}
+}
+
+size_t ClassBatch::Failures() const {
+	size_t failures = 0;
+
+	for(size_t idx = 0; idx < errors.size(); idx++) {
+		if(!errors[idx].empty()) failures++;
+	}
+
+	return failures;
+}
+
+template<typename Input>
+static
+ClassBatch *DecodeBatch(const std::vector<Input> &inputs, unsigned threads,
+		const DecodeOptions &options) {
+	if(inputs.size() > 0xFFFFFFFF) {
+		throw DecodeError("Too many class files in one batch.");
+	}
+
+	uint32_t count = inputs.size();
+	unsigned workers = threads != 0 ? threads : std::thread::hardware_concurrency();
+
+	if(workers > count) workers = count;
+	if(workers == 0) workers = 1;
+
+	ClassBatch *batch = new ClassBatch(count, workers);
+	std::unique_ptr<WorkRange[]> ranges(new WorkRange[workers]);
+	std::vector<std::thread> pool;
+
+	// Split the inputs evenly to start with.
+	for(unsigned idx = 0; idx < workers; idx++) {
+		uint32_t begin = (uint64_t)count * idx / workers;
+		uint32_t end = (uint64_t)count * (idx + 1) / workers;
+
+		ranges[idx].range.store(PackRange(begin, end));
+	}
+
+	// The calling thread acts as the first worker.
+	pool.reserve(workers);
+	for(unsigned idx = 1; idx < workers; idx++) {
+		try {
+			pool.push_back(std::thread([&, idx]() {
+				BatchWorker worker(batch, ranges.get(), idx, workers, options);
+				worker.Run(inputs);
+			}));
+		} catch(std::system_error &) {
+			// The remaining ranges are stolen by the started workers.
+			break;
+		}
+	}
+
+	BatchWorker worker(batch, ranges.get(), 0, workers, options);
+	worker.Run(inputs);
+
+	for(std::vector<std::thread>::iterator itr = pool.begin();
+			itr != pool.end(); itr++) {
+		itr->join();
+	}
+
+	return batch;
+}
+
+ClassBatch *DecodeClassFiles(const std::vector<std::string> &paths,
+		unsigned threads, const DecodeOptions &options) {
+	return DecodeBatch(paths, threads, options);
+}
+
+ClassBatch *DecodeClassFiles(const std::vector<ClassSource> &sources,
+		unsigned threads, const DecodeOptions &options) {
+	return DecodeBatch(sources, threads, options);
+}
+
+ClassBatch *DecodeClassFiles(JarFile *jar, const std::vector<const JarEntry *> &entries,
+		unsigned threads, const DecodeOptions &options) {
+	std::vector<JarInput> inputs(entries.size());
+
+	for(size_t idx = 0; idx < entries.size(); idx++) {
+		inputs[idx].jar = jar;
+		inputs[idx].entry = entries[idx];
+	}
+
+	return DecodeBatch(inputs, threads, options);
+}
+
+} /* JBC */
@@ -0,0 +1,244 @@
+
+# include <stdio.h>
+
+# include "Bytecode.h"
+# include "ClassFile.h"
+# include "ErrorTypes.h"
+# include "AttributeInfo.h"
+
+namespace JBC {
+
+static inline
+uint16_t ReadShort(const uint8_t *src) {
+	return (src[0] << 8) | src[1];
+}
+
+static inline
+int32_t ReadInt(const uint8_t *src) {
+	return (int32_t)(((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16)
+			| ((uint32_t)src[2] << 8) | src[3]);
+}
+
+static
+void ThrowMalformed(const char *reason, uint32_t pc) {
+	char tmp[64];
+	sprintf(tmp, "%s at pc %u.", reason, pc);
+	throw DecodeError(tmp);
+}
+
+int32_t Instruction::CaseKey(uint32_t idx) const {
+	if(opcode == OP_TABLESWITCH) {
+		return low + (int32_t)idx;
+	}
+
+	return ReadInt(table + 8 * idx);
+}
+
+uint32_t Instruction::CaseTarget(uint32_t idx) const {
+	if(opcode == OP_TABLESWITCH) {
+		return pc + ReadInt(table + 4 * idx);
+	}
+
+	return pc + ReadInt(table + 8 * idx + 4);
+}
+
+InstructionIterator::InstructionIterator(const uint8_t *code, uint32_t length,
+		ClassFile *classFile)
+	: code(code), length(length), pc(0), classFile(classFile) {
+}
+
+InstructionIterator::InstructionIterator(CodeAttribute *code, ClassFile *classFile)
+	: code(NULL), length(0), pc(0), classFile(classFile) {
+	if(!code->IsLoaded()) {
+		if(classFile == NULL) {
+			throw JBCError("Code attribute is not loaded.");
+		}
+
+		code->Load(classFile);
+	}
+
+	this->code = code->code;
+	this->length = code->code_length;
+}
+
+bool InstructionIterator::Next(Instruction &insn) {
+	const uint8_t *src;
+	uint32_t start;
+
+	if(pc >= length) return false;
+
+	insn.pc = start = pc;
+	insn.opcode = code[pc];
+	insn.wide = false;
+	insn.index = 0;
+	insn.value = 0;
+	insn.target = 0;
+	insn.constant = NULL;
+	insn.low = 0;
+	insn.count = 0;
+	insn.table = NULL;
+
+	const OpcodeInfo *info = &opcode_table[insn.opcode];
+	if(info->format == FORMAT_WIDE) {
+		if(pc + 1 >= length) {
+			ThrowMalformed("Truncated instruction", start);
+		}
+
+		// Decoded as the widened instruction.
+		insn.opcode = code[++pc];
+		insn.wide = true;
+
+		info = &opcode_table[insn.opcode];
+		if(info->format != FORMAT_LOCAL && info->format != FORMAT_IINC) {
+			ThrowMalformed("Invalid wide instruction", start);
+		}
+	}
+
+	src = code + pc + 1;
+
+	switch(info->format) {
+		case FORMAT_NONE:
+			insn.length = 1;
+			break;
+		case FORMAT_BYTE:
+		case FORMAT_NEWARRAY:
+			insn.length = 2;
+			if(pc + 2 > length) break;
+			insn.value = info->format == FORMAT_BYTE ? (int8_t)src[0] : src[0];
+			break;
+		case FORMAT_SHORT:
+			insn.length = 3;
+			if(pc + 3 > length) break;
+			insn.value = (int16_t)ReadShort(src);
+			break;
+		case FORMAT_LOCAL:
+			insn.length = insn.wide ? 3 : 2;
+			if(pc + insn.length > length) break;
+			insn.index = insn.wide ? ReadShort(src) : src[0];
+			break;
+		case FORMAT_IINC:
+			insn.length = insn.wide ? 5 : 3;
+			if(pc + insn.length > length) break;
+			if(insn.wide) {
+				insn.index = ReadShort(src);
+				insn.value = (int16_t)ReadShort(src + 2);
+			} else {
+				insn.index = src[0];
+				insn.value = (int8_t)src[1];
+			}
+			break;
+		case FORMAT_CONSTANT1:
+			insn.length = 2;
+			if(pc + 2 > length) break;
+			insn.index = src[0];
+			break;
+		case FORMAT_CONSTANT2:
+			insn.length = 3;
+			if(pc + 3 > length) break;
+			insn.index = ReadShort(src);
+			break;
+		case FORMAT_INVOKEINTERFACE:
+		case FORMAT_INVOKEDYNAMIC:
+			insn.length = 5;
+			if(pc + 5 > length) break;
+			insn.index = ReadShort(src);
+			insn.value = src[2];
+			break;
+		case FORMAT_MULTIANEWARRAY:
+			insn.length = 4;
+			if(pc + 4 > length) break;
+			insn.index = ReadShort(src);
+			insn.value = src[2];
+			break;
+		case FORMAT_BRANCH2:
+			insn.length = 3;
+			if(pc + 3 > length) break;
+			insn.target = start + (int16_t)ReadShort(src);
+			break;
+		case FORMAT_BRANCH4:
+			insn.length = 5;
+			if(pc + 5 > length) break;
+			insn.target = start + ReadInt(src);
+			break;
+		case FORMAT_TABLESWITCH:
+		case FORMAT_LOOKUPSWITCH: {
+			// Operands are aligned to four bytes from the start of code.
+			uint32_t pad = 3 - (pc & 3);
+			uint32_t header = 1 + pad + (info->format == FORMAT_TABLESWITCH ? 12 : 8);
+
+			insn.length = header;
+			if(pc + header > length) break;
+
+			src += pad;
+			insn.target = start + ReadInt(src);
+			insn.table = code + pc + header;
+
+			if(info->format == FORMAT_TABLESWITCH) {
+				int32_t high;
+
+				insn.low = ReadInt(src + 4);
+				high = ReadInt(src + 8);
+				if(high < insn.low) {
+					ThrowMalformed("Invalid tableswitch bounds", start);
+				}
+
+				insn.count = (uint32_t)((int64_t)high - insn.low + 1);
+				if((uint64_t)pc + header + 4 * (uint64_t)insn.count > length) {
+					ThrowMalformed("Truncated instruction", start);
+				}
+
+				insn.length += 4 * insn.count;
+			} else {
+				if(ReadInt(src + 4) < 0) {
+					ThrowMalformed("Invalid lookupswitch count", start);
+				}
+
+				insn.count = ReadInt(src + 4);
+				if((uint64_t)pc + header + 8 * (uint64_t)insn.count > length) {
+					ThrowMalformed("Truncated instruction", start);
+				}
+
+				insn.length += 8 * insn.count;
+			}
+			break;
+		}
+		default:
+			ThrowMalformed("Invalid opcode", start);
+	}
+
+	if((uint64_t)pc + insn.length > length) {
+		ThrowMalformed("Truncated instruction", start);
+	}
+
+	pc += insn.length;
+	insn.length = pc - start;
+
+	if(info->flow != FLOW_NEXT && info->flow != FLOW_RET
+			&& info->flow != FLOW_RETURN && info->flow != FLOW_THROW) {
+		// Branch targets must be in the method.
+		if(insn.target >= length) {
+			ThrowMalformed("Branch target out of range", start);
+		}
+
+		for(uint32_t idx = 0; idx < insn.count; idx++) {
+			if(insn.CaseTarget(idx) >= length) {
+				ThrowMalformed("Branch target out of range", start);
+			}
+		}
+	}
+
+	if(classFile != NULL && insn.index != 0
+			&& (info->format == FORMAT_CONSTANT1 || info->format == FORMAT_CONSTANT2
+			|| info->format == FORMAT_INVOKEINTERFACE || info->format == FORMAT_INVOKEDYNAMIC
+			|| info->format == FORMAT_MULTIANEWARRAY)) {
+		if(insn.index >= classFile->constant_pool.size()) {
+			ThrowMalformed("Constant index out of range", start);
+		}
+
+		insn.constant = classFile->constant_pool[insn.index];
+	}
+
+	return true;
+}
+
+} /* JBC */
@@ -8,110 +8,77 @@
 namespace JBC {
 
 ClassBuffer::ClassBuffer(FILE *input)
-		: input(input), reads(0) {
+		: data(NULL), size(0), position(0), storage(NULL), reads(0),
+		  persistent(false) {
+	size_t capacity = 4096;
+
 	if(input == NULL) {
 		throw BufferError("Invalid input file.");
 	}
 
-	if(setvbuf(input, NULL, _IOFBF, 4096) == EOF) {
+	// Read the whole file up front.
+	if((storage = (uint8_t *)malloc(capacity)) == NULL) {
+		fclose(input);
 		throw BufferError(strerror(errno));
 	}
-}
-
-ClassBuffer::~ClassBuffer() {
-	fclose(input);
-}
 
-size_t ClassBuffer::Position() {
-	return ftell(input);
-}
+	for(;;) {
+		size += fread(storage + size, sizeof(uint8_t), capacity - size, input);
+		if(size < capacity) break;
+
+		uint8_t *grown = (uint8_t *)realloc(storage, capacity *= 2);
+		if(grown == NULL) {
+			free(storage);
+			fclose(input);
+			throw BufferError(strerror(errno));
+		}
+		storage = grown;
+	}
 
-// TODO: Implement an endianness check.
+	if(ferror(input)) {
+		free(storage);
+		fclose(input);
+		throw BufferError(strerror(errno));
+	}
 
-static inline
-void Swap(uint8_t &a, uint8_t &b) {
-	uint8_t t = a;
-	a = b;
-	b = t;
+	fclose(input);
+	data = storage;
 }
 
-static inline
-uint16_t FromBigEndian(uint16_t l) {
-	union {
-		uint16_t l;
-		uint8_t b[2];
-	} u = { l };
-
-	Swap(u.b[0], u.b[1]);
-	return u.l;
+ClassBuffer::ClassBuffer(const uint8_t *data, size_t size, bool persistent)
+		: data(data), size(size), position(0), storage(NULL), reads(0),
+		  persistent(persistent) {
+	if(data == NULL && size != 0) {
+		throw BufferError("Invalid input data.");
+	}
 }
 
-static inline
-uint32_t FromBigEndian(uint32_t l) {
-	union {
-		uint32_t l;
-		uint8_t b[4];
-	} u = { l };
+ClassBuffer::~ClassBuffer() {
+	if(storage != NULL) {
+		free(storage);
+	}
+}
 
-	Swap(u.b[0], u.b[3]);
-	Swap(u.b[1], u.b[2]);
-	return u.l;
+void ClassBuffer::Underflow(size_t count) {
+	char tmp[96];
+	snprintf(tmp, sizeof(tmp), "Unexpected end of class data; wanted %zu byte(s) at %zu of %zu.",
+			count, position, size);
+	throw BufferError(tmp);
 }
 
 void ClassBuffer::Skip(size_t count) {
+	Require(count);
 	reads += count;
-	if(fseek(input, count, SEEK_CUR) == EOF) {
-		throw BufferError(strerror(errno));
-	}
+	position += count;
 }
 
 uint8_t *ClassBuffer::Next(uint8_t *dst, size_t count) {
-	size_t read;
-
+	Require(count);
 	reads += count;
-	if((read = fread(dst, sizeof(uint8_t), count, input))
-			!= count * sizeof(uint8_t))
-		throw BufferError(strerror(errno));
-	return dst;
-}
-
-uint8_t ClassBuffer::NextByte() {
-	size_t read;
-	uint8_t value = 0;
-
-	reads++;
-	if((read = fread(&value, 1, sizeof(uint8_t), input))
-			!= sizeof(uint8_t)) {
-		throw BufferError(strerror(errno));
-	}
-
-	return value;
-}
 
-uint16_t ClassBuffer::NextShort() {
-	size_t read;
-	uint16_t value = 0;
-
-	reads++;
-	if((read = fread(&value, 1, sizeof(uint16_t), input))
-			!= sizeof(uint16_t)) {
-		throw BufferError(strerror(errno));
-	}
-
-	return FromBigEndian(value);
-}
-
-uint32_t ClassBuffer::NextInt() {
-	size_t read;
-	uint32_t value = 0;
-
-	reads++;
-	if((read = fread(&value, 1, sizeof(uint32_t), input))
-			!= sizeof(uint32_t)) {
-		throw BufferError(strerror(errno));
-	}
-
-	return FromBigEndian(value);
+	memcpy(dst, data + position, count);
+	position += count;
+	return dst;
 }
 
 } /* JBC */
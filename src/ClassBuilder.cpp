@@ -7,106 +7,61 @@
 
 namespace JBC {
 
+ClassBuilder::ClassBuilder()
+		: target(NULL), writes(0) {
+}
+
 ClassBuilder::ClassBuilder(FILE *output)
-		: output(output), writes(0) {
+		: target(output), writes(0) {
 	if(output == NULL) {
 		throw BuilderError("Invalid input file.");
 	}
-
-	if(setvbuf(output, NULL, _IOFBF, 4096) == EOF) {
-		throw BuilderError(strerror(errno));
-	}
 }
 
 ClassBuilder::~ClassBuilder() {
-	fflush(output);
-	fclose(output);
-}
+	if(target != NULL) {
+		// Best effort; errors are reported by Flush().
+		if(!output.empty()) {
+			fwrite(&output[0], sizeof(uint8_t), output.size(), target);
+		}
 
-size_t ClassBuilder::Position() {
-	return ftell(output);
+		fclose(target);
+	}
 }
 
-// TODO: Implement an endianness check.
-
-static inline
-void Swap(uint8_t &a, uint8_t &b) {
-	uint8_t t = a;
-	a = b;
-	b = t;
+std::vector<uint8_t> ClassBuilder::Take() {
+	std::vector<uint8_t> bytes;
+	bytes.swap(output);
+	return bytes;
 }
 
-static inline
-uint16_t ToBigEndian(uint16_t l) {
-	union {
-		uint16_t l;
-		uint8_t b[2];
-	} u = { l };
-
-	Swap(u.b[0], u.b[1]);
-	return u.l;
+void ClassBuilder::Reset() {
+	output.clear();
+	writes = 0;
 }
 
-static inline
-uint32_t ToBigEndian(uint32_t l) {
-	union {
-		uint32_t l;
-		uint8_t b[4];
-	} u = { l };
-
-	Swap(u.b[0], u.b[3]);
-	Swap(u.b[1], u.b[2]);
-	return u.l;
-}
+void ClassBuilder::Flush() {
+	if(target == NULL || output.empty()) {
+		return;
+	}
 
-ClassBuilder *ClassBuilder::Skip(size_t count) {
-	writes += count;
-	if(fseek(output, count, SEEK_CUR) == EOF) {
+	if(fwrite(&output[0], sizeof(uint8_t), output.size(), target)
+			!= output.size() || fflush(target) == EOF) {
 		throw BuilderError(strerror(errno));
 	}
 
-	return this;
+	output.clear();
 }
 
-ClassBuilder *ClassBuilder::Next(uint8_t *src, size_t count) {
-	size_t wrote;
-
+ClassBuilder *ClassBuilder::Skip(size_t count) {
 	writes += count;
-	if((wrote = fwrite(src, sizeof(uint8_t), count, output))
-			!= count * sizeof(uint8_t))
-		throw BuilderError(strerror(errno));
-	return this;
-}
-
-ClassBuilder *ClassBuilder::NextByte(uint8_t byte) {
-	size_t wrote;
-
-	writes++;
-	if((wrote = fwrite(&byte, 1, sizeof(uint8_t), output))
-			!= sizeof(uint8_t))
-		throw BuilderError(strerror(errno));
+	output.resize(output.size() + count);
 	return this;
 }
 
-ClassBuilder *ClassBuilder::NextShort(uint16_t word) {
-	size_t wrote;
-
-	writes++;
-	word = ToBigEndian(word);
-	if((wrote = fwrite(&word, 1, sizeof(uint16_t), output))
-			!= sizeof(uint16_t))
-		throw BuilderError(strerror(errno));
-	return this;
-}
-
-ClassBuilder *ClassBuilder::NextInt(uint32_t dword) {
-	size_t wrote;
-
-	writes++;
-	dword = ToBigEndian(dword);
-	if((wrote = fwrite(&dword, 1, sizeof(uint32_t), output))
-			!= sizeof(uint32_t))
-		throw BuilderError(strerror(errno));
+ClassBuilder *ClassBuilder::Next(const uint8_t *src, size_t count) {
+	writes += count;
+	output.insert(output.end(), src, src + count);
 	return this;
 }
 
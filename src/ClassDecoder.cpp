@@ -1,6 +1,8 @@
 
 # include "Debug.h"
 # include "ClassFile.h"
+# include "Arena.h"
+# include "MappedFile.h"
 # include "ErrorTypes.h"
 # include "MemberInfo.h"
 # include "ConstantInfo.h"
@@ -15,16 +17,26 @@ void ClassFile::DecodeConstants(ClassBuffer *buffer) {
 	debug_printf(level1, "Constant Pool Count : %d.\n", length);
 
 	// 0 is a NULL index.
+	constant_pool.reserve(length);
 	constant_pool.push_back(NULL);
 	for(unsigned idx = 1; idx < length; idx++) {
 		ConstantInfo *info;
 		debug_printf(level2, "Constant %d :\n", idx);
-		info = AddConstant(DecodeConstant(buffer));
+		info = DecodeConstant(buffer, options.producers);
+
+		// The second index of a "Long" constant must be in the pool.
+		if(info->IsLongConstant() && idx + 1 >= length) {
+			char tmp[64];
+			sprintf(tmp, "Long constant at index %u overflows the pool.", idx);
+			delete info;
+			throw DecodeError(tmp);
+		}
+
+		AddConstant(info);
 
 		// "Long" constants take up two indexes.
 		if(info->IsLongConstant()) {
 			debug_printf(level2, "Long Constant; Skipping index.\n");
-			constant_pool.push_back(NULL);
 			idx++;
 		}
 	}
@@ -49,6 +61,7 @@ void ClassFile::DecodeInterfaces(ClassBuffer *buffer) {
 
 	length = buffer->NextShort();
 	debug_printf(level1, "Interfaces Count : %d.\n", length);
+	interfaces.reserve(length);
 
 	for(unsigned idx = 0; idx < length; idx++) {
 		uint16_t index = buffer->NextShort();
@@ -63,6 +76,7 @@ void ClassFile::DecodeFields(ClassBuffer *buffer) {
 	// Fields Table
 	length = buffer->NextShort();
 	debug_printf(level1, "Fields Count : %d.\n", length);
+	fields.reserve(length);
 
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Field %d :\n", idx);
@@ -76,6 +90,7 @@ void ClassFile::DecodeMethods(ClassBuffer *buffer) {
 	// Methods Table
 	length = buffer->NextShort();
 	debug_printf(level1, "Methods Count : %d.\n", length);
+	methods.reserve(length);
 
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Method %d :\n", idx);
@@ -89,15 +104,29 @@ void ClassFile::DecodeAttributes(ClassBuffer *buffer) {
 	// Attributes Table
 	length = buffer->NextShort();
 	debug_printf(level1, "Attributes Count : %d.\n", length);
+	attributes.reserve(length);
 
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Attribute %d :\n", idx);
-		AddAttribute(DecodeAttribute(buffer, this), false);
+		if(AttributeInfo *info = DecodeAttribute(buffer, this)) {
+			AddAttribute(info, false);
+		}
 	}
 }
 
 void ClassFile::DecodeClassFile(ClassBuffer *buffer) {
-	uint32_t magic = buffer->NextInt();
+	uint32_t magic;
+
+	if(arena == NULL) {
+		// Decode into a private arena.
+		arena = new Arena;
+		owns_arena = true;
+	}
+
+	// Decoded objects are placed in the arena.
+	ArenaScope scope(arena);
+
+	magic = buffer->NextInt();
 	if(this->magic && this->magic != magic) {
 		char tmp[64];
 		sprintf(tmp, "Magic number mismatch; expected %#010X, got %#010X.",
@@ -105,8 +134,9 @@ void ClassFile::DecodeClassFile(ClassBuffer *buffer) {
 		throw DecodeError(tmp);
 	}
 
-	major_version = buffer->NextShort();
+	// The minor version precedes the major version.
 	minor_version = buffer->NextShort();
+	major_version = buffer->NextShort();
 
 	debug_printf(level0, "Magic : %#X.\n", magic);
 	debug_printf(level0, "Major Version : %d.\n", major_version);
@@ -119,34 +149,111 @@ void ClassFile::DecodeClassFile(ClassBuffer *buffer) {
 
 	DecodeClasses(buffer);
 	DecodeInterfaces(buffer);
+	if(options.depth == DECODE_HEADER) return;
 
 	DecodeFields(buffer);
 	DecodeMethods(buffer);
+	if(options.depth == DECODE_MEMBERS) return;
+
 	DecodeAttributes(buffer);
 }
 
-ClassFile *DecodeClassFile(FILE *source, uint32_t magic) {
-	ClassBuffer *buffer;
+static
+ClassFile *DecodeClassFile(ClassBuffer *buffer, const DecodeOptions &options) {
+	ClassFile *classFile = new ClassFile(options.arena);
 
 	try {
-		ClassFile *classFile;
-
-		debug_printf(level0, "Creating Class buffer.\n");
-		buffer = new ClassBuffer(source);
-
 		debug_printf(level0, "Decoding Class file :\n");
-		classFile = new ClassFile(buffer, magic);
+		classFile->magic = options.magic;
+		classFile->options = options;
+		classFile->DecodeClassFile(buffer);
 
 		debug_printf(level0, "Finished Class file.\n");
 		debug_printf(level3, "Reads made : %u.\n", buffer->GetReads());
 
-		delete buffer;
 		return classFile;
-	} catch(DecodeError &ex) {
-		// Rethrow after closing input.
-		delete buffer;
+	} catch(JBCError &ex) {
+		// Rethrow after releasing the partial class.
+		delete classFile;
+		throw;
+	}
+}
+
+static inline
+DecodeOptions MakeOptions(uint32_t magic, Arena *arena) {
+	DecodeOptions options;
+
+	options.magic = magic;
+	options.arena = arena;
+	return options;
+}
+
+ClassFile *DecodeClassFile(FILE *source, const DecodeOptions &options) {
+	debug_printf(level0, "Creating Class buffer.\n");
+	ClassBuffer buffer(source);
+
+	return DecodeClassFile(&buffer, options);
+}
+
+ClassFile *DecodeClassFile(FILE *source, uint32_t magic, Arena *arena) {
+	return DecodeClassFile(source, MakeOptions(magic, arena));
+}
+
+ClassFile *DecodeClassFile(const uint8_t *data, size_t size,
+		const DecodeOptions &options) {
+	debug_printf(level0, "Creating Class buffer over %zu bytes.\n", size);
+	ClassBuffer buffer(data, size);
+
+	return DecodeClassFile(&buffer, options);
+}
+
+ClassFile *DecodeClassFile(const uint8_t *data, size_t size, uint32_t magic,
+		Arena *arena) {
+	return DecodeClassFile(data, size, MakeOptions(magic, arena));
+}
+
+ClassFile *DecodeClassFileInPlace(const uint8_t *data, size_t size,
+		const DecodeOptions &options) {
+	debug_printf(level0, "Creating persistent Class buffer over %zu bytes.\n", size);
+	ClassBuffer buffer(data, size, true);
+
+	return DecodeClassFile(&buffer, options);
+}
+
+ClassFile *DecodeClassFileInPlace(const uint8_t *data, size_t size, uint32_t magic,
+		Arena *arena) {
+	return DecodeClassFileInPlace(data, size, MakeOptions(magic, arena));
+}
+
+ClassFile *DecodeClassFileMapped(const char *path, bool retain,
+		const DecodeOptions &options) {
+	ClassFile *classFile;
+
+	debug_printf(level0, "Mapping Class file : %s.\n", path);
+	MappedFile *mapping = new MappedFile(path);
+
+	try {
+		ClassBuffer buffer(mapping->Data(), mapping->Size(), retain);
+		classFile = DecodeClassFile(&buffer, options);
+	} catch(JBCError &ex) {
+		// Rethrow after unmapping input.
+		delete mapping;
 		throw;
 	}
+
+	if(retain) {
+		// Constants and code borrow from the mapping.
+		classFile->mapping = mapping;
+	} else {
+		delete mapping;
+	}
+
+	return classFile;
+}
+
+ClassFile *DecodeClassFileMapped(const char *path, bool retain, uint32_t magic,
+		Arena *arena) {
+	return DecodeClassFileMapped(path, retain, MakeOptions(magic, arena));
 }
 
 } /* JBC */
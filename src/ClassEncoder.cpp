@@ -5,6 +5,8 @@
 # include "MemberInfo.h"
 # include "ConstantInfo.h"
 # include "AttributeInfo.h"
+# include "FrameAnalysis.h"
+# include "StackAnalysis.h"
 
 namespace JBC {
 
@@ -106,14 +108,99 @@ void ClassFile::EncodeAttributes(ClassBuilder *builder) {
 	}
 }
 
+uint32_t ClassFile::ComputeSize() {
+	uint32_t size = 4 + 2 + 2;
+
+	// Constant Pool
+	size += 2;
+	for(unsigned idx = 1; idx < constant_pool.size(); idx++) {
+		ConstantInfo *info = constant_pool[idx];
+
+		size += info->ComputeSize();
+		if(info->IsLongConstant()) idx++;
+	}
+
+	// Flags, Classes, and Interfaces
+	size += 2 + 2 + 2;
+	size += 2 + 2 * interfaces.size();
+
+	// Fields Table
+	size += 2;
+	for(unsigned idx = 0; idx < fields.size(); idx++) {
+		size += fields[idx]->ComputeSize();
+	}
+
+	// Methods Table
+	size += 2;
+	for(unsigned idx = 0; idx < methods.size(); idx++) {
+		size += methods[idx]->ComputeSize();
+	}
+
+	return size + ComputeAttributesSize(attributes);
+}
+
+/**
+ * @brief Allows copying source bytes for the duration of one encode.
+ **/
+struct SourceReuseScope {
+	bool &reuse_source;
+
+	SourceReuseScope(bool &reuse_source, bool value)
+		: reuse_source(reuse_source) {
+		reuse_source = value;
+	}
+
+	~SourceReuseScope() {
+		// Cleared even if encoding fails.
+		reuse_source = false;
+	}
+};
+
+bool ClassFile::ConstantsInPlace() {
+	for(size_t idx = 1; idx < constant_pool.size(); idx++) {
+		if(constant_pool[idx] != NULL && constant_pool[idx]->index != idx) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 void ClassFile::EncodeClassFile(ClassBuilder *builder) {
+	if(options.depth != DECODE_FULL) {
+		throw EncodeError("Cannot encode a partially decoded class file.");
+	}
+
+	// Recompute values derived from modified code. Code still to be
+	// lazily loaded cannot have been modified.
+	if(compute & (COMPUTE_LIMITS | COMPUTE_FRAMES)) {
+		for(std::vector<MemberInfo *>::iterator itr = methods.begin();
+				itr != methods.end(); itr++) {
+			CodeAttribute *code = (*itr)->GetCode();
+			if(code == NULL || !code->IsModified()) continue;
+
+			UpdateCodeLimits(*itr, this);
+
+			// Frames are only used from version 50.
+			if((compute & COMPUTE_FRAMES) && major_version >= 50) {
+				ComputeStackMapFrames(*itr, this, hierarchy);
+			}
+		}
+	}
+
+	// Source bytes reference constants by index.
+	SourceReuseScope scope(reuse_source, ConstantsInPlace());
+
+	// Size the output once up front.
+	builder->Reserve(builder->Size() + ComputeSize());
+
 	debug_printf(level0, "Magic : %#X.\n", magic);
 	debug_printf(level0, "Major Version : %d.\n", major_version);
 	debug_printf(level0, "Minor Version : %d.\n", minor_version);
 
 	builder->NextInt(magic);
-	builder->NextShort(major_version);
 	builder->NextShort(minor_version);
+	builder->NextShort(major_version);
 
 	EncodeConstants(builder);
 
@@ -129,24 +216,29 @@ void ClassFile::EncodeClassFile(ClassBuilder *builder) {
 }
 
 void EncodeClassFile(FILE *source, ClassFile *classFile) {
-	ClassBuilder *builder;
+	debug_printf(level0, "Creating Class builder.\n");
+	ClassBuilder builder(source);
 
-	try {
-		debug_printf(level0, "Creating Class builder.\n");
-		builder = new ClassBuilder(source);
+	debug_printf(level0, "Encoding Class file :\n");
+	classFile->EncodeClassFile(&builder);
 
-		debug_printf(level0, "Encoding Class file :\n");
-		classFile->EncodeClassFile(builder);
+	debug_printf(level0, "Finished Class file.\n");
+	debug_printf(level3, "Writes made : %u.\n", builder.GetWrites());
 
-		debug_printf(level0, "Finished Class file.\n");
-		debug_printf(level3, "Writes made : %u.\n", builder->GetWrites());
+	// Output is closed with the builder.
+	builder.Flush();
+}
 
-		delete builder;
-	} catch(EncodeError &ex) {
-		// Rethrow after closing output.
-		delete builder;
-		throw;
-	}
+std::vector<uint8_t> EncodeClassFile(ClassFile *classFile) {
+	ClassBuilder builder;
+
+	debug_printf(level0, "Encoding Class file :\n");
+	classFile->EncodeClassFile(&builder);
+
+	debug_printf(level0, "Finished Class file.\n");
+	debug_printf(level3, "Writes made : %u.\n", builder.GetWrites());
+
+	return builder.Take();
 }
 
 } /* JBC */
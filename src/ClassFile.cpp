@@ -4,6 +4,8 @@
 
 # include "Debug.h"
 # include "ClassBuffer.h"
+# include "Arena.h"
+# include "MappedFile.h"
 
 # include "ClassFile.h"
 # include "MemberInfo.h"
@@ -14,16 +16,37 @@ namespace JBC {
 
 ClassFile::ClassFile()
 	: magic(0), major_version(0), minor_version(0),
-		access_flags(0), this_class(NULL), super_class(NULL) {
+		access_flags(0), this_class(NULL), super_class(NULL),
+		mapping(NULL), arena(NULL), compute(COMPUTE_NONE),
+		hierarchy(NULL), owns_arena(false), reuse_source(false) {
 }
 
 ClassFile::ClassFile(ClassBuffer *buffer, uint32_t magic)
 	: magic(magic), major_version(0), minor_version(0),
-		access_flags(0), this_class(NULL), super_class(NULL) {
-	this->DecodeClassFile(buffer);
+		access_flags(0), this_class(NULL), super_class(NULL),
+		mapping(NULL), arena(NULL), compute(COMPUTE_NONE),
+		hierarchy(NULL), owns_arena(false), reuse_source(false) {
+	try {
+		this->DecodeClassFile(buffer);
+	} catch(JBCError &ex) {
+		// The destructor does not run for a failed constructor.
+		Release();
+		throw;
+	}
+}
+
+ClassFile::ClassFile(Arena *arena)
+	: magic(0), major_version(0), minor_version(0),
+		access_flags(0), this_class(NULL), super_class(NULL),
+		mapping(NULL), arena(arena), compute(COMPUTE_NONE),
+		hierarchy(NULL), owns_arena(false), reuse_source(false) {
 }
 
 ClassFile::~ClassFile() {
+	Release();
+}
+
+void ClassFile::Release() {
 	// Clear interface list.
 	if(!interfaces.empty()) {
 		// These are disposed of later.
@@ -61,14 +84,161 @@ ClassFile::~ClassFile() {
 			delete *itr;
 		}
 	}
+
+	fields.clear();
+	methods.clear();
+	attributes.clear();
+	constant_pool.clear();
+
+	// Arena objects have been destroyed, but not freed.
+	if(arena != NULL && owns_arena) {
+		delete arena;
+		arena = NULL;
+	}
+
+	// Borrowed data is no longer referenced.
+	if(mapping != NULL) {
+		delete mapping;
+		mapping = NULL;
+	}
 }
 
 ConstantInfo *&ClassFile::AddConstant(ConstantInfo *info) {
-	uint16_t index = constant_pool.size();
+	size_t index = constant_pool.size();
+
+	if(index + (info != NULL && info->IsLongConstant()) > 0xFFFE) {
+		throw JBCError("Constant pool is full.");
+	}
+
 	constant_pool.push_back(info);
-	if(info) info->index = index;
+	if(info) {
+		info->index = index;
+
+		// "Long" constants take up two indexes.
+		if(info->IsLongConstant()) {
+			constant_pool.push_back(NULL);
+		}
+	}
+
+	constant_index.Append(constant_pool, info);
+	return constant_pool[index];
+}
+
+template<typename Constant>
+Constant *ClassFile::FindOrAdd(Constant &key) {
+	ConstantInfo *info = constant_index.Find(constant_pool, &key);
+
+	if(info == NULL) {
+		AddConstant(info = new Constant(key));
+	}
 
-	return constant_pool.back();
+	return static_cast<Constant *>(info);
+}
+
+ConstantUtf8Info *ClassFile::FindOrAddUtf8(std::string_view value) {
+	ConstantUtf8Info key;
+	ConstantInfo *info;
+
+	if(value.size() > 0xFFFF) {
+		throw JBCError("UTF-8 constant is too long.");
+	}
+
+	// The key only borrows the string.
+	key.bytes = (uint8_t *)value.data();
+	key.length = value.size();
+	key.borrowed = true;
+
+	if((info = constant_index.Find(constant_pool, &key)) == NULL) {
+		ConstantUtf8Info *utf8 = new ConstantUtf8Info;
+		utf8->SetBytes(key.bytes, key.length);
+
+		AddConstant(info = utf8);
+	}
+
+	return static_cast<ConstantUtf8Info *>(info);
+}
+
+ConstantClassInfo *ClassFile::FindOrAddClass(std::string_view name) {
+	ConstantClassInfo key;
+
+	key.name_index = FindOrAddUtf8(name)->index;
+	return FindOrAdd(key);
+}
+
+ConstantStringInfo *ClassFile::FindOrAddString(std::string_view value) {
+	ConstantStringInfo key;
+
+	key.string_index = FindOrAddUtf8(value)->index;
+	return FindOrAdd(key);
+}
+
+ConstantIntegerInfo *ClassFile::FindOrAddInteger(int32_t value) {
+	ConstantIntegerInfo key;
+
+	key.bytes = (uint32_t)value;
+	return FindOrAdd(key);
+}
+
+ConstantFloatInfo *ClassFile::FindOrAddFloat(float value) {
+	ConstantFloatInfo key;
+
+	memcpy(&key.bytes, &value, sizeof(key.bytes));
+	return FindOrAdd(key);
+}
+
+ConstantLongInfo *ClassFile::FindOrAddLong(int64_t value) {
+	ConstantLongInfo key;
+
+	key.high_bytes = (uint32_t)((uint64_t)value >> 32);
+	key.low_bytes = (uint32_t)value;
+	return FindOrAdd(key);
+}
+
+ConstantDoubleInfo *ClassFile::FindOrAddDouble(double value) {
+	ConstantDoubleInfo key;
+	uint64_t bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+	key.high_bytes = (uint32_t)(bits >> 32);
+	key.low_bytes = (uint32_t)bits;
+	return FindOrAdd(key);
+}
+
+ConstantNameAndTypeInfo *ClassFile::FindOrAddNameAndType(std::string_view name,
+		std::string_view descriptor) {
+	ConstantNameAndTypeInfo key;
+
+	key.name_index = FindOrAddUtf8(name)->index;
+	key.descriptor_index = FindOrAddUtf8(descriptor)->index;
+	return FindOrAdd(key);
+}
+
+ConstantFieldRefInfo *ClassFile::FindOrAddFieldRef(std::string_view owner,
+		std::string_view name, std::string_view descriptor) {
+	ConstantFieldRefInfo key;
+
+	key.class_index = FindOrAddClass(owner)->index;
+	key.name_and_type_index = FindOrAddNameAndType(name, descriptor)->index;
+	return FindOrAdd(key);
+}
+
+ConstantMethodRefInfo *ClassFile::FindOrAddMethodRef(std::string_view owner,
+		std::string_view name, std::string_view descriptor) {
+	ConstantMethodRefInfo key;
+
+	key.class_index = FindOrAddClass(owner)->index;
+	key.name_and_type_index = FindOrAddNameAndType(name, descriptor)->index;
+	return FindOrAdd(key);
+}
+
+ConstantInterfaceMethodRefInfo *ClassFile::FindOrAddInterfaceMethodRef(
+		std::string_view owner, std::string_view name,
+		std::string_view descriptor) {
+	ConstantInterfaceMethodRefInfo key;
+
+	key.class_index = FindOrAddClass(owner)->index;
+	key.name_and_type_index = FindOrAddNameAndType(name, descriptor)->index;
+	return FindOrAdd(key);
 }
 
 ConstantClassInfo *&ClassFile::AddInterface(ConstantClassInfo *info) {
@@ -78,40 +248,58 @@ ConstantClassInfo *&ClassFile::AddInterface(ConstantClassInfo *info) {
 
 MemberInfo *&ClassFile::AddField(MemberInfo *field) {
 	fields.push_back(field);
+	field_index.Append(fields);
+
 	return fields.back();
 }
 
-MemberInfo *&ClassFile::FindField(std::string &name) {
-	if(!fields.empty()) {
-		// TODO : Consider a more efficient way of going about this.
-		for(std::vector<MemberInfo *>::iterator itr = fields.begin();
-				itr != fields.end(); itr++) {
-			if((*itr)->Name() == name) {
-				return *itr;
-			}
-		}
+MemberInfo *&ClassFile::FindField(std::string_view name) {
+	MemberInfo **field = field_index.Find(fields, name);
+
+	if(field == NULL) {
+		throw NotFoundError("Requested field not found.");
+	}
+
+	return *field;
+}
+
+MemberInfo *&ClassFile::FindField(std::string_view name,
+		std::string_view descriptor) {
+	MemberInfo **field = field_index.Find(fields, name, descriptor);
+
+	if(field == NULL) {
+		throw NotFoundError("Requested field not found.");
 	}
 
-	throw NotFoundError("Requested field not found.");
+	return *field;
 }
 
 MemberInfo *&ClassFile::AddMethod(MemberInfo *method) {
 	methods.push_back(method);
+	method_index.Append(methods);
+
 	return methods.back();
 }
 
-MemberInfo *&ClassFile::FindMethod(std::string &name) {
-	if(!methods.empty()) {
-		// TODO : Consider a more efficient way of going about this.
-		for(std::vector<MemberInfo *>::iterator itr = methods.begin();
-				itr != methods.end(); itr++) {
-			if((*itr)->Name() == name) {
-				return *itr;
-			}
-		}
+MemberInfo *&ClassFile::FindMethod(std::string_view name) {
+	MemberInfo **method = method_index.Find(methods, name);
+
+	if(method == NULL) {
+		throw NotFoundError("Requested method not found.");
+	}
+
+	return *method;
+}
+
+MemberInfo *&ClassFile::FindMethod(std::string_view name,
+		std::string_view descriptor) {
+	MemberInfo **method = method_index.Find(methods, name, descriptor);
+
+	if(method == NULL) {
+		throw NotFoundError("Requested method not found.");
 	}
 
-	throw NotFoundError("Requested field not found.");
+	return *method;
 }
 
 AttributeInfo *&ClassFile::AddAttribute(AttributeInfo *info, bool validate) {
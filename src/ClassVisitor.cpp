@@ -0,0 +1,285 @@
+
+# include <stdio.h>
+
+# include "ClassBuffer.h"
+# include "ErrorTypes.h"
+# include "ConstantInfo.h"
+# include "ClassVisitor.h"
+
+namespace JBC {
+
+static inline
+uint16_t ReadShort(const uint8_t *src) {
+	return (src[0] << 8) | src[1];
+}
+
+static
+void ThrowInvalidIndex(const char *kind, uint32_t index) {
+	char tmp[64];
+	sprintf(tmp, "Invalid %s constant index : %u.", kind, index);
+	throw DecodeError(tmp);
+}
+
+ClassVisitor::ClassVisitor(ClassVisitor *next)
+		: next(next) {
+}
+
+ClassVisitor::~ClassVisitor() {
+}
+
+void ClassVisitor::VisitHeader(uint32_t magic, uint16_t minor_version, uint16_t major_version) {
+	if(next != NULL) next->VisitHeader(magic, minor_version, major_version);
+}
+
+void ClassVisitor::VisitConstant(const ConstantView &constant) {
+	if(next != NULL) next->VisitConstant(constant);
+}
+
+void ClassVisitor::VisitClass(const ClassView &info) {
+	if(next != NULL) next->VisitClass(info);
+}
+
+bool ClassVisitor::VisitField(const MemberView &field) {
+	return next == NULL || next->VisitField(field);
+}
+
+bool ClassVisitor::VisitMethod(const MemberView &method) {
+	return next == NULL || next->VisitMethod(method);
+}
+
+void ClassVisitor::VisitAttribute(const AttributeView &attribute) {
+	if(next != NULL) next->VisitAttribute(attribute);
+}
+
+bool ClassVisitor::VisitCode(const CodeView &code) {
+	return next == NULL || next->VisitCode(code);
+}
+
+void ClassVisitor::VisitInstruction(const Instruction &insn) {
+	if(next != NULL) next->VisitInstruction(insn);
+}
+
+void ClassVisitor::VisitTryCatch(uint16_t start_pc, uint16_t end_pc,
+		uint16_t handler_pc, uint16_t catch_type) {
+	if(next != NULL) next->VisitTryCatch(start_pc, end_pc, handler_pc, catch_type);
+}
+
+void ClassVisitor::VisitMemberEnd() {
+	if(next != NULL) next->VisitMemberEnd();
+}
+
+void ClassVisitor::VisitEnd() {
+	if(next != NULL) next->VisitEnd();
+}
+
+uint8_t ClassReader::ConstantTag(uint32_t index) const {
+	if(index >= constants.size() || constants[index] == NULL) {
+		return 0;
+	}
+
+	return constants[index][0];
+}
+
+std::string_view ClassReader::Utf8(uint32_t index) const {
+	if(ConstantTag(index) != CONSTANT_UTF8) {
+		ThrowInvalidIndex("UTF8", index);
+	}
+
+	const uint8_t *src = constants[index];
+	return std::string_view((const char *)src + 3, ReadShort(src + 1));
+}
+
+std::string_view ClassReader::ClassName(uint32_t index) const {
+	if(ConstantTag(index) != CONSTANT_CLASS) {
+		ThrowInvalidIndex("class", index);
+	}
+
+	return Utf8(ReadShort(constants[index] + 1));
+}
+
+void ClassReader::Accept(ClassBuffer *buffer, ClassVisitor *visitor) {
+	uint32_t magic = buffer->NextInt();
+	uint16_t minor_version = buffer->NextShort();
+	uint16_t major_version = buffer->NextShort();
+
+	visitor->VisitHeader(magic, minor_version, major_version);
+	AcceptConstants(buffer, visitor);
+
+	ClassView info;
+	info.access_flags = buffer->NextShort();
+	info.this_class = buffer->NextShort();
+	info.super_class = buffer->NextShort();
+	info.name = ClassName(info.this_class);
+	info.super_name = info.super_class != 0 ? ClassName(info.super_class) : "";
+	info.interfaces_count = buffer->NextShort();
+	info.interfaces = buffer->Borrow(2 * info.interfaces_count);
+	visitor->VisitClass(info);
+
+	uint16_t fields_count = buffer->NextShort();
+	for(unsigned idx = 0; idx < fields_count; idx++) {
+		AcceptMember(buffer, visitor, false);
+	}
+
+	uint16_t methods_count = buffer->NextShort();
+	for(unsigned idx = 0; idx < methods_count; idx++) {
+		AcceptMember(buffer, visitor, true);
+	}
+
+	uint16_t attributes_count = buffer->NextShort();
+	AcceptAttributes(buffer, visitor, attributes_count, false);
+	visitor->VisitEnd();
+}
+
+void ClassReader::AcceptConstants(ClassBuffer *buffer, ClassVisitor *visitor) {
+	uint16_t constant_pool_count = buffer->NextShort();
+
+	// Slot 0 is never used.
+	constants.assign(constant_pool_count, NULL);
+
+	for(unsigned idx = 1; idx < constant_pool_count; idx++) {
+		const uint8_t *src = buffer->Current();
+		ConstantView constant;
+		uint32_t length;
+
+		constant.index = idx;
+		constant.tag = buffer->NextByte();
+
+		switch(constant.tag) {
+			case CONSTANT_UTF8:
+				length = 2 + ReadShort(buffer->Borrow(2));
+				buffer->Skip(length - 2);
+				break;
+			case CONSTANT_METHOD_HANDLE:
+				length = 3;
+				break;
+			case CONSTANT_CLASS:
+			case CONSTANT_STRING:
+			case CONSTANT_METHOD_TYPE:
+				length = 2;
+				break;
+			case CONSTANT_INTEGER:
+			case CONSTANT_FLOAT:
+			case CONSTANT_FIELD_REF:
+			case CONSTANT_METHOD_REF:
+			case CONSTANT_INTERFACE_METHOD_REF:
+			case CONSTANT_NAME_AND_TYPE:
+			case CONSTANT_INVOKE_DYNAMIC:
+				length = 4;
+				break;
+			case CONSTANT_LONG:
+			case CONSTANT_DOUBLE:
+				length = 8;
+				break;
+			default: {
+				// Custom constants have no known size.
+				char message[64];
+				sprintf(message, "Unknown tag : %d (%zu).\n", constant.tag, buffer->Position());
+				throw DecodeError(message);
+			}
+		}
+
+		if(constant.tag != CONSTANT_UTF8) {
+			buffer->Skip(length);
+		}
+
+		constant.data = src + 1;
+		constant.length = length;
+		constants[idx] = src;
+
+		visitor->VisitConstant(constant);
+
+		// Long and Double constants take two slots.
+		if(constant.tag == CONSTANT_LONG || constant.tag == CONSTANT_DOUBLE) {
+			idx++;
+		}
+	}
+}
+
+void ClassReader::AcceptMember(ClassBuffer *buffer, ClassVisitor *visitor, bool method) {
+	MemberView member;
+	bool visit;
+
+	member.access_flags = buffer->NextShort();
+	member.name_index = buffer->NextShort();
+	member.descriptor_index = buffer->NextShort();
+	member.name = Utf8(member.name_index);
+	member.descriptor = Utf8(member.descriptor_index);
+	member.attributes_count = buffer->NextShort();
+
+	if(method) {
+		visit = visitor->VisitMethod(member);
+	} else {
+		visit = visitor->VisitField(member);
+	}
+
+	if(visit) {
+		AcceptAttributes(buffer, visitor, member.attributes_count, method);
+	} else {
+		for(unsigned idx = 0; idx < member.attributes_count; idx++) {
+			buffer->Skip(2);
+			buffer->Skip(buffer->NextInt());
+		}
+	}
+
+	// Closes the member even when it was skipped.
+	visitor->VisitMemberEnd();
+}
+
+void ClassReader::AcceptAttributes(ClassBuffer *buffer, ClassVisitor *visitor,
+		uint16_t attributes_count, bool method) {
+	for(unsigned idx = 0; idx < attributes_count; idx++) {
+		AttributeView attribute;
+
+		attribute.name_index = buffer->NextShort();
+		attribute.name = Utf8(attribute.name_index);
+		attribute.length = buffer->NextInt();
+		attribute.data = buffer->Borrow(attribute.length);
+
+		if(method && attribute.name == "Code") {
+			AcceptCode(attribute, visitor);
+		} else {
+			visitor->VisitAttribute(attribute);
+		}
+	}
+}
+
+void ClassReader::AcceptCode(const AttributeView &attribute, ClassVisitor *visitor) {
+	ClassBuffer buffer(attribute.data, attribute.length);
+	CodeView code;
+
+	code.attribute = attribute;
+	code.max_stack = buffer.NextShort();
+	code.max_locals = buffer.NextShort();
+	code.code_length = buffer.NextInt();
+	code.code = buffer.Borrow(code.code_length);
+	code.exception_table_length = buffer.NextShort();
+	code.exception_table = buffer.Borrow(8 * code.exception_table_length);
+	code.attributes_count = buffer.NextShort();
+	code.attributes = buffer.Current();
+
+	// Check the nested attributes fit.
+	for(unsigned idx = 0; idx < code.attributes_count; idx++) {
+		buffer.Skip(2);
+		buffer.Skip(buffer.NextInt());
+	}
+
+	if(!visitor->VisitCode(code)) {
+		return;
+	}
+
+	InstructionIterator itr(code.code, code.code_length);
+	Instruction insn;
+
+	while(itr.Next(insn)) {
+		visitor->VisitInstruction(insn);
+	}
+
+	for(unsigned idx = 0; idx < code.exception_table_length; idx++) {
+		const uint8_t *src = code.exception_table + 8 * idx;
+
+		visitor->VisitTryCatch(ReadShort(src), ReadShort(src + 2),
+				ReadShort(src + 4), ReadShort(src + 6));
+	}
+}
+
+} /* JBC */
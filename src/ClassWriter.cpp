@@ -0,0 +1,280 @@
+
+# include <stdio.h>
+
+# include "ErrorTypes.h"
+# include "ConstantInfo.h"
+# include "ClassWriter.h"
+
+namespace JBC {
+
+ClassWriter::ClassWriter(ClassBuilder *output)
+		: output(output), magic(0), minor_version(0), major_version(0),
+		constant_count(1), indexed(false), section(SECTION_FIELDS),
+		count(0), count_position(0), member_attributes(0),
+		member_attributes_position(0), in_member(false) {
+}
+
+void ClassWriter::VisitHeader(uint32_t magic, uint16_t minor_version, uint16_t major_version) {
+	this->magic = magic;
+	this->minor_version = minor_version;
+	this->major_version = major_version;
+
+	pool.Reset();
+	body.Reset();
+	offsets.clear();
+	entries.clear();
+
+	constant_count = 1;
+	indexed = false;
+	in_member = false;
+}
+
+void ClassWriter::VisitConstant(const ConstantView &constant) {
+	if(constant.index != constant_count) {
+		char tmp[64];
+		sprintf(tmp, "Constant %hu forwarded out of order.", constant.index);
+		throw BuilderError(tmp);
+	}
+
+	offsets.push_back(pool.Position());
+	pool.NextByte(constant.tag);
+	pool.Next(constant.data, constant.length);
+
+	constant_count++;
+	if(constant.tag == CONSTANT_LONG || constant.tag == CONSTANT_DOUBLE) {
+		offsets.push_back(pool.Position());
+		constant_count++;
+	}
+}
+
+void ClassWriter::VisitClass(const ClassView &info) {
+	body.NextShort(info.access_flags);
+	body.NextShort(info.this_class);
+	body.NextShort(info.super_class);
+	body.NextShort(info.interfaces_count);
+	body.Next(info.interfaces, 2 * info.interfaces_count);
+
+	// The fields count follows.
+	section = SECTION_FIELDS;
+	count = 0;
+	count_position = body.Position();
+	body.Skip(2);
+}
+
+bool ClassWriter::VisitField(const MemberView &field) {
+	Enter(SECTION_FIELDS);
+	WriteMember(field);
+	return true;
+}
+
+bool ClassWriter::VisitMethod(const MemberView &method) {
+	Enter(SECTION_METHODS);
+	WriteMember(method);
+	return true;
+}
+
+void ClassWriter::VisitAttribute(const AttributeView &attribute) {
+	if(in_member) {
+		member_attributes++;
+	} else {
+		Enter(SECTION_ATTRIBUTES);
+		count++;
+	}
+
+	body.NextShort(attribute.name_index);
+	body.NextInt(attribute.length);
+	body.Next(attribute.data, attribute.length);
+}
+
+bool ClassWriter::VisitCode(const CodeView &code) {
+	VisitAttribute(code.attribute);
+
+	// The code is copied whole.
+	return false;
+}
+
+void ClassWriter::VisitMemberEnd() {
+	// The member may have been dropped before reaching this writer.
+	CloseMember();
+}
+
+void ClassWriter::VisitEnd() {
+	CloseMember();
+	Enter(SECTION_ATTRIBUTES);
+	WriteCount(count_position, count, "Attributes");
+
+	if(constant_count > 0xFFFF) {
+		throw BuilderError("Constant pool exceeds 65535 entries.");
+	}
+
+	output->Reserve(output->Size() + 10 + pool.Size() + body.Size());
+	output->NextInt(magic);
+	output->NextShort(minor_version);
+	output->NextShort(major_version);
+	output->NextShort(constant_count);
+	output->Next(pool.Data(), pool.Size());
+	output->Next(body.Data(), body.Size());
+}
+
+void ClassWriter::Enter(Section section) {
+	CloseMember();
+	if(this->section > section) {
+		throw BuilderError("Class members visited out of order.");
+	}
+
+	// Close each section up to the one entered.
+	while(this->section < section) {
+		if(this->section == SECTION_FIELDS) {
+			WriteCount(count_position, count, "Fields");
+			this->section = SECTION_METHODS;
+		} else {
+			WriteCount(count_position, count, "Methods");
+			this->section = SECTION_ATTRIBUTES;
+		}
+
+		count = 0;
+		count_position = body.Position();
+		body.Skip(2);
+	}
+}
+
+void ClassWriter::WriteMember(const MemberView &member) {
+	CloseMember();
+	count++;
+
+	body.NextShort(member.access_flags);
+	body.NextShort(member.name_index);
+	body.NextShort(member.descriptor_index);
+
+	in_member = true;
+	member_attributes = 0;
+	member_attributes_position = body.Position();
+	body.Skip(2);
+}
+
+void ClassWriter::CloseMember() {
+	if(in_member) {
+		WriteCount(member_attributes_position, member_attributes, "Attributes");
+		in_member = false;
+	}
+}
+
+void ClassWriter::WriteCount(size_t position, uint32_t count, const char *kind) {
+	if(count > 0xFFFF) {
+		char tmp[64];
+		sprintf(tmp, "%s count exceeds 65535.", kind);
+		throw BuilderError(tmp);
+	}
+
+	body.PatchShort(position, count);
+}
+
+void ClassWriter::IndexConstants() {
+	const uint8_t *data = pool.Data();
+
+	for(uint32_t idx = 0; idx < offsets.size(); idx++) {
+		uint32_t start = offsets[idx];
+		uint32_t end = idx + 1 < offsets.size() ? offsets[idx + 1] : pool.Size();
+
+		// The second slot of a wide constant is empty.
+		if(start == end) continue;
+
+		std::string key((const char *)data + start, end - start);
+		entries.insert(std::make_pair(key, idx + 1));
+	}
+
+	indexed = true;
+}
+
+uint16_t ClassWriter::FindOrAdd(uint8_t tag, const uint8_t *data, uint32_t length) {
+	if(!indexed) {
+		IndexConstants();
+	}
+
+	std::string key(1, (char)tag);
+	key.append((const char *)data, length);
+
+	std::unordered_map<std::string, uint16_t>::iterator itr = entries.find(key);
+	if(itr != entries.end()) {
+		return itr->second;
+	}
+
+	uint32_t slots = (tag == CONSTANT_LONG || tag == CONSTANT_DOUBLE) ? 2 : 1;
+	if(constant_count + slots > 0xFFFF) {
+		throw BuilderError("Constant pool exceeds 65535 entries.");
+	}
+
+	uint16_t index = constant_count;
+	pool.Next((const uint8_t *)key.data(), key.size());
+	entries.insert(std::make_pair(key, index));
+	constant_count += slots;
+
+	return index;
+}
+
+uint16_t ClassWriter::FindOrAddUtf8(std::string_view value) {
+	if(value.size() > 0xFFFF) {
+		throw BuilderError("UTF8 constant exceeds 65535 bytes.");
+	}
+
+	std::string data(2, '\0');
+	data[0] = (char)(value.size() >> 8);
+	data[1] = (char)value.size();
+	data.append(value);
+
+	return FindOrAdd(CONSTANT_UTF8, (const uint8_t *)data.data(), data.size());
+}
+
+uint16_t ClassWriter::FindOrAddClass(std::string_view name) {
+	uint16_t index = FindOrAddUtf8(name);
+	uint8_t data[2] = { (uint8_t)(index >> 8), (uint8_t)index };
+
+	return FindOrAdd(CONSTANT_CLASS, data, 2);
+}
+
+uint16_t ClassWriter::FindOrAddString(std::string_view value) {
+	uint16_t index = FindOrAddUtf8(value);
+	uint8_t data[2] = { (uint8_t)(index >> 8), (uint8_t)index };
+
+	return FindOrAdd(CONSTANT_STRING, data, 2);
+}
+
+uint16_t ClassWriter::FindOrAddNameAndType(std::string_view name, std::string_view descriptor) {
+	uint16_t name_index = FindOrAddUtf8(name);
+	uint16_t descriptor_index = FindOrAddUtf8(descriptor);
+	uint8_t data[4] = {
+		(uint8_t)(name_index >> 8), (uint8_t)name_index,
+		(uint8_t)(descriptor_index >> 8), (uint8_t)descriptor_index
+	};
+
+	return FindOrAdd(CONSTANT_NAME_AND_TYPE, data, 4);
+}
+
+uint16_t ClassWriter::FindOrAddReference(uint8_t tag, std::string_view owner,
+		std::string_view name, std::string_view descriptor) {
+	uint16_t class_index = FindOrAddClass(owner);
+	uint16_t name_and_type_index = FindOrAddNameAndType(name, descriptor);
+	uint8_t data[4] = {
+		(uint8_t)(class_index >> 8), (uint8_t)class_index,
+		(uint8_t)(name_and_type_index >> 8), (uint8_t)name_and_type_index
+	};
+
+	return FindOrAdd(tag, data, 4);
+}
+
+uint16_t ClassWriter::FindOrAddFieldRef(std::string_view owner,
+		std::string_view name, std::string_view descriptor) {
+	return FindOrAddReference(CONSTANT_FIELD_REF, owner, name, descriptor);
+}
+
+uint16_t ClassWriter::FindOrAddMethodRef(std::string_view owner,
+		std::string_view name, std::string_view descriptor) {
+	return FindOrAddReference(CONSTANT_METHOD_REF, owner, name, descriptor);
+}
+
+uint16_t ClassWriter::FindOrAddInterfaceMethodRef(std::string_view owner,
+		std::string_view name, std::string_view descriptor) {
+	return FindOrAddReference(CONSTANT_INTERFACE_METHOD_REF, owner, name, descriptor);
+}
+
+} /* JBC */
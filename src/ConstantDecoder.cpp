@@ -1,18 +1,15 @@
 
-# include <map>
 
 # include "Debug.h"
 # include "ConstantInfo.h"
+# include "ProducerRegistry.h"
 
 namespace JBC {
 
 /* Constant Producers */
 
-static
-std::map<uint8_t, ConstantProducer> producer_map;
-
 void RegisterProducer(uint8_t tag, ConstantProducer producer) {
-	producer_map[tag] = producer;
+	ProducerRegistry::Global().Register(tag, producer);
 }
 
 /* Constant Decoders */
@@ -22,11 +19,23 @@ ConstantUtf8Info *ConstantUtf8Info
 	length = buffer->NextShort();
 	debug_printf(level3, "Constant Length : %d.\n", length);
 
-	bytes = new uint8_t[length + 1];
-	buffer->Next(bytes, length);
-	bytes[length] = '\0';
+	if(buffer->IsPersistent()) {
+		// Reference the source directly.
+		bytes = const_cast<uint8_t *>(buffer->Borrow(length));
+		borrowed = true;
+	} else if(Arena *arena = Arena::Current()) {
+		// Released along with the arena.
+		bytes = (uint8_t *)arena->Allocate(length + 1);
+		buffer->Next(bytes, length);
+		bytes[length] = '\0';
+		borrowed = true;
+	} else {
+		bytes = new uint8_t[length + 1];
+		buffer->Next(bytes, length);
+		bytes[length] = '\0';
+	}
 
-	debug_printf(level3, "Constant Data : %s.\n", bytes);
+	debug_printf(level3, "Constant Data : %.*s.\n", length, bytes);
 	return this;
 }
 
@@ -116,7 +125,7 @@ ConstantInvokeDynamicInfo *ConstantInvokeDynamicInfo
 	return this;
 }
 
-ConstantInfo *DecodeConstant(ClassBuffer *buffer) {
+ConstantInfo *DecodeConstant(ClassBuffer *buffer, const ProducerRegistry *producers) {
 	uint8_t tag = buffer->NextByte();
 
 	switch(tag) {
@@ -163,7 +172,16 @@ ConstantInfo *DecodeConstant(ClassBuffer *buffer) {
 			debug_printf(level2, "Constant Invoke Dynamic.\n");
 			return (new ConstantInvokeDynamicInfo)->DecodeConstant(buffer);
 		default: {
-			ConstantProducer producer = producer_map[tag];
+			ConstantProducer producer = NULL;
+
+			// Context producers take precedence.
+			if(producers != NULL) {
+				producer = producers->Find(tag);
+			}
+
+			if(producer == NULL) {
+				producer = ProducerRegistry::Global().Find(tag);
+			}
 
 			// Create a Constant from a Producer
 			if(producer != NULL) {
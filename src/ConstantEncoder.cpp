@@ -6,6 +6,13 @@
 
 namespace JBC {
 
+uint32_t ConstantInfo::ComputeSize() {
+	ClassBuilder scratch;
+
+	EncodeConstant(&scratch);
+	return scratch.Size();
+}
+
 ConstantUtf8Info *ConstantUtf8Info
 		::EncodeConstant(ClassBuilder *builder) {
 	debug_printf(level2, "Encoding Constant UTF8.\n");
@@ -0,0 +1,227 @@
+
+# include <functional>
+# include <string_view>
+
+# include "ConstantInfo.h"
+# include "ConstantIndex.h"
+
+namespace JBC {
+
+static inline
+size_t Combine(size_t hash, size_t value) {
+	return hash ^ (value + 0x9E3779B9 + (hash << 6) + (hash >> 2));
+}
+
+// Hashes a standard constant; returns false for other types.
+static
+bool HashConstant(ConstantInfo *info, size_t &hash) {
+	hash = info->tag;
+
+	switch(info->tag) {
+		case CONSTANT_UTF8:
+			hash = Combine(hash, std::hash<std::string_view>()(
+					static_cast<ConstantUtf8Info *>(info)->View()));
+			return true;
+		case CONSTANT_INTEGER:
+			hash = Combine(hash, static_cast<ConstantIntegerInfo *>(info)->bytes);
+			return true;
+		case CONSTANT_FLOAT:
+			hash = Combine(hash, static_cast<ConstantFloatInfo *>(info)->bytes);
+			return true;
+		case CONSTANT_LONG: {
+			ConstantLongInfo *value = static_cast<ConstantLongInfo *>(info);
+			hash = Combine(Combine(hash, value->high_bytes), value->low_bytes);
+			return true;
+		}
+		case CONSTANT_DOUBLE: {
+			ConstantDoubleInfo *value = static_cast<ConstantDoubleInfo *>(info);
+			hash = Combine(Combine(hash, value->high_bytes), value->low_bytes);
+			return true;
+		}
+		case CONSTANT_CLASS:
+			hash = Combine(hash, static_cast<ConstantClassInfo *>(info)->name_index);
+			return true;
+		case CONSTANT_STRING:
+			hash = Combine(hash, static_cast<ConstantStringInfo *>(info)->string_index);
+			return true;
+		case CONSTANT_FIELD_REF: {
+			ConstantFieldRefInfo *ref = static_cast<ConstantFieldRefInfo *>(info);
+			hash = Combine(Combine(hash, ref->class_index), ref->name_and_type_index);
+			return true;
+		}
+		case CONSTANT_METHOD_REF: {
+			ConstantMethodRefInfo *ref = static_cast<ConstantMethodRefInfo *>(info);
+			hash = Combine(Combine(hash, ref->class_index), ref->name_and_type_index);
+			return true;
+		}
+		case CONSTANT_INTERFACE_METHOD_REF: {
+			ConstantInterfaceMethodRefInfo *ref =
+					static_cast<ConstantInterfaceMethodRefInfo *>(info);
+			hash = Combine(Combine(hash, ref->class_index), ref->name_and_type_index);
+			return true;
+		}
+		case CONSTANT_NAME_AND_TYPE: {
+			ConstantNameAndTypeInfo *pair = static_cast<ConstantNameAndTypeInfo *>(info);
+			hash = Combine(Combine(hash, pair->name_index), pair->descriptor_index);
+			return true;
+		}
+		case CONSTANT_METHOD_HANDLE: {
+			ConstantMethodHandleInfo *handle = static_cast<ConstantMethodHandleInfo *>(info);
+			hash = Combine(Combine(hash, handle->reference_kind), handle->reference_index);
+			return true;
+		}
+		case CONSTANT_METHOD_TYPE:
+			hash = Combine(hash, static_cast<ConstantMethodTypeInfo *>(info)->descriptor_index);
+			return true;
+		case CONSTANT_INVOKE_DYNAMIC: {
+			ConstantInvokeDynamicInfo *call = static_cast<ConstantInvokeDynamicInfo *>(info);
+			hash = Combine(Combine(hash, call->bootstrap_method_attr_index),
+					call->name_and_type_index);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+// Compares two standard constants of the same type.
+static
+bool EqualConstants(ConstantInfo *left, ConstantInfo *right) {
+	if(left->tag != right->tag) {
+		return false;
+	}
+
+	switch(left->tag) {
+		case CONSTANT_UTF8:
+			return static_cast<ConstantUtf8Info *>(left)->View()
+					== static_cast<ConstantUtf8Info *>(right)->View();
+		case CONSTANT_INTEGER:
+			return static_cast<ConstantIntegerInfo *>(left)->bytes
+					== static_cast<ConstantIntegerInfo *>(right)->bytes;
+		case CONSTANT_FLOAT:
+			return static_cast<ConstantFloatInfo *>(left)->bytes
+					== static_cast<ConstantFloatInfo *>(right)->bytes;
+		case CONSTANT_LONG: {
+			ConstantLongInfo *a = static_cast<ConstantLongInfo *>(left);
+			ConstantLongInfo *b = static_cast<ConstantLongInfo *>(right);
+			return a->high_bytes == b->high_bytes && a->low_bytes == b->low_bytes;
+		}
+		case CONSTANT_DOUBLE: {
+			ConstantDoubleInfo *a = static_cast<ConstantDoubleInfo *>(left);
+			ConstantDoubleInfo *b = static_cast<ConstantDoubleInfo *>(right);
+			return a->high_bytes == b->high_bytes && a->low_bytes == b->low_bytes;
+		}
+		case CONSTANT_CLASS:
+			return static_cast<ConstantClassInfo *>(left)->name_index
+					== static_cast<ConstantClassInfo *>(right)->name_index;
+		case CONSTANT_STRING:
+			return static_cast<ConstantStringInfo *>(left)->string_index
+					== static_cast<ConstantStringInfo *>(right)->string_index;
+		case CONSTANT_FIELD_REF: {
+			ConstantFieldRefInfo *a = static_cast<ConstantFieldRefInfo *>(left);
+			ConstantFieldRefInfo *b = static_cast<ConstantFieldRefInfo *>(right);
+			return a->class_index == b->class_index
+					&& a->name_and_type_index == b->name_and_type_index;
+		}
+		case CONSTANT_METHOD_REF: {
+			ConstantMethodRefInfo *a = static_cast<ConstantMethodRefInfo *>(left);
+			ConstantMethodRefInfo *b = static_cast<ConstantMethodRefInfo *>(right);
+			return a->class_index == b->class_index
+					&& a->name_and_type_index == b->name_and_type_index;
+		}
+		case CONSTANT_INTERFACE_METHOD_REF: {
+			ConstantInterfaceMethodRefInfo *a =
+					static_cast<ConstantInterfaceMethodRefInfo *>(left);
+			ConstantInterfaceMethodRefInfo *b =
+					static_cast<ConstantInterfaceMethodRefInfo *>(right);
+			return a->class_index == b->class_index
+					&& a->name_and_type_index == b->name_and_type_index;
+		}
+		case CONSTANT_NAME_AND_TYPE: {
+			ConstantNameAndTypeInfo *a = static_cast<ConstantNameAndTypeInfo *>(left);
+			ConstantNameAndTypeInfo *b = static_cast<ConstantNameAndTypeInfo *>(right);
+			return a->name_index == b->name_index
+					&& a->descriptor_index == b->descriptor_index;
+		}
+		case CONSTANT_METHOD_HANDLE: {
+			ConstantMethodHandleInfo *a = static_cast<ConstantMethodHandleInfo *>(left);
+			ConstantMethodHandleInfo *b = static_cast<ConstantMethodHandleInfo *>(right);
+			return a->reference_kind == b->reference_kind
+					&& a->reference_index == b->reference_index;
+		}
+		case CONSTANT_METHOD_TYPE:
+			return static_cast<ConstantMethodTypeInfo *>(left)->descriptor_index
+					== static_cast<ConstantMethodTypeInfo *>(right)->descriptor_index;
+		case CONSTANT_INVOKE_DYNAMIC: {
+			ConstantInvokeDynamicInfo *a = static_cast<ConstantInvokeDynamicInfo *>(left);
+			ConstantInvokeDynamicInfo *b = static_cast<ConstantInvokeDynamicInfo *>(right);
+			return a->bootstrap_method_attr_index == b->bootstrap_method_attr_index
+					&& a->name_and_type_index == b->name_and_type_index;
+		}
+		default:
+			return false;
+	}
+}
+
+void ConstantIndex::Rebuild(std::vector<ConstantInfo *> &pool) {
+	size_t hash;
+
+	constants.clear();
+	constants.reserve(pool.size());
+
+	// 0 is a NULL index, as are the upper halves of long constants.
+	for(size_t idx = 1; idx < pool.size(); idx++) {
+		if(pool[idx] != NULL && HashConstant(pool[idx], hash)) {
+			constants.emplace(hash, idx);
+		}
+	}
+
+	count = pool.size();
+	valid = true;
+}
+
+void ConstantIndex::Append(std::vector<ConstantInfo *> &pool, ConstantInfo *info) {
+	size_t hash;
+
+	if(!valid) return;
+
+	if(info == NULL || count != info->index) {
+		// Pool was changed elsewhere.
+		valid = false;
+		return;
+	}
+
+	if(HashConstant(info, hash)) {
+		constants.emplace(hash, info->index);
+	}
+
+	count = pool.size();
+}
+
+ConstantInfo *ConstantIndex::Find(std::vector<ConstantInfo *> &pool, ConstantInfo *key) {
+	ConstantInfo *found = NULL;
+	size_t hash, position = 0;
+
+	if(!HashConstant(key, hash)) {
+		return NULL;
+	}
+
+	if(!valid || count != pool.size()) {
+		Rebuild(pool);
+	}
+
+	std::pair<Table::iterator, Table::iterator> range = constants.equal_range(hash);
+	for(Table::iterator itr = range.first; itr != range.second; itr++) {
+		ConstantInfo *info = pool[itr->second];
+
+		if(info != NULL && EqualConstants(info, key)
+				&& (found == NULL || itr->second < position)) {
+			position = itr->second;
+			found = info;
+		}
+	}
+
+	return found;
+}
+
+} /* JBC */
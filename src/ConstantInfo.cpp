@@ -1,12 +1,50 @@
 
+# include <string.h>
+
+# include "ErrorTypes.h"
 # include "ConstantInfo.h"
 
 namespace JBC {
 
 ConstantUtf8Info::~ConstantUtf8Info() {
-	if(bytes != NULL) {
-		delete bytes;
+	if(bytes != NULL && !borrowed) {
+		delete[] bytes;
+	}
+}
+
+uint8_t *ConstantUtf8Info::MutableBytes() {
+	if(borrowed) {
+		// Copy on first write.
+		SetBytes(bytes, length);
+	}
+
+	return bytes;
+}
+
+void ConstantUtf8Info::SetBytes(const uint8_t *data, uint16_t length) {
+	uint8_t *copy = new uint8_t[length + 1];
+
+	memcpy(copy, data, length);
+	copy[length] = '\0';
+
+	if(bytes != NULL && !borrowed) {
+		delete[] bytes;
+	}
+
+	this->bytes = copy;
+	this->length = length;
+	borrowed = false;
+
+	// Resolved again if needed.
+	attribute_kind = 0;
+}
+
+void ConstantUtf8Info::SetString(const std::string &value) {
+	if(value.size() > 0xFFFF) {
+		throw JBCError("UTF-8 constant is too long.");
 	}
+
+	SetBytes(reinterpret_cast<const uint8_t *>(value.data()), value.size());
 }
 
 } /* JBC */
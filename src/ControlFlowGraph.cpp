@@ -0,0 +1,243 @@
+
+# include <stdio.h>
+
+# include "ClassFile.h"
+# include "ErrorTypes.h"
+# include "AttributeInfo.h"
+# include "ControlFlowGraph.h"
+
+namespace JBC {
+
+// Offset marks.
+static const uint8_t MARK_INSTRUCTION = 1;
+static const uint8_t MARK_LEADER = 2;
+static const uint8_t MARK_TARGET = 4;
+
+ControlFlowGraph::ControlFlowGraph() {
+}
+
+ControlFlowGraph::ControlFlowGraph(CodeAttribute *code, ClassFile *classFile) {
+	Build(code, classFile);
+}
+
+void ControlFlowGraph::Build(CodeAttribute *code, ClassFile *classFile) {
+	if(!code->IsLoaded()) {
+		if(classFile == NULL) {
+			throw JBCError("Code attribute is not loaded.");
+		}
+
+		code->Load(classFile);
+	}
+
+	Build(code->code, code->code_length, code->exception_table);
+}
+
+void ControlFlowGraph::Build(const uint8_t *code, uint32_t length,
+		const std::vector<ExceptionTableEntry *> &exception_table) {
+	std::vector<ExceptionTableEntry *>::const_iterator entry;
+	Instruction insn;
+
+	blocks.clear();
+	successors.clear();
+	predecessors.clear();
+
+	if(length == 0) return;
+
+	marks.assign(length + 1, 0);
+	block_at.resize(length + 1);
+
+	// Find instruction boundaries and block leaders.
+	marks[0] |= MARK_LEADER;
+
+	InstructionIterator scan(code, length);
+	while(scan.Next(insn)) {
+		const OpcodeInfo &info = insn.Info();
+
+		marks[insn.pc] |= MARK_INSTRUCTION;
+
+		switch(info.flow) {
+			case FLOW_NEXT:
+				continue;
+			case FLOW_BRANCH:
+			case FLOW_GOTO:
+			case FLOW_JSR:
+				marks[insn.target] |= MARK_LEADER;
+				break;
+			case FLOW_SWITCH:
+				marks[insn.target] |= MARK_LEADER;
+				for(uint32_t idx = 0; idx < insn.count; idx++) {
+					marks[insn.CaseTarget(idx)] |= MARK_LEADER;
+				}
+				break;
+		}
+
+		marks[insn.pc + insn.length] |= MARK_LEADER;
+	}
+
+	for(entry = exception_table.begin(); entry != exception_table.end(); entry++) {
+		ExceptionTableEntry *handler = *entry;
+
+		if(handler->start_pc >= handler->end_pc || handler->end_pc > length
+				|| handler->handler_pc >= length) {
+			char tmp[64];
+			sprintf(tmp, "Invalid exception range at pc %u.", handler->start_pc);
+			throw DecodeError(tmp);
+		}
+
+		marks[handler->start_pc] |= MARK_LEADER;
+		marks[handler->end_pc] |= MARK_LEADER;
+		marks[handler->handler_pc] |= MARK_LEADER;
+	}
+
+	// Create a block at each leader.
+	for(uint32_t pc = 0; pc < length; pc++) {
+		if(marks[pc] & MARK_LEADER) {
+			if(!(marks[pc] & MARK_INSTRUCTION)) {
+				char tmp[64];
+				sprintf(tmp, "Block starts inside an instruction at pc %u.", pc);
+				throw DecodeError(tmp);
+			}
+
+			BasicBlock block = { pc, length, pc, 0, 0, 0, 0 };
+			block_at[pc] = blocks.size();
+			blocks.push_back(block);
+		}
+	}
+
+	// Record the edges leaving each block, in block order.
+	uint32_t current = 0;
+
+	InstructionIterator walk(code, length);
+	while(walk.Next(insn)) {
+		uint32_t next = insn.pc + insn.length;
+		if(next < length && !(marks[next] & MARK_LEADER)) {
+			continue;
+		}
+
+		BasicBlock &block = blocks[current];
+		block.last = insn.pc;
+		block.end = next;
+		block.first_successor = successors.size();
+
+		const OpcodeInfo &info = insn.Info();
+		ControlFlowEdge edge;
+
+		switch(info.flow) {
+			case FLOW_NEXT:
+				break;
+			case FLOW_BRANCH:
+			case FLOW_GOTO:
+				edge.block = block_at[insn.target];
+				edge.kind = EDGE_BRANCH;
+				successors.push_back(edge);
+				break;
+			case FLOW_JSR:
+				edge.block = block_at[insn.target];
+				edge.kind = EDGE_JSR;
+				successors.push_back(edge);
+				break;
+			case FLOW_SWITCH:
+				edge.block = block_at[insn.target];
+				edge.kind = EDGE_BRANCH;
+				successors.push_back(edge);
+				marks[insn.target] |= MARK_TARGET;
+
+				// Skip targets shared by several cases.
+				for(uint32_t idx = 0; idx < insn.count; idx++) {
+					uint32_t target = insn.CaseTarget(idx);
+
+					if(!(marks[target] & MARK_TARGET)) {
+						marks[target] |= MARK_TARGET;
+						edge.block = block_at[target];
+						successors.push_back(edge);
+					}
+				}
+
+				for(uint32_t idx = block.first_successor; idx < successors.size(); idx++) {
+					marks[blocks[successors[idx].block].start] &= ~MARK_TARGET;
+				}
+				break;
+		}
+
+		// Branches and jsr also continue with the next block.
+		if(next < length && (info.flow == FLOW_NEXT || info.flow == FLOW_BRANCH
+				|| info.flow == FLOW_JSR)) {
+			edge.block = current + 1;
+			edge.kind = EDGE_FALLTHROUGH;
+			successors.push_back(edge);
+		}
+
+		// Blocks never straddle a protected range.
+		for(entry = exception_table.begin(); entry != exception_table.end(); entry++) {
+			ExceptionTableEntry *handler = *entry;
+
+			if(block.start >= handler->start_pc && block.start < handler->end_pc) {
+				edge.block = block_at[handler->handler_pc];
+				edge.kind = EDGE_EXCEPTION;
+
+				uint32_t other = block.first_successor;
+				while(other < successors.size() && (successors[other].block != edge.block
+						|| successors[other].kind != EDGE_EXCEPTION)) {
+					other++;
+				}
+
+				if(other == successors.size()) {
+					successors.push_back(edge);
+				}
+			}
+		}
+
+		block.successor_count = successors.size() - block.first_successor;
+		current++;
+	}
+
+	// Invert the successor lists, counting predecessors first.
+	for(uint32_t idx = 0; idx < successors.size(); idx++) {
+		blocks[successors[idx].block].predecessor_count++;
+	}
+
+	uint32_t offset = 0;
+	for(uint32_t idx = 0; idx < blocks.size(); idx++) {
+		blocks[idx].first_predecessor = offset;
+		offset += blocks[idx].predecessor_count;
+		blocks[idx].predecessor_count = 0;
+	}
+
+	predecessors.resize(successors.size());
+	for(uint32_t idx = 0; idx < blocks.size(); idx++) {
+		BasicBlock &block = blocks[idx];
+
+		for(uint32_t edge = 0; edge < block.successor_count; edge++) {
+			const ControlFlowEdge &succ = successors[block.first_successor + edge];
+			BasicBlock &target = blocks[succ.block];
+
+			ControlFlowEdge &pred = predecessors[target.first_predecessor
+					+ target.predecessor_count++];
+			pred.block = idx;
+			pred.kind = succ.kind;
+		}
+	}
+}
+
+uint32_t ControlFlowGraph::BlockAt(uint32_t pc) const {
+	uint32_t low = 0, high = blocks.size();
+
+	if(high == 0 || pc >= blocks[high - 1].end) {
+		return blocks.size();
+	}
+
+	// Find the last block starting at or before the offset.
+	while(high - low > 1) {
+		uint32_t mid = (low + high) / 2;
+
+		if(blocks[mid].start <= pc) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+} /* JBC */
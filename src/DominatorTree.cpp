@@ -0,0 +1,145 @@
+
+# include <algorithm>
+
+# include "DominatorTree.h"
+
+namespace JBC {
+
+DominatorTree::DominatorTree() {
+}
+
+DominatorTree::DominatorTree(const ControlFlowGraph &graph) {
+	Build(graph);
+}
+
+void DominatorTree::Build(const ControlFlowGraph &graph) {
+	uint32_t count = graph.BlockCount();
+
+	order.clear();
+	idom.assign(count, NONE);
+	position.assign(count, NONE);
+	preorder.assign(count, NONE);
+	subtree.assign(count, 0);
+
+	if(count == 0) return;
+
+	// Number the reachable blocks in postorder, with an explicit stack of
+	// (block, next successor) pairs. Position marks blocks as visited.
+	stack.clear();
+	stack.push_back(0);
+	stack.push_back(0);
+	position[0] = 0;
+
+	while(!stack.empty()) {
+		uint32_t block = stack[stack.size() - 2];
+		uint32_t &edge = stack.back();
+
+		if(edge < graph.Block(block).successor_count) {
+			uint32_t succ = graph.Successors(block)[edge++].block;
+
+			if(position[succ] == NONE) {
+				position[succ] = 0;
+				stack.push_back(succ);
+				stack.push_back(0);
+			}
+		} else {
+			order.push_back(block);
+			stack.pop_back();
+			stack.pop_back();
+		}
+	}
+
+	uint32_t reachable = order.size();
+	std::reverse(order.begin(), order.end());
+
+	for(uint32_t idx = 0; idx < reachable; idx++) {
+		position[order[idx]] = idx;
+	}
+
+	// Iterate to a fixed point. The entry is its own dominator meanwhile.
+	idom[0] = 0;
+
+	for(bool changed = true; changed; ) {
+		changed = false;
+
+		for(uint32_t idx = 1; idx < reachable; idx++) {
+			uint32_t block = order[idx];
+			const ControlFlowEdge *preds = graph.Predecessors(block);
+			uint32_t dom = NONE;
+
+			for(uint32_t edge = 0; edge < graph.Block(block).predecessor_count; edge++) {
+				uint32_t pred = preds[edge].block;
+				if(idom[pred] == NONE) continue;
+
+				if(dom == NONE) {
+					dom = pred;
+					continue;
+				}
+
+				// Walk both up the tree to their common ancestor.
+				uint32_t other = pred;
+				while(dom != other) {
+					while(position[dom] > position[other]) dom = idom[dom];
+					while(position[other] > position[dom]) other = idom[other];
+				}
+			}
+
+			if(idom[block] != dom) {
+				idom[block] = dom;
+				changed = true;
+			}
+		}
+	}
+
+	idom[0] = NONE;
+
+	// Number the tree in preorder. Children are grouped by parent first.
+	std::vector<uint32_t> &first = stack;
+	first.assign(count + 1, 0);
+
+	for(uint32_t idx = 1; idx < reachable; idx++) {
+		first[idom[order[idx]] + 1]++;
+	}
+
+	for(uint32_t idx = 0; idx < count; idx++) {
+		first[idx + 1] += first[idx];
+	}
+
+	children.resize(reachable);
+	for(uint32_t idx = 1; idx < reachable; idx++) {
+		uint32_t block = order[idx];
+		children[first[idom[block]]++] = block;
+	}
+
+	// Each parent's range now ends where the next begins.
+	for(uint32_t idx = count; idx > 0; idx--) {
+		first[idx] = first[idx - 1];
+	}
+	first[0] = 0;
+
+	// Blocks appear in reverse postorder, so each parent precedes its
+	// children; subtree sizes accumulate from the back.
+	for(uint32_t idx = reachable; idx-- > 0; ) {
+		uint32_t block = order[idx];
+
+		subtree[block] += 1;
+		if(idom[block] != NONE) {
+			subtree[idom[block]] += subtree[block];
+		}
+	}
+
+	// Preorder numbers follow from subtree sizes: each child starts after
+	// its parent and the subtrees of its earlier siblings.
+	preorder[0] = 0;
+	for(uint32_t idx = 0; idx < reachable; idx++) {
+		uint32_t block = order[idx];
+		uint32_t next = preorder[block] + 1;
+
+		for(uint32_t child = first[block]; child < first[block + 1]; child++) {
+			preorder[children[child]] = next;
+			next += subtree[children[child]];
+		}
+	}
+}
+
+} /* JBC */
@@ -71,6 +71,7 @@ ArrayElementValue *ArrayElementValue
 
 	// Array Value Table
 	length = buffer->NextShort();
+	array_values.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		array_values.push_back(DecodeElementValue(buffer, classFile));
 	}
@@ -170,6 +171,22 @@ void EncodeElementValue(ClassBuilder *builder, ClassFile *classFile, ElementValu
 	value->EncodeValue(builder, classFile);
 }
 
+/* Element Value Sizes */
+
+uint32_t AnnotationElementValue::ComputeSize() {
+	return 1 + annotation_value->ComputeSize();
+}
+
+uint32_t ArrayElementValue::ComputeSize() {
+	uint32_t size = 1 + 2;
+
+	for(unsigned idx = 0; idx < array_values.size(); idx++) {
+		size += array_values[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 /* Element Value Destructors */
 
 AnnotationElementValue::~AnnotationElementValue() {
@@ -196,7 +213,8 @@ ElementValuePairsEntry *ElementValuePairsEntry
 	// Element Name
 	index = buffer->NextShort();
 	element_name = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level3, "Element-Value Name : %s.\n",
+	debug_printf(level3, "Element-Value Name : %.*s.\n",
+			(element_name == NULL ? 6 : element_name->length),
 			(element_name == NULL ? "<NULL>" :
 			(char *)element_name->bytes));
 
@@ -214,6 +232,10 @@ ElementValuePairsEntry *ElementValuePairsEntry
 	return this;
 }
 
+uint32_t ElementValuePairsEntry::ComputeSize() {
+	return 2 + value->ComputeSize();
+}
+
 ElementValuePairsEntry::~ElementValuePairsEntry() {
 	if(value != NULL) {
 		delete value;
@@ -234,6 +256,7 @@ AnnotationEntry *AnnotationEntry
 	length = buffer->NextShort();
 	debug_printf(level2, "Element-Value Pairs count : %u.\n", length);
 
+	element_value_pairs.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Element-Value Pair %u :\n", idx);
 		element_value_pairs.push_back((new ElementValuePairsEntry)
@@ -258,6 +281,16 @@ AnnotationEntry *AnnotationEntry
 	return this;
 }
 
+uint32_t AnnotationEntry::ComputeSize() {
+	uint32_t size = 2 + 2;
+
+	for(unsigned idx = 0; idx < element_value_pairs.size(); idx++) {
+		size += element_value_pairs[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 AnnotationEntry::~AnnotationEntry() {
 	if(!element_value_pairs.empty()) {
 		for(std::vector<ElementValuePairsEntry *>::iterator itr = element_value_pairs
@@ -0,0 +1,1072 @@
+
+# include <stdio.h>
+# include <string.h>
+
+# include <vector>
+# include <algorithm>
+
+# include "Bytecode.h"
+# include "ClassFile.h"
+# include "ErrorTypes.h"
+# include "MemberInfo.h"
+# include "ConstantInfo.h"
+# include "AttributeInfo.h"
+# include "StackMapFrame.h"
+# include "FrameAnalysis.h"
+# include "StackAnalysis.h"
+# include "ControlFlowGraph.h"
+
+namespace JBC {
+
+static const uint32_t UNVISITED = 0xFFFFFFFF;
+
+/* Class Hierarchy */
+
+ClassHierarchy::~ClassHierarchy() {
+}
+
+std::string ClassHierarchy::CommonSuperclass(std::string_view, std::string_view) {
+	return "java/lang/Object";
+}
+
+static
+std::string_view Utf8At(ClassFile *classFile, uint16_t index) {
+	ConstantUtf8Info *utf8 = NULL;
+
+	if(index < classFile->constant_pool.size()) {
+		utf8 = dynamic_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
+	}
+
+	if(utf8 == NULL) {
+		throw DecodeError("Invalid UTF-8 constant reference.");
+	}
+
+	return std::string_view(reinterpret_cast<char *>(utf8->bytes), utf8->length);
+}
+
+static
+std::string_view ClassName(ClassFile *classFile, ConstantInfo *constant) {
+	ConstantClassInfo *info = dynamic_cast<ConstantClassInfo *>(constant);
+
+	if(info == NULL) {
+		throw DecodeError("Invalid class constant reference.");
+	}
+
+	return Utf8At(classFile, info->name_index);
+}
+
+void ClassSetHierarchy::AddClass(ClassFile *classFile) {
+	if(classFile->this_class == NULL) return;
+
+	AddClass(ClassName(classFile, classFile->this_class), classFile->super_class == NULL
+			? std::string_view() : ClassName(classFile, classFile->super_class));
+}
+
+void ClassSetHierarchy::AddClass(std::string_view name, std::string_view super) {
+	supers[std::string(name)] = std::string(super);
+}
+
+std::string ClassSetHierarchy::CommonSuperclass(std::string_view first, std::string_view second) {
+	std::unordered_map<std::string, std::string>::iterator itr;
+	std::vector<std::string> chain;
+	std::string name(first);
+
+	// Collect the superclasses of the first class. Bounded, in case of cycles.
+	for(size_t depth = 0; depth <= supers.size(); depth++) {
+		chain.push_back(name);
+
+		itr = supers.find(name);
+		if(itr == supers.end() || itr->second.empty()) break;
+		name = itr->second;
+	}
+
+	// Walk up from the second class to the first shared one.
+	name = second;
+	for(size_t depth = 0; depth <= supers.size(); depth++) {
+		for(size_t idx = 0; idx < chain.size(); idx++) {
+			if(chain[idx] == name) return name;
+		}
+
+		itr = supers.find(name);
+		if(itr == supers.end() || itr->second.empty()) break;
+		name = itr->second;
+	}
+
+	return "java/lang/Object";
+}
+
+/* Frame Types */
+
+// A verification type. Data names the class of an object, or holds
+// the offset of the new instruction creating an uninitialized one.
+struct FrameType {
+	uint8_t		tag;
+	uint32_t	data;
+};
+
+static inline
+bool operator==(const FrameType &first, const FrameType &second) {
+	return first.tag == second.tag && first.data == second.data;
+}
+
+static inline
+bool operator!=(const FrameType &first, const FrameType &second) {
+	return !(first == second);
+}
+
+static inline
+FrameType MakeType(uint8_t tag, uint32_t data = 0) {
+	FrameType type = { tag, data };
+	return type;
+}
+
+static inline
+bool IsWide(const FrameType &type) {
+	return type.tag == ITEM_LONG || type.tag == ITEM_DOUBLE;
+}
+
+static inline
+bool IsReference(const FrameType &type) {
+	return type.tag == ITEM_OBJECT || type.tag == ITEM_NULL;
+}
+
+// Result types of instructions with no operands to resolve.
+static
+uint8_t SimpleResult(uint8_t opcode) {
+	static const uint8_t arithmetic[] = {
+		ITEM_INTEGER, ITEM_LONG, ITEM_FLOAT, ITEM_DOUBLE
+	};
+
+	switch(opcode) {
+		case OP_LCONST_0: case OP_LCONST_1:
+		case OP_LALOAD: case OP_I2L: case OP_F2L: case OP_D2L:
+			return ITEM_LONG;
+		case OP_FCONST_0: case OP_FCONST_1: case OP_FCONST_2:
+		case OP_FALOAD: case OP_I2F: case OP_L2F: case OP_D2F:
+			return ITEM_FLOAT;
+		case OP_DCONST_0: case OP_DCONST_1:
+		case OP_DALOAD: case OP_I2D: case OP_L2D: case OP_F2D:
+			return ITEM_DOUBLE;
+	}
+
+	if(opcode >= OP_IADD && opcode <= OP_DNEG) {
+		return arithmetic[(opcode - OP_IADD) & 3];
+	}
+
+	if(opcode >= OP_ISHL && opcode <= OP_LXOR) {
+		return (opcode - OP_ISHL) & 1 ? ITEM_LONG : ITEM_INTEGER;
+	}
+
+	// Constants, narrow array loads, conversions, comparisons and the like.
+	return ITEM_INTEGER;
+}
+
+// Drops the upper slots of wide values, and optionally trailing tops.
+static
+void Compress(const FrameType *types, uint32_t count, std::vector<FrameType> &out, bool trim) {
+	out.clear();
+
+	for(uint32_t idx = 0; idx < count; idx++) {
+		out.push_back(types[idx]);
+		if(IsWide(types[idx])) idx++;
+	}
+
+	while(trim && !out.empty() && out.back().tag == ITEM_TOP) {
+		out.pop_back();
+	}
+}
+
+/* Frame Builder */
+
+// Infers the frames of a single method.
+class FrameBuilder {
+private:
+	MemberInfo	*method;
+	CodeAttribute *code;
+	ClassFile	*classFile;
+	ClassHierarchy *hierarchy;
+
+	ControlFlowGraph graph;
+
+	// Interned class names.
+	std::vector<std::string> names;
+	std::unordered_map<std::string, uint32_t> name_ids;
+
+	// Entry state of each block: max_locals types, then max_stack.
+	uint32_t	max_locals;
+	uint32_t	max_stack;
+	std::vector<FrameType> entries;
+	std::vector<uint32_t> depths;
+
+	std::vector<uint32_t> worklist;
+	std::vector<bool> queued;
+
+	// The state being simulated.
+	std::vector<FrameType> locals;
+	std::vector<FrameType> stack;
+	bool		locals_changed;
+
+	// The locals on entry to the method.
+	std::vector<FrameType> initial;
+
+public:
+	FrameBuilder(MemberInfo *method, ClassFile *classFile, ClassHierarchy *hierarchy);
+
+	void Build();
+
+private:
+	FrameType ObjectType(std::string_view name);
+	FrameType ConstantType(const Instruction &insn);
+	FrameType DescriptorType(const uint8_t *&ptr, const uint8_t *end);
+	FrameType ThisType();
+
+	std::string CommonType(std::string_view first, std::string_view second);
+	FrameType Merge(const FrameType &first, const FrameType &second);
+	void MergeState(uint32_t block, const FrameType *local_types,
+			const FrameType *stack_types, uint32_t depth);
+	void MergeHandlers(const BasicBlock &block);
+
+	void Push(const FrameType &type);
+	FrameType Pop(uint32_t pc);
+	void PopSlots(uint32_t count, uint32_t pc);
+	void Duplicate(uint32_t count, uint32_t depth, uint32_t pc);
+	void SetLocal(uint32_t index, const FrameType &type);
+	void Initialize(const FrameType &uninitialized, const FrameType &type);
+
+	void Execute(const Instruction &insn);
+
+	void RemoveDeadCode();
+	void EmitFrames();
+	VariableInfo *NewInfo(const FrameType &type);
+};
+
+FrameBuilder::FrameBuilder(MemberInfo *method, ClassFile *classFile,
+		ClassHierarchy *hierarchy)
+	: method(method), code(method->GetCode()), classFile(classFile),
+	  hierarchy(hierarchy), max_locals(0), max_stack(0), locals_changed(false) {
+}
+
+FrameType FrameBuilder::ObjectType(std::string_view name) {
+	std::unordered_map<std::string, uint32_t>::iterator itr;
+	std::string key(name);
+
+	itr = name_ids.find(key);
+	if(itr != name_ids.end()) {
+		return MakeType(ITEM_OBJECT, itr->second);
+	}
+
+	name_ids[key] = names.size();
+	names.push_back(key);
+
+	return MakeType(ITEM_OBJECT, names.size() - 1);
+}
+
+FrameType FrameBuilder::ThisType() {
+	return ObjectType(ClassName(classFile, classFile->this_class));
+}
+
+FrameType FrameBuilder::ConstantType(const Instruction &insn) {
+	switch(insn.constant == NULL ? 0 : insn.constant->tag) {
+		case CONSTANT_INTEGER:
+			return MakeType(ITEM_INTEGER);
+		case CONSTANT_FLOAT:
+			return MakeType(ITEM_FLOAT);
+		case CONSTANT_LONG:
+			return MakeType(ITEM_LONG);
+		case CONSTANT_DOUBLE:
+			return MakeType(ITEM_DOUBLE);
+		case CONSTANT_STRING:
+			return ObjectType("java/lang/String");
+		case CONSTANT_CLASS:
+			return ObjectType("java/lang/Class");
+		case CONSTANT_METHOD_TYPE:
+			return ObjectType("java/lang/invoke/MethodType");
+		case CONSTANT_METHOD_HANDLE:
+			return ObjectType("java/lang/invoke/MethodHandle");
+	}
+
+	char tmp[64];
+	sprintf(tmp, "Invalid loadable constant at pc %u.", insn.pc);
+	throw DecodeError(tmp);
+}
+
+FrameType FrameBuilder::DescriptorType(const uint8_t *&ptr, const uint8_t *end) {
+	const uint8_t *start = ptr;
+
+	if(ptr < end) {
+		switch(*ptr++) {
+			case 'B': case 'C': case 'I': case 'S': case 'Z':
+				return MakeType(ITEM_INTEGER);
+			case 'F':
+				return MakeType(ITEM_FLOAT);
+			case 'J':
+				return MakeType(ITEM_LONG);
+			case 'D':
+				return MakeType(ITEM_DOUBLE);
+			case 'L':
+				while(ptr < end && *ptr != ';') ptr++;
+				if(ptr >= end) break;
+
+				ptr++;
+				return ObjectType(std::string_view(
+						reinterpret_cast<const char *>(start + 1), ptr - start - 2));
+			case '[':
+				// Array classes are named by their descriptor.
+				while(ptr < end && *ptr == '[') ptr++;
+				if(ptr >= end) break;
+
+				if(*ptr++ == 'L') {
+					while(ptr < end && *ptr != ';') ptr++;
+					if(ptr++ >= end) break;
+				}
+
+				return ObjectType(std::string_view(
+						reinterpret_cast<const char *>(start), ptr - start));
+		}
+	}
+
+	throw DecodeError("Malformed descriptor.");
+}
+
+std::string FrameBuilder::CommonType(std::string_view first, std::string_view second) {
+	if(first[0] != '[' && second[0] != '[') {
+		return hierarchy->CommonSuperclass(first, second);
+	}
+
+	if(first[0] == '[' && second[0] == '[') {
+		std::string_view inner_first = first.substr(1);
+		std::string_view inner_second = second.substr(1);
+
+		// Arrays of references are arrays of the common element type.
+		if((inner_first[0] == 'L' || inner_first[0] == '[')
+				&& (inner_second[0] == 'L' || inner_second[0] == '[')) {
+			if(inner_first[0] == 'L') {
+				inner_first = inner_first.substr(1, inner_first.size() - 2);
+			}
+
+			if(inner_second[0] == 'L') {
+				inner_second = inner_second.substr(1, inner_second.size() - 2);
+			}
+
+			std::string common = inner_first == inner_second ? std::string(inner_first)
+					: CommonType(inner_first, inner_second);
+
+			return common[0] == '[' ? "[" + common : "[L" + common + ";";
+		}
+	}
+
+	return "java/lang/Object";
+}
+
+FrameType FrameBuilder::Merge(const FrameType &first, const FrameType &second) {
+	if(first == second) return first;
+
+	if(IsReference(first) && IsReference(second)) {
+		if(first.tag == ITEM_NULL) return second;
+		if(second.tag == ITEM_NULL) return first;
+
+		return ObjectType(CommonType(names[first.data], names[second.data]));
+	}
+
+	return MakeType(ITEM_TOP);
+}
+
+void FrameBuilder::MergeState(uint32_t block, const FrameType *local_types,
+		const FrameType *stack_types, uint32_t depth) {
+	FrameType *entry = &entries[block * (max_locals + max_stack)];
+	bool changed = false;
+
+	if(depths[block] == UNVISITED) {
+		std::copy(local_types, local_types + max_locals, entry);
+		std::copy(stack_types, stack_types + depth, entry + max_locals);
+		depths[block] = depth;
+		changed = true;
+	} else {
+		if(depths[block] != depth) {
+			char tmp[64];
+			sprintf(tmp, "Inconsistent stack depth at pc %u.", graph.Block(block).start);
+			throw DecodeError(tmp);
+		}
+
+		for(uint32_t idx = 0; idx < max_locals + depth; idx++) {
+			const FrameType &incoming = idx < max_locals
+					? local_types[idx] : stack_types[idx - max_locals];
+			FrameType merged = Merge(entry[idx], incoming);
+
+			if(merged != entry[idx]) {
+				entry[idx] = merged;
+				changed = true;
+			}
+		}
+	}
+
+	if(changed && !queued[block]) {
+		queued[block] = true;
+		worklist.push_back(block);
+	}
+}
+
+void FrameBuilder::MergeHandlers(const BasicBlock &block) {
+	std::vector<ExceptionTableEntry *>::iterator itr;
+
+	for(itr = code->exception_table.begin(); itr != code->exception_table.end(); itr++) {
+		ExceptionTableEntry *entry = *itr;
+		FrameType thrown;
+
+		if(block.start < entry->start_pc || block.start >= entry->end_pc) {
+			continue;
+		}
+
+		if(entry->catch_type == 0) {
+			thrown = ObjectType("java/lang/Throwable");
+		} else if(entry->catch_type < classFile->constant_pool.size()) {
+			thrown = ObjectType(ClassName(classFile, classFile->constant_pool[entry->catch_type]));
+		} else {
+			throw DecodeError("Invalid exception handler catch type.");
+		}
+
+		MergeState(graph.BlockAt(entry->handler_pc), locals.data(), &thrown, 1);
+	}
+}
+
+void FrameBuilder::Push(const FrameType &type) {
+	stack.push_back(type);
+
+	// Wide values take a second, top slot.
+	if(IsWide(type)) {
+		stack.push_back(MakeType(ITEM_TOP));
+	}
+}
+
+FrameType FrameBuilder::Pop(uint32_t pc) {
+	if(stack.empty()) {
+		PopSlots(1, pc);
+	}
+
+	FrameType type = stack.back();
+	stack.pop_back();
+
+	// Returns the value, rather than its upper slot.
+	if(type.tag == ITEM_TOP && !stack.empty() && IsWide(stack.back())) {
+		type = stack.back();
+		stack.pop_back();
+	}
+
+	return type;
+}
+
+void FrameBuilder::PopSlots(uint32_t count, uint32_t pc) {
+	if(stack.size() < count) {
+		char tmp[64];
+		sprintf(tmp, "Stack underflow at pc %u.", pc);
+		throw DecodeError(tmp);
+	}
+
+	stack.resize(stack.size() - count);
+}
+
+void FrameBuilder::Duplicate(uint32_t count, uint32_t depth, uint32_t pc) {
+	if(stack.size() < depth) {
+		char tmp[64];
+		sprintf(tmp, "Stack underflow at pc %u.", pc);
+		throw DecodeError(tmp);
+	}
+
+	// Copies the top count slots below the top depth slots.
+	std::vector<FrameType>::iterator top = stack.end() - count;
+	std::vector<FrameType> copy(top, stack.end());
+	stack.insert(stack.end() - depth, copy.begin(), copy.end());
+}
+
+void FrameBuilder::SetLocal(uint32_t index, const FrameType &type) {
+	// A store over the upper slot of a wide value invalidates it.
+	if(index > 0 && IsWide(locals[index - 1])) {
+		locals[index - 1] = MakeType(ITEM_TOP);
+	}
+
+	locals[index] = type;
+	if(IsWide(type)) {
+		locals[index + 1] = MakeType(ITEM_TOP);
+	}
+
+	locals_changed = true;
+}
+
+void FrameBuilder::Initialize(const FrameType &uninitialized, const FrameType &type) {
+	for(uint32_t idx = 0; idx < locals.size(); idx++) {
+		if(locals[idx] == uninitialized) {
+			locals[idx] = type;
+			locals_changed = true;
+		}
+	}
+
+	for(uint32_t idx = 0; idx < stack.size(); idx++) {
+		if(stack[idx] == uninitialized) stack[idx] = type;
+	}
+}
+
+void FrameBuilder::Execute(const Instruction &insn) {
+	const OpcodeInfo &info = insn.Info();
+	uint8_t opcode = insn.opcode;
+	uint32_t index = insn.index;
+	FrameType value;
+
+	// Short forms of loads and stores.
+	if(opcode >= OP_ILOAD_0 && opcode <= OP_ALOAD_3) {
+		index = (opcode - OP_ILOAD_0) & 3;
+		opcode = OP_ILOAD + (opcode - OP_ILOAD_0) / 4;
+	} else if(opcode >= OP_ISTORE_0 && opcode <= OP_ASTORE_3) {
+		index = (opcode - OP_ISTORE_0) & 3;
+		opcode = OP_ISTORE + (opcode - OP_ISTORE_0) / 4;
+	}
+
+	switch(opcode) {
+		case OP_ACONST_NULL:
+			Push(MakeType(ITEM_NULL));
+			break;
+		case OP_LDC:
+		case OP_LDC_W:
+		case OP_LDC2_W:
+			Push(ConstantType(insn));
+			break;
+		case OP_ILOAD:
+			Push(MakeType(ITEM_INTEGER));
+			break;
+		case OP_LLOAD:
+			Push(MakeType(ITEM_LONG));
+			break;
+		case OP_FLOAD:
+			Push(MakeType(ITEM_FLOAT));
+			break;
+		case OP_DLOAD:
+			Push(MakeType(ITEM_DOUBLE));
+			break;
+		case OP_ALOAD:
+			Push(locals[index]);
+			break;
+		case OP_ISTORE:
+		case OP_LSTORE:
+		case OP_FSTORE:
+		case OP_DSTORE:
+		case OP_ASTORE:
+			SetLocal(index, Pop(insn.pc));
+			break;
+		case OP_AALOAD: {
+			PopSlots(1, insn.pc);
+			value = Pop(insn.pc);
+
+			if(value.tag == ITEM_OBJECT && names[value.data][0] == '[') {
+				std::string element = names[value.data].substr(1);
+				const uint8_t *ptr = reinterpret_cast<const uint8_t *>(element.data());
+
+				Push(DescriptorType(ptr, ptr + element.size()));
+			} else {
+				Push(value.tag == ITEM_NULL ? value : ObjectType("java/lang/Object"));
+			}
+			break;
+		}
+		case OP_DUP:
+			Duplicate(1, 1, insn.pc);
+			break;
+		case OP_DUP_X1:
+			Duplicate(1, 2, insn.pc);
+			break;
+		case OP_DUP_X2:
+			Duplicate(1, 3, insn.pc);
+			break;
+		case OP_DUP2:
+			Duplicate(2, 2, insn.pc);
+			break;
+		case OP_DUP2_X1:
+			Duplicate(2, 3, insn.pc);
+			break;
+		case OP_DUP2_X2:
+			Duplicate(2, 4, insn.pc);
+			break;
+		case OP_SWAP:
+			Duplicate(1, 2, insn.pc);
+			stack.pop_back();
+			break;
+		case OP_GETSTATIC:
+		case OP_PUTSTATIC:
+		case OP_GETFIELD:
+		case OP_PUTFIELD:
+		case OP_INVOKEVIRTUAL:
+		case OP_INVOKESPECIAL:
+		case OP_INVOKESTATIC:
+		case OP_INVOKEINTERFACE:
+		case OP_INVOKEDYNAMIC: {
+			ConstantNameAndTypeInfo *nameAndType = ReferenceNameAndType(insn.constant, classFile);
+			if(nameAndType == NULL) {
+				char tmp[64];
+				sprintf(tmp, "Invalid member reference at pc %u.", insn.pc);
+				throw DecodeError(tmp);
+			}
+
+			std::string_view descriptor = Utf8At(classFile, nameAndType->descriptor_index);
+			const uint8_t *ptr = reinterpret_cast<const uint8_t *>(descriptor.data());
+			const uint8_t *end = ptr + descriptor.size();
+
+			if(opcode <= OP_PUTFIELD) {
+				value = DescriptorType(ptr, end);
+
+				if(opcode == OP_PUTSTATIC || opcode == OP_PUTFIELD) {
+					PopSlots(IsWide(value) ? 2 : 1, insn.pc);
+				}
+
+				if(opcode == OP_GETFIELD || opcode == OP_PUTFIELD) {
+					PopSlots(1, insn.pc);
+				}
+
+				if(opcode == OP_GETSTATIC || opcode == OP_GETFIELD) {
+					Push(value);
+				}
+				break;
+			}
+
+			// Pop the arguments, then any receiver.
+			uint32_t slots = 0;
+			if(ptr < end && *ptr == '(') ptr++;
+
+			while(ptr < end && *ptr != ')') {
+				slots += IsWide(DescriptorType(ptr, end)) ? 2 : 1;
+			}
+
+			if(ptr++ >= end) {
+				throw DecodeError("Malformed method descriptor.");
+			}
+
+			PopSlots(slots, insn.pc);
+
+			if(opcode != OP_INVOKESTATIC && opcode != OP_INVOKEDYNAMIC) {
+				FrameType receiver = Pop(insn.pc);
+
+				if(opcode == OP_INVOKESPECIAL && Utf8At(classFile, nameAndType->name_index) == "<init>") {
+					if(receiver.tag == ITEM_UNINITIALIZED_THIS) {
+						Initialize(receiver, ThisType());
+					} else if(receiver.tag == ITEM_UNINITIALIZED) {
+						uint16_t type = (code->code[receiver.data + 1] << 8) | code->code[receiver.data + 2];
+						if(type >= classFile->constant_pool.size()) {
+							throw DecodeError("Invalid class constant reference.");
+						}
+
+						Initialize(receiver, ObjectType(ClassName(classFile, classFile->constant_pool[type])));
+					}
+				}
+			}
+
+			if(ptr < end && *ptr != 'V') {
+				Push(DescriptorType(ptr, end));
+			}
+			break;
+		}
+		case OP_NEW:
+			Push(MakeType(ITEM_UNINITIALIZED, insn.pc));
+			break;
+		case OP_NEWARRAY: {
+			static const char *arrays[] = {
+				"[Z", "[C", "[F", "[D", "[B", "[S", "[I", "[J"
+			};
+
+			if(insn.value < 4 || insn.value > 11) {
+				char tmp[64];
+				sprintf(tmp, "Invalid array type at pc %u.", insn.pc);
+				throw DecodeError(tmp);
+			}
+
+			PopSlots(1, insn.pc);
+			Push(ObjectType(arrays[insn.value - 4]));
+			break;
+		}
+		case OP_ANEWARRAY: {
+			std::string_view element = ClassName(classFile, insn.constant);
+
+			PopSlots(1, insn.pc);
+			if(element[0] == '[') {
+				Push(ObjectType("[" + std::string(element)));
+			} else {
+				Push(ObjectType("[L" + std::string(element) + ";"));
+			}
+			break;
+		}
+		case OP_CHECKCAST:
+			PopSlots(1, insn.pc);
+			Push(ObjectType(ClassName(classFile, insn.constant)));
+			break;
+		case OP_MULTIANEWARRAY:
+			PopSlots(insn.value, insn.pc);
+			Push(ObjectType(ClassName(classFile, insn.constant)));
+			break;
+		case OP_JSR:
+		case OP_JSR_W:
+		case OP_RET:
+			throw EncodeError("Cannot compute frames for code using subroutines.");
+		default:
+			PopSlots(info.pops, insn.pc);
+			if(info.pushes > 0) {
+				Push(MakeType(SimpleResult(opcode)));
+			}
+			break;
+	}
+}
+
+void FrameBuilder::Build() {
+	Instruction insn;
+
+	graph.Build(code, classFile);
+
+	CodeLimits limits = ComputeCodeLimits(method, code, classFile);
+	max_locals = limits.max_locals;
+	max_stack = limits.max_stack;
+
+	entries.resize(graph.BlockCount() * (max_locals + max_stack));
+	depths.assign(graph.BlockCount(), UNVISITED);
+	queued.assign(graph.BlockCount(), false);
+
+	// The entry state holds the receiver and arguments.
+	uint32_t slot = 0;
+	locals.assign(max_locals, MakeType(ITEM_TOP));
+	stack.clear();
+
+	if(!method->GetFlag(METHOD_STATIC)) {
+		if(method->Name() == "<init>"
+				&& ClassName(classFile, classFile->this_class) != "java/lang/Object") {
+			locals[slot++] = MakeType(ITEM_UNINITIALIZED_THIS);
+		} else {
+			locals[slot++] = ThisType();
+		}
+	}
+
+	const uint8_t *ptr = method->descriptor->bytes + 1;
+	const uint8_t *end = method->descriptor->bytes + method->descriptor->length;
+	while(ptr < end && *ptr != ')') {
+		FrameType type = DescriptorType(ptr, end);
+
+		locals[slot] = type;
+		slot += IsWide(type) ? 2 : 1;
+	}
+
+	Compress(locals.data(), max_locals, initial, true);
+
+	if(graph.BlockCount() == 0) return;
+	MergeState(0, locals.data(), NULL, 0);
+
+	// Propagate types to a fixed point.
+	InstructionIterator itr(code->code, code->code_length, classFile);
+
+	while(!worklist.empty()) {
+		uint32_t block = worklist.back();
+		const BasicBlock &info = graph.Block(block);
+		const FrameType *entry = &entries[block * (max_locals + max_stack)];
+
+		worklist.pop_back();
+		queued[block] = false;
+
+		locals.assign(entry, entry + max_locals);
+		stack.assign(entry + max_locals, entry + max_locals + depths[block]);
+
+		// Handlers see the locals before and after every store.
+		locals_changed = true;
+
+		itr.Seek(info.start);
+		while(itr.Position() < info.end && itr.Next(insn)) {
+			if(locals_changed) {
+				MergeHandlers(info);
+				locals_changed = false;
+			}
+
+			Execute(insn);
+		}
+
+		if(locals_changed) {
+			MergeHandlers(info);
+		}
+
+		const ControlFlowEdge *edges = graph.Successors(block);
+		for(uint32_t idx = 0; idx < info.successor_count; idx++) {
+			if(edges[idx].kind != EDGE_EXCEPTION) {
+				MergeState(edges[idx].block, locals.data(), stack.data(), stack.size());
+			}
+		}
+	}
+
+	RemoveDeadCode();
+	EmitFrames();
+}
+
+void FrameBuilder::RemoveDeadCode() {
+	std::vector<ExceptionTableEntry *> table;
+	bool dead = false;
+
+	for(uint32_t idx = 0; idx < graph.BlockCount(); idx++) {
+		if(depths[idx] == UNVISITED) dead = true;
+	}
+
+	if(!dead) return;
+
+	// Rewritten in a copy, as the code may be the decoding source.
+	uint8_t *bytes;
+	bool borrowed;
+
+	if(Arena *arena = Arena::Current()) {
+		bytes = (uint8_t *)arena->Allocate(code->code_length);
+		borrowed = true;
+	} else {
+		bytes = new uint8_t[code->code_length];
+		borrowed = false;
+	}
+
+	memcpy(bytes, code->code, code->code_length);
+	if(!code->borrowed) {
+		delete[] code->code;
+	}
+
+	code->code = bytes;
+	code->borrowed = borrowed;
+
+	// Unreachable blocks become nop ... athrow.
+	for(uint32_t idx = 0; idx < graph.BlockCount(); idx++) {
+		const BasicBlock &block = graph.Block(idx);
+
+		if(depths[idx] == UNVISITED) {
+			memset(bytes + block.start, OP_NOP, block.end - block.start - 1);
+			bytes[block.end - 1] = OP_ATHROW;
+		}
+	}
+
+	if(code->max_stack < 1) {
+		code->max_stack = 1;
+	}
+
+	// Split protected ranges around unreachable blocks.
+	std::vector<ExceptionTableEntry *>::iterator itr;
+	for(itr = code->exception_table.begin(); itr != code->exception_table.end(); itr++) {
+		ExceptionTableEntry *entry = *itr;
+		uint32_t start = UNVISITED, end = entry->end_pc;
+		bool reused = false;
+
+		for(uint32_t idx = graph.BlockAt(entry->start_pc); idx < graph.BlockCount()
+				&& graph.Block(idx).start < end; idx++) {
+			const BasicBlock &block = graph.Block(idx);
+
+			if(depths[idx] != UNVISITED) {
+				if(start == UNVISITED) start = block.start;
+				if(block.end < end) continue;
+			}
+
+			if(start == UNVISITED) continue;
+
+			// Close the live run before this block, or at the range end.
+			ExceptionTableEntry *live = entry;
+			if(reused) {
+				live = new ExceptionTableEntry();
+				live->handler_pc = entry->handler_pc;
+				live->catch_type = entry->catch_type;
+			}
+
+			live->start_pc = start;
+			live->end_pc = depths[idx] != UNVISITED ? block.end : block.start;
+			table.push_back(live);
+
+			reused = true;
+			start = UNVISITED;
+		}
+
+		if(!reused) {
+			delete entry;
+		}
+	}
+
+	code->exception_table = table;
+}
+
+VariableInfo *FrameBuilder::NewInfo(const FrameType &type) {
+	if(type.tag == ITEM_OBJECT) {
+		ObjectVariableInfo *info = new ObjectVariableInfo(ITEM_OBJECT);
+		info->object = classFile->FindOrAddClass(names[type.data]);
+		return info;
+	} else if(type.tag == ITEM_UNINITIALIZED) {
+		UninitializedVariableInfo *info = new UninitializedVariableInfo(ITEM_UNINITIALIZED);
+		info->offset = type.data;
+		return info;
+	}
+
+	return new VariableInfo(type.tag);
+}
+
+void FrameBuilder::EmitFrames() {
+	std::vector<FrameType> previous, current, items;
+	std::vector<StackMapFrame *> frames;
+	std::vector<bool> targets(code->code_length, false);
+	Instruction insn;
+
+	// Frames are needed at branch targets, handlers, and after
+	// instructions that do not fall through.
+	InstructionIterator itr(code->code, code->code_length);
+	while(itr.Next(insn)) {
+		uint8_t flow = insn.Info().flow;
+
+		if(flow == FLOW_BRANCH || flow == FLOW_GOTO || flow == FLOW_SWITCH) {
+			targets[insn.target] = true;
+
+			for(uint32_t idx = 0; idx < insn.count; idx++) {
+				targets[insn.CaseTarget(idx)] = true;
+			}
+		}
+
+		if(flow != FLOW_NEXT && flow != FLOW_BRANCH && itr.Position() < code->code_length) {
+			targets[itr.Position()] = true;
+		}
+	}
+
+	for(uint32_t idx = 0; idx < code->exception_table.size(); idx++) {
+		targets[code->exception_table[idx]->handler_pc] = true;
+	}
+
+	// The implicit first frame is the method's entry state.
+	uint32_t last = UNVISITED;
+	previous = initial;
+
+	FrameType thrown = ObjectType("java/lang/Throwable");
+
+	for(uint32_t block = 0; block < graph.BlockCount(); block++) {
+		uint32_t pc = graph.Block(block).start;
+		if(!targets[pc] && depths[block] != UNVISITED) continue;
+
+		const FrameType *entry = &entries[block * (max_locals + max_stack)];
+		if(depths[block] == UNVISITED) {
+			current.clear();
+			items.assign(1, thrown);
+		} else {
+			Compress(entry, max_locals, current, true);
+			Compress(entry + max_locals, depths[block], items, false);
+		}
+
+		uint32_t delta = last == UNVISITED ? pc : pc - last - 1;
+		size_t shared = 0;
+		while(shared < current.size() && shared < previous.size()
+				&& current[shared] == previous[shared]) {
+			shared++;
+		}
+
+		StackMapFrame *frame;
+		if(items.empty() && shared == current.size() && shared == previous.size()) {
+			if(delta <= 63) {
+				frame = new StackMapFrame(delta);
+			} else {
+				StackMapOffFrame *same = new StackMapOffFrame(251);
+				same->offset_delta = delta;
+				frame = same;
+			}
+		} else if(items.size() == 1 && shared == current.size() && shared == previous.size()) {
+			if(delta <= 63) {
+				StackMapItemFrame *same = new StackMapItemFrame(64 + delta);
+				same->stack = NewInfo(items[0]);
+				frame = same;
+			} else {
+				StackMapExtFrame *same = new StackMapExtFrame(247);
+				same->offset_delta = delta;
+				same->stack = NewInfo(items[0]);
+				frame = same;
+			}
+		} else if(items.empty() && shared == current.size()
+				&& previous.size() - shared <= 3) {
+			StackMapOffFrame *chop = new StackMapOffFrame(251 - (previous.size() - shared));
+			chop->offset_delta = delta;
+			frame = chop;
+		} else if(items.empty() && shared == previous.size()
+				&& current.size() - shared <= 3) {
+			StackMapListFrame *append = new StackMapListFrame(251 + (current.size() - shared));
+			append->offset_delta = delta;
+			append->stack = new VariableInfo *[current.size() - shared];
+
+			for(size_t idx = shared; idx < current.size(); idx++) {
+				append->stack[idx - shared] = NewInfo(current[idx]);
+			}
+			frame = append;
+		} else {
+			StackMapFullFrame *full = new StackMapFullFrame(255);
+			full->offset_delta = delta;
+
+			for(size_t idx = 0; idx < current.size(); idx++) {
+				full->locals.push_back(NewInfo(current[idx]));
+			}
+
+			for(size_t idx = 0; idx < items.size(); idx++) {
+				full->stack.push_back(NewInfo(items[idx]));
+			}
+			frame = full;
+		}
+
+		frames.push_back(frame);
+		previous.swap(current);
+		last = pc;
+	}
+
+	// Replace the method's table.
+	StackMapTableAttribute *table = NULL;
+	std::vector<AttributeInfo *>::iterator itr_attr;
+
+	for(itr_attr = code->attributes.begin(); itr_attr != code->attributes.end(); itr_attr++) {
+		table = dynamic_cast<StackMapTableAttribute *>(*itr_attr);
+		if(table != NULL) break;
+	}
+
+	if(frames.empty()) {
+		if(table != NULL) {
+			code->attributes.erase(itr_attr);
+			delete table;
+		}
+	} else {
+		if(table == NULL) {
+			table = new StackMapTableAttribute(classFile->FindOrAddUtf8("StackMapTable"), 0);
+			code->attributes.push_back(table);
+		}
+
+		for(size_t idx = 0; idx < table->entries.size(); idx++) {
+			delete table->entries[idx];
+		}
+
+		table->entries = frames;
+		table->attribute_length = table->ComputeLength();
+		table->MarkDirty();
+	}
+
+	code->MarkDirty();
+}
+
+// Checks if code calls or returns from subroutines.
+static
+bool UsesSubroutines(CodeAttribute *code, ClassFile *classFile) {
+	InstructionIterator itr(code, classFile);
+	Instruction insn;
+
+	while(itr.Next(insn)) {
+		if(insn.Info().flow == FLOW_JSR || insn.opcode == OP_RET) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ComputeStackMapFrames(MemberInfo *method, ClassFile *classFile,
+		ClassHierarchy *hierarchy) {
+	ClassHierarchy resolver;
+	CodeAttribute *code = method->GetCode();
+
+	if(code == NULL) return;
+
+	// Version 50 verifiers fall back to type inference for these.
+	if(classFile->major_version < 51 && UsesSubroutines(code, classFile)) {
+		return;
+	}
+
+	// Frames, and rewritten code, live with the class.
+	ArenaScope scope(classFile->arena);
+
+	FrameBuilder builder(method, classFile, hierarchy == NULL ? &resolver : hierarchy);
+	builder.Build();
+}
+
+} /* JBC */
@@ -0,0 +1,407 @@
+
+# include <string.h>
+
+# include "ErrorTypes.h"
+# include "Inflate.h"
+
+namespace JBC {
+
+// Codes up to this length are decoded with one table lookup.
+static const unsigned FAST_BITS = 9;
+
+static const uint16_t length_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t length_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t distance_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+static const uint8_t distance_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Order of the code length code lengths.
+static const uint8_t code_order[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/**
+ * @struct Huffman
+ * @brief A canonical Huffman code.
+ **/
+struct Huffman {
+	// Number of codes of each length.
+	uint16_t	count[16];
+
+	// Symbols ordered by code.
+	uint16_t	symbol[288];
+
+	// Length and symbol of short codes, indexed by their bits.
+	uint16_t	fast[1 << FAST_BITS];
+};
+
+/**
+ * @class Inflater
+ * @brief Decodes one deflate stream.
+ **/
+class Inflater {
+private:
+	const uint8_t *in;
+	const uint8_t *end;
+
+	// Bits are consumed from the low end.
+	uint64_t	bits;
+	unsigned	count;
+
+	uint8_t		*out;
+	size_t		position;
+	size_t		size;
+
+public:
+	Inflater(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size)
+		: in(src), end(src + src_size), bits(0), count(0),
+		  out(dst), position(0), size(dst_size) {
+	}
+
+	size_t Run() {
+		bool last;
+
+		do {
+			last = Bits(1) != 0;
+
+			switch(Bits(2)) {
+				case 0:
+					Stored();
+					break;
+				case 1:
+					Fixed();
+					break;
+				case 2:
+					Dynamic();
+					break;
+				default:
+					throw DecodeError("Invalid deflate block type.");
+			}
+		} while(!last);
+
+		return position;
+	}
+
+private:
+	inline
+	void Refill() {
+		while(count <= 56 && in < end) {
+			bits |= (uint64_t)*in++ << count;
+			count += 8;
+		}
+	}
+
+	inline
+	uint32_t Bits(unsigned need) {
+		if(count < need) {
+			Refill();
+			if(count < need) {
+				throw DecodeError("Unexpected end of deflate stream.");
+			}
+		}
+
+		uint32_t value = (uint32_t)(bits & ((1ULL << need) - 1));
+		bits >>= need;
+		count -= need;
+		return value;
+	}
+
+	inline
+	void Put(uint8_t byte) {
+		if(position >= size) {
+			throw DecodeError("Deflate stream exceeds its expected size.");
+		}
+
+		out[position++] = byte;
+	}
+
+	static
+	void Build(Huffman &code, const uint8_t *lengths, unsigned symbols) {
+		uint16_t offsets[16];
+		int left = 1;
+
+		memset(code.count, 0, sizeof(code.count));
+		for(unsigned idx = 0; idx < symbols; idx++) {
+			code.count[lengths[idx]]++;
+		}
+
+		// Incomplete codes are allowed, but not oversubscribed ones.
+		for(unsigned len = 1; len < 16; len++) {
+			left = (left << 1) - code.count[len];
+			if(left < 0) {
+				throw DecodeError("Invalid deflate code lengths.");
+			}
+		}
+
+		offsets[1] = 0;
+		for(unsigned len = 1; len < 15; len++) {
+			offsets[len + 1] = offsets[len] + code.count[len];
+		}
+
+		for(unsigned idx = 0; idx < symbols; idx++) {
+			if(lengths[idx] != 0) {
+				code.symbol[offsets[lengths[idx]]++] = idx;
+			}
+		}
+
+		// Fill in the lookup table with bit reversed codes.
+		memset(code.fast, 0, sizeof(code.fast));
+
+		unsigned next = 0;
+		unsigned index = 0;
+		for(unsigned len = 1; len <= FAST_BITS; len++) {
+			for(unsigned idx = 0; idx < code.count[len]; idx++, next++) {
+				unsigned reversed = 0;
+				for(unsigned bit = 0; bit < len; bit++) {
+					reversed |= ((next >> bit) & 1) << (len - 1 - bit);
+				}
+
+				uint16_t entry = (uint16_t)((len << 9) | code.symbol[index++]);
+				for(unsigned fill = reversed; fill < (1U << FAST_BITS); fill += 1U << len) {
+					code.fast[fill] = entry;
+				}
+			}
+
+			next <<= 1;
+		}
+	}
+
+	uint32_t Decode(const Huffman &code) {
+		if(count < FAST_BITS) {
+			Refill();
+		}
+
+		if(count >= FAST_BITS) {
+			uint16_t entry = code.fast[bits & ((1U << FAST_BITS) - 1)];
+
+			if(entry != 0) {
+				bits >>= entry >> 9;
+				count -= entry >> 9;
+				return entry & 0x1FF;
+			}
+		}
+
+		// Walk longer codes a bit at a time.
+		unsigned value = 0;
+		unsigned first = 0;
+		unsigned index = 0;
+
+		for(unsigned len = 1; len < 16; len++) {
+			value |= Bits(1);
+
+			unsigned codes = code.count[len];
+			if(value < first + codes) {
+				return code.symbol[index + (value - first)];
+			}
+
+			index += codes;
+			first = (first + codes) << 1;
+			value <<= 1;
+		}
+
+		throw DecodeError("Invalid deflate code.");
+	}
+
+	void Stored() {
+		// Skip to the byte boundary.
+		Bits(count & 7);
+
+		uint32_t length = Bits(16);
+		if((Bits(16) ^ 0xFFFF) != length) {
+			throw DecodeError("Invalid stored deflate block length.");
+		}
+
+		// Drain whole bytes left in the bit buffer first.
+		while(length > 0 && count >= 8) {
+			Put((uint8_t)Bits(8));
+			length--;
+		}
+
+		if(length > (size_t)(end - in)) {
+			throw DecodeError("Unexpected end of deflate stream.");
+		}
+
+		if(length > size - position) {
+			throw DecodeError("Deflate stream exceeds its expected size.");
+		}
+
+		memcpy(out + position, in, length);
+		position += length;
+		in += length;
+	}
+
+	void Fixed() {
+		static const struct FixedCodes {
+			Huffman lengths;
+			Huffman distances;
+
+			FixedCodes() {
+				uint8_t sizes[288];
+
+				memset(sizes, 8, 144);
+				memset(sizes + 144, 9, 112);
+				memset(sizes + 256, 7, 24);
+				memset(sizes + 280, 8, 8);
+				Build(lengths, sizes, 288);
+
+				memset(sizes, 5, 30);
+				Build(distances, sizes, 30);
+			}
+		} fixed;
+
+		Codes(fixed.lengths, fixed.distances);
+	}
+
+	void Dynamic() {
+		uint8_t lengths[320];
+		Huffman lengthCode;
+		Huffman distanceCode;
+
+		unsigned nlen = Bits(5) + 257;
+		unsigned ndist = Bits(5) + 1;
+		unsigned ncode = Bits(4) + 4;
+
+		if(nlen > 286 || ndist > 30) {
+			throw DecodeError("Invalid deflate code counts.");
+		}
+
+		memset(lengths, 0, 19);
+		for(unsigned idx = 0; idx < ncode; idx++) {
+			lengths[code_order[idx]] = Bits(3);
+		}
+		Build(lengthCode, lengths, 19);
+
+		// Read the literal/length and distance code lengths together.
+		for(unsigned idx = 0; idx < nlen + ndist; ) {
+			uint32_t symbol = Decode(lengthCode);
+			uint8_t length = 0;
+			uint32_t repeat;
+
+			if(symbol < 16) {
+				lengths[idx++] = symbol;
+				continue;
+			}
+
+			if(symbol == 16) {
+				if(idx == 0) {
+					throw DecodeError("Invalid deflate length repeat.");
+				}
+
+				length = lengths[idx - 1];
+				repeat = 3 + Bits(2);
+			} else if(symbol == 17) {
+				repeat = 3 + Bits(3);
+			} else {
+				repeat = 11 + Bits(7);
+			}
+
+			if(idx + repeat > nlen + ndist) {
+				throw DecodeError("Invalid deflate length repeat.");
+			}
+
+			while(repeat-- > 0) {
+				lengths[idx++] = length;
+			}
+		}
+
+		if(lengths[256] == 0) {
+			throw DecodeError("Deflate block has no end code.");
+		}
+
+		Build(lengthCode, lengths, nlen);
+		Build(distanceCode, lengths + nlen, ndist);
+		Codes(lengthCode, distanceCode);
+	}
+
+	void Codes(const Huffman &lengths, const Huffman &distances) {
+		for(;;) {
+			uint32_t symbol = Decode(lengths);
+
+			if(symbol < 256) {
+				Put((uint8_t)symbol);
+				continue;
+			}
+
+			if(symbol == 256) {
+				return;
+			}
+
+			symbol -= 257;
+			if(symbol >= 29) {
+				throw DecodeError("Invalid deflate length code.");
+			}
+
+			uint32_t length = length_base[symbol] + Bits(length_extra[symbol]);
+			uint32_t code = Decode(distances);
+
+			if(code >= 30) {
+				throw DecodeError("Invalid deflate distance code.");
+			}
+
+			uint32_t distance = distance_base[code] + Bits(distance_extra[code]);
+			if(distance > position) {
+				throw DecodeError("Deflate distance is too far back.");
+			}
+
+			if(length > size - position) {
+				throw DecodeError("Deflate stream exceeds its expected size.");
+			}
+
+			// Copies may overlap their own output.
+			uint8_t *dst = out + position;
+			const uint8_t *src = dst - distance;
+			for(uint32_t idx = 0; idx < length; idx++) {
+				dst[idx] = src[idx];
+			}
+
+			position += length;
+		}
+	}
+};
+
+size_t Inflate(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_size) {
+	Inflater inflater(src, src_size, dst, dst_size);
+	return inflater.Run();
+}
+
+uint32_t Crc32(const uint8_t *data, size_t size) {
+	static const struct CrcTable {
+		uint32_t entries[256];
+
+		CrcTable() {
+			for(uint32_t idx = 0; idx < 256; idx++) {
+				uint32_t value = idx;
+
+				for(unsigned bit = 0; bit < 8; bit++) {
+					value = (value & 1) ? (value >> 1) ^ 0xEDB88320 : value >> 1;
+				}
+
+				entries[idx] = value;
+			}
+		}
+	} table;
+
+	uint32_t crc = 0xFFFFFFFF;
+	for(size_t idx = 0; idx < size; idx++) {
+		crc = table.entries[(crc ^ data[idx]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return crc ^ 0xFFFFFFFF;
+}
+
+} /* JBC */
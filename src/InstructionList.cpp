@@ -0,0 +1,910 @@
+
+# include <new>
+# include <stdio.h>
+# include <string.h>
+
+# include <algorithm>
+
+# include "Debug.h"
+# include "ClassFile.h"
+# include "ErrorTypes.h"
+# include "MemberInfo.h"
+# include "AttributeInfo.h"
+# include "StackMapFrame.h"
+# include "InstructionList.h"
+
+namespace JBC {
+
+static inline
+bool IsBranch(CodeNode *node) {
+	uint8_t format = node->Info().format;
+	return format == FORMAT_BRANCH2 || format == FORMAT_BRANCH4;
+}
+
+static inline
+bool IsSwitch(CodeNode *node) {
+	return node->Info().flow == FLOW_SWITCH;
+}
+
+// Checks that a target is set, and in the list.
+static inline
+bool IsLinked(CodeNode *target) {
+	return target != NULL && target->attached;
+}
+
+// Returns the conditional branch taken when the given one is not.
+static inline
+uint8_t InvertBranch(uint8_t opcode) {
+	if(opcode >= OP_IFEQ && opcode <= OP_IF_ACMPNE) {
+		return ((opcode - OP_IFEQ) ^ 1) + OP_IFEQ;
+	}
+
+	// ifnull and ifnonnull.
+	return opcode ^ 1;
+}
+
+// Collects the types a frame holds, but not those it shares.
+static
+void FrameTypes(StackMapFrame *frame, std::vector<VariableInfo *> &types) {
+	if(frame->tag >= 64 && frame->tag <= 127) {
+		types.push_back(static_cast<StackMapItemFrame *>(frame)->stack);
+	} else if(frame->tag == 247) {
+		types.push_back(static_cast<StackMapExtFrame *>(frame)->stack);
+	} else if(frame->tag >= 252 && frame->tag <= 254) {
+		StackMapListFrame *list = static_cast<StackMapListFrame *>(frame);
+		types.insert(types.end(), list->stack, list->stack + (frame->tag - 251));
+	} else if(frame->tag == 255) {
+		StackMapFullFrame *full = static_cast<StackMapFullFrame *>(frame);
+		types.insert(types.end(), full->locals.begin(), full->locals.end());
+		types.insert(types.end(), full->stack.begin(), full->stack.end());
+	}
+}
+
+static
+void ThrowUnlinked(const char *what) {
+	char tmp[64];
+	sprintf(tmp, "%s references a node not in the list.", what);
+	throw EncodeError(tmp);
+}
+
+InstructionList::InstructionList(CodeAttribute *code, ClassFile *classFile)
+	: head(NULL), tail(NULL), code(code), classFile(classFile), stack_map(NULL) {
+	Decode();
+	DecodeTables();
+}
+
+CodeNode *InstructionList::NewNode(uint8_t kind) {
+	CodeNode *node = new (arena.Allocate(sizeof(CodeNode))) CodeNode();
+
+	node->kind = kind;
+	return node;
+}
+
+CodeNode *InstructionList::NewLabel() {
+	return NewNode(NODE_LABEL);
+}
+
+CodeNode *InstructionList::NewOpcode(uint8_t opcode) {
+	CodeNode *node = NewNode(NODE_INSTRUCTION);
+
+	if(opcode_table[opcode].format == FORMAT_INVALID
+			|| opcode_table[opcode].format == FORMAT_WIDE) {
+		char tmp[64];
+		sprintf(tmp, "Invalid opcode %#04X.", opcode);
+		throw JBCError(tmp);
+	}
+
+	node->opcode = opcode;
+	return node;
+}
+
+CodeNode *InstructionList::NewInstruction(uint8_t opcode, uint16_t index, int32_t value) {
+	CodeNode *node = NewOpcode(opcode);
+
+	// These need their targets.
+	if(IsBranch(node)) {
+		throw JBCError("Branches must be created with NewBranch.");
+	} else if(node->opcode == OP_TABLESWITCH) {
+		throw JBCError("Switches must be created with NewTableSwitch.");
+	} else if(node->opcode == OP_LOOKUPSWITCH) {
+		throw JBCError("Switches must be created with NewLookupSwitch.");
+	}
+
+	node->index = index;
+	node->value = value;
+	return node;
+}
+
+CodeNode *InstructionList::NewBranch(uint8_t opcode, CodeNode *target) {
+	CodeNode *node = NewOpcode(opcode);
+
+	if(!IsBranch(node)) {
+		throw JBCError("Opcode is not a branch.");
+	}
+
+	// Branch widths are chosen when linking.
+	if(opcode == OP_GOTO_W) node->opcode = OP_GOTO;
+	if(opcode == OP_JSR_W) node->opcode = OP_JSR;
+
+	node->target = target;
+	return node;
+}
+
+CodeNode *InstructionList::NewTableSwitch(int32_t low, uint32_t count,
+		CodeNode **targets, CodeNode *fallback) {
+	CodeNode *node = NewOpcode(OP_TABLESWITCH);
+
+	if(count == 0 || (int64_t)low + count - 1 > INT32_MAX) {
+		throw JBCError("Invalid tableswitch bounds.");
+	}
+
+	node->low = low;
+	node->count = count;
+	node->target = fallback;
+	node->targets = (CodeNode **)arena.Allocate(count * sizeof(CodeNode *));
+	memcpy(node->targets, targets, count * sizeof(CodeNode *));
+
+	return node;
+}
+
+CodeNode *InstructionList::NewLookupSwitch(uint32_t count, int32_t *keys,
+		CodeNode **targets, CodeNode *fallback) {
+	CodeNode *node = NewOpcode(OP_LOOKUPSWITCH);
+
+	node->count = count;
+	node->target = fallback;
+
+	// Switches without cases have no tables.
+	if(count > 0) {
+		node->keys = (int32_t *)arena.Allocate(count * sizeof(int32_t));
+		node->targets = (CodeNode **)arena.Allocate(count * sizeof(CodeNode *));
+		memcpy(node->keys, keys, count * sizeof(int32_t));
+		memcpy(node->targets, targets, count * sizeof(CodeNode *));
+	}
+
+	return node;
+}
+
+CodeNode *InstructionList::InsertBefore(CodeNode *position, CodeNode *node) {
+	if(node->attached) {
+		throw JBCError("Node is already in the list.");
+	}
+
+	node->prev = position->prev;
+	node->next = position;
+
+	if(position->prev != NULL) {
+		position->prev->next = node;
+	} else {
+		head = node;
+	}
+
+	position->prev = node;
+	node->attached = true;
+	return node;
+}
+
+CodeNode *InstructionList::InsertAfter(CodeNode *position, CodeNode *node) {
+	if(node->attached) {
+		throw JBCError("Node is already in the list.");
+	}
+
+	node->prev = position;
+	node->next = position->next;
+
+	if(position->next != NULL) {
+		position->next->prev = node;
+	} else {
+		tail = node;
+	}
+
+	position->next = node;
+	node->attached = true;
+	return node;
+}
+
+CodeNode *InstructionList::Append(CodeNode *node) {
+	if(tail == NULL) {
+		if(node->attached) {
+			throw JBCError("Node is already in the list.");
+		}
+
+		head = tail = node;
+		node->attached = true;
+		return node;
+	}
+
+	return InsertAfter(tail, node);
+}
+
+CodeNode *InstructionList::Remove(CodeNode *node) {
+	if(!node->attached) return node;
+
+	if(node->prev != NULL) {
+		node->prev->next = node->next;
+	} else {
+		head = node->next;
+	}
+
+	if(node->next != NULL) {
+		node->next->prev = node->prev;
+	} else {
+		tail = node->prev;
+	}
+
+	node->prev = node->next = NULL;
+	node->attached = false;
+	return node;
+}
+
+CodeNode *InstructionList::LabelAt(uint32_t pc) {
+	CodeNode *label;
+
+	if(pc >= labels.size() || (pc < instructions.size() && instructions[pc] == NULL)) {
+		char tmp[64];
+		sprintf(tmp, "Offset %u is not an instruction boundary.", pc);
+		throw DecodeError(tmp);
+	}
+
+	if((label = labels[pc]) == NULL) {
+		label = labels[pc] = InsertBefore(instructions[pc], NewLabel());
+		label->pc = pc;
+	}
+
+	return label;
+}
+
+ExceptionTableEntry *InstructionList::AddExceptionHandler(CodeNode *start,
+		CodeNode *end, CodeNode *handler, uint16_t catch_type) {
+	ArenaScope scope(classFile->arena);
+	ExceptionTableEntry *entry = new ExceptionTableEntry;
+
+	entry->catch_type = catch_type;
+	handlers.push_back(entry);
+
+	offsets.push_back({ &entry->start_pc, start });
+	offsets.push_back({ &entry->end_pc, end });
+	offsets.push_back({ &entry->handler_pc, handler });
+	return entry;
+}
+
+/* Decoding */
+
+void InstructionList::Decode() {
+	Instruction insn;
+	CodeNode *node;
+
+	code->Load(classFile);
+
+	debug_printf(level3, "Decoding instruction list (%u bytes).\n", code->code_length);
+
+	instructions.assign(code->code_length, NULL);
+	labels.assign(code->code_length + 1, NULL);
+
+	InstructionIterator itr(code->code, code->code_length);
+	while(itr.Next(insn)) {
+		node = NewNode(NODE_INSTRUCTION);
+		node->opcode = insn.opcode;
+		node->index = insn.index;
+		node->value = insn.value;
+		node->pc = insn.pc;
+
+		// Branch widths are chosen when linking.
+		if(insn.opcode == OP_GOTO_W) node->opcode = OP_GOTO;
+		if(insn.opcode == OP_JSR_W) node->opcode = OP_JSR;
+
+		instructions[insn.pc] = Append(node);
+	}
+
+	// Marks the end of the code.
+	labels[code->code_length] = Append(NewLabel());
+	labels[code->code_length]->pc = code->code_length;
+
+	// Targets may follow their branches.
+	InstructionIterator targets(code->code, code->code_length);
+	while(targets.Next(insn)) {
+		node = instructions[insn.pc];
+
+		if(IsBranch(node)) {
+			node->target = LabelAt(insn.target);
+		} else if(IsSwitch(node)) {
+			node->target = LabelAt(insn.target);
+			node->low = insn.low;
+			node->count = insn.count;
+
+			// Switches without cases have no tables.
+			if(insn.count == 0) continue;
+
+			node->targets = (CodeNode **)arena.Allocate(insn.count * sizeof(CodeNode *));
+			if(node->opcode == OP_LOOKUPSWITCH) {
+				node->keys = (int32_t *)arena.Allocate(insn.count * sizeof(int32_t));
+			}
+
+			for(uint32_t idx = 0; idx < insn.count; idx++) {
+				node->targets[idx] = LabelAt(insn.CaseTarget(idx));
+				if(node->keys != NULL) {
+					node->keys[idx] = insn.CaseKey(idx);
+				}
+			}
+		}
+	}
+}
+
+void InstructionList::DecodeTables() {
+	uint32_t pc = 0;
+
+	for(unsigned idx = 0; idx < code->exception_table.size(); idx++) {
+		ExceptionTableEntry *entry = code->exception_table[idx];
+
+		offsets.push_back({ &entry->start_pc, LabelAt(entry->start_pc) });
+		offsets.push_back({ &entry->end_pc, LabelAt(entry->end_pc) });
+		offsets.push_back({ &entry->handler_pc, LabelAt(entry->handler_pc) });
+	}
+
+	for(unsigned idx = 0; idx < code->attributes.size(); idx++) {
+		AttributeInfo *info = code->attributes[idx];
+
+		switch(ResolveAttributeKind(info->name)) {
+			case ATTRIBUTE_LINE_NUMBER_TABLE: {
+				LineNumberTableAttribute *table = static_cast<LineNumberTableAttribute *>(info);
+
+				for(unsigned jdx = 0; jdx < table->line_number_table.size(); jdx++) {
+					LineNumberTableEntry *entry = table->line_number_table[jdx];
+					offsets.push_back({ &entry->start_pc, LabelAt(entry->start_pc) });
+				}
+				break;
+			}
+			case ATTRIBUTE_LOCAL_VARIABLE_TABLE: {
+				LocalVariableTableAttribute *table = static_cast<LocalVariableTableAttribute *>(info);
+
+				for(unsigned jdx = 0; jdx < table->local_variable_table.size(); jdx++) {
+					LocalVariableTableEntry *entry = table->local_variable_table[jdx];
+					CodeNode *start = LabelAt(entry->start_pc);
+
+					offsets.push_back({ &entry->start_pc, start });
+					lengths.push_back({ &entry->length, start,
+							LabelAt(entry->start_pc + entry->length) });
+				}
+				break;
+			}
+			case ATTRIBUTE_LOCAL_VARIABLE_TYPE_TABLE: {
+				LocalVariableTypeTableAttribute *table =
+						static_cast<LocalVariableTypeTableAttribute *>(info);
+
+				for(unsigned jdx = 0; jdx < table->local_variable_type_table.size(); jdx++) {
+					LocalVariableTypeTableEntry *entry = table->local_variable_type_table[jdx];
+					CodeNode *start = LabelAt(entry->start_pc);
+
+					offsets.push_back({ &entry->start_pc, start });
+					lengths.push_back({ &entry->length, start,
+							LabelAt(entry->start_pc + entry->length) });
+				}
+				break;
+			}
+			case ATTRIBUTE_STACK_MAP_TABLE: {
+				stack_map = static_cast<StackMapTableAttribute *>(info);
+
+				for(unsigned jdx = 0; jdx < stack_map->entries.size(); jdx++) {
+					StackMapFrame *frame = stack_map->entries[jdx];
+					std::vector<VariableInfo *> types;
+
+					// The first offset is not biased.
+					pc = jdx == 0 ? GetFrameOffsetDelta(frame)
+							: pc + GetFrameOffsetDelta(frame) + 1;
+					frames.push_back({ jdx, LabelAt(pc) });
+
+					FrameTypes(frame, types);
+					for(unsigned kdx = 0; kdx < types.size(); kdx++) {
+						if(types[kdx] == NULL || types[kdx]->tag != ITEM_UNINITIALIZED) continue;
+
+						UninitializedVariableInfo *item = static_cast<UninitializedVariableInfo *>(types[kdx]);
+						if(item->offset >= instructions.size() || instructions[item->offset] == NULL) {
+							char tmp[64];
+							sprintf(tmp, "Offset %u is not an instruction boundary.", item->offset);
+							throw DecodeError(tmp);
+						}
+
+						uninitialized.push_back({ item, instructions[item->offset] });
+					}
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+/* Merging */
+
+void InstructionList::InitialLocals(std::vector<VariableInfo *> &locals) {
+	MemberInfo *method = NULL;
+
+	for(unsigned idx = 0; idx < classFile->methods.size() && method == NULL; idx++) {
+		if(classFile->methods[idx]->GetCode() == code) method = classFile->methods[idx];
+	}
+
+	if(method == NULL || method->descriptor == NULL) {
+		throw EncodeError("Stack map frames of unknown code cannot be merged.");
+	}
+
+	// Argument types are checked before any constant is added.
+	std::vector<std::pair<uint8_t, std::string_view> > types;
+	const char *ptr = reinterpret_cast<const char *>(method->descriptor->bytes);
+	const char *end = ptr + method->descriptor->length;
+
+	if(ptr == end || *ptr++ != '(') {
+		throw EncodeError("Malformed method descriptor.");
+	}
+
+	while(ptr < end && *ptr != ')') {
+		const char *start = ptr;
+
+		switch(*ptr++) {
+			case 'B': case 'C': case 'I': case 'S': case 'Z':
+				types.push_back({ ITEM_INTEGER, std::string_view() });
+				continue;
+			case 'F':
+				types.push_back({ ITEM_FLOAT, std::string_view() });
+				continue;
+			case 'J':
+				types.push_back({ ITEM_LONG, std::string_view() });
+				continue;
+			case 'D':
+				types.push_back({ ITEM_DOUBLE, std::string_view() });
+				continue;
+			case 'L':
+				while(ptr < end && *ptr != ';') ptr++;
+				if(ptr++ >= end) break;
+
+				types.push_back({ ITEM_OBJECT, std::string_view(start + 1, ptr - start - 2) });
+				continue;
+			case '[':
+				// Array classes are named by their descriptor.
+				while(ptr < end && *ptr == '[') ptr++;
+				if(ptr >= end) break;
+
+				if(*ptr++ == 'L') {
+					while(ptr < end && *ptr != ';') ptr++;
+					if(ptr++ >= end) break;
+				}
+
+				types.push_back({ ITEM_OBJECT, std::string_view(start, ptr - start) });
+				continue;
+		}
+
+		throw EncodeError("Malformed method descriptor.");
+	}
+
+	if(ptr >= end) {
+		throw EncodeError("Malformed method descriptor.");
+	}
+
+	// The receiver is uninitialized until the super constructor runs.
+	if(!method->GetFlag(METHOD_STATIC)) {
+		ConstantClassInfo *this_class = classFile->this_class;
+		ConstantUtf8Info *name = NULL;
+
+		if(this_class != NULL && this_class->name_index < classFile->constant_pool.size()) {
+			name = dynamic_cast<ConstantUtf8Info *>(classFile->constant_pool[this_class->name_index]);
+		}
+
+		if(method->Name() == "<init>" && (name == NULL || std::string_view(
+				reinterpret_cast<char *>(name->bytes), name->length) != "java/lang/Object")) {
+			locals.push_back(new VariableInfo(ITEM_UNINITIALIZED_THIS));
+		} else {
+			ObjectVariableInfo *info = new ObjectVariableInfo(ITEM_OBJECT);
+			info->object = this_class;
+			locals.push_back(info);
+		}
+	}
+
+	for(unsigned idx = 0; idx < types.size(); idx++) {
+		if(types[idx].first == ITEM_OBJECT) {
+			ObjectVariableInfo *info = new ObjectVariableInfo(ITEM_OBJECT);
+			info->object = classFile->FindOrAddClass(types[idx].second);
+			locals.push_back(info);
+		} else {
+			locals.push_back(new VariableInfo(types[idx].first));
+		}
+	}
+}
+
+VariableInfo *InstructionList::CopyInfo(VariableInfo *info) {
+	if(info == NULL) return NULL;
+
+	if(info->tag == ITEM_OBJECT) {
+		ObjectVariableInfo *copy = new ObjectVariableInfo(ITEM_OBJECT);
+		copy->object = static_cast<ObjectVariableInfo *>(info)->object;
+		return copy;
+	} else if(info->tag == ITEM_UNINITIALIZED) {
+		UninitializedVariableInfo *copy = new UninitializedVariableInfo(ITEM_UNINITIALIZED);
+		copy->offset = static_cast<UninitializedVariableInfo *>(info)->offset;
+
+		// Follows the same instruction as the original.
+		for(unsigned idx = 0; idx < uninitialized.size(); idx++) {
+			if(uninitialized[idx].info == info) {
+				uninitialized.push_back({ copy, uninitialized[idx].node });
+				break;
+			}
+		}
+
+		return copy;
+	}
+
+	return new VariableInfo(info->tag);
+}
+
+void InstructionList::MergeFrames(std::vector<VariableInfo *> &initial, bool rebase) {
+	std::vector<VariableInfo *> locals(initial);
+	std::vector<StackMapFrame *> entries, dropped;
+	std::vector<FrameFixup> kept;
+	bool replace = false;
+
+	for(unsigned idx = 0; idx < frames.size(); idx++) {
+		StackMapFrame *frame = stack_map->entries[frames[idx].frame];
+
+		// Tracks the locals each frame describes, borrowed from the frames.
+		if(rebase) {
+			if(frame->tag >= 248 && frame->tag <= 250) {
+				locals.resize(locals.size() > 251u - frame->tag ? locals.size() - (251 - frame->tag) : 0);
+			} else if(frame->tag >= 252 && frame->tag <= 254) {
+				StackMapListFrame *list = static_cast<StackMapListFrame *>(frame);
+				locals.insert(locals.end(), list->stack, list->stack + (frame->tag - 251));
+			} else if(frame->tag == 255) {
+				locals = static_cast<StackMapFullFrame *>(frame)->locals;
+			}
+		}
+
+		// Only the last frame at an offset is kept.
+		if(idx + 1 < frames.size() && frames[idx + 1].label->pc == frames[idx].label->pc) {
+			if(frame->tag >= 248 && frame->tag != 251) replace = true;
+			dropped.push_back(frame);
+			continue;
+		}
+
+		// Rewritten against the locals of the frame before the dropped ones.
+		if(replace && frame->tag != 255) {
+			StackMapFullFrame *full = new StackMapFullFrame(255);
+
+			for(unsigned jdx = 0; jdx < locals.size(); jdx++) {
+				full->locals.push_back(CopyInfo(locals[jdx]));
+			}
+
+			if(frame->tag >= 64 && frame->tag <= 127) {
+				full->stack.push_back(CopyInfo(static_cast<StackMapItemFrame *>(frame)->stack));
+			} else if(frame->tag == 247) {
+				full->stack.push_back(CopyInfo(static_cast<StackMapExtFrame *>(frame)->stack));
+			}
+
+			dropped.push_back(frame);
+			frame = full;
+			locals = full->locals;
+		}
+
+		replace = false;
+		kept.push_back({ entries.size(), frames[idx].label });
+		entries.push_back(frame);
+	}
+
+	// Values in dropped frames no longer need their offsets.
+	std::vector<VariableInfo *> types;
+	for(unsigned idx = 0; idx < dropped.size(); idx++) {
+		FrameTypes(dropped[idx], types);
+	}
+
+	std::sort(types.begin(), types.end());
+	std::vector<UninitializedFixup> remaining;
+	for(unsigned idx = 0; idx < uninitialized.size(); idx++) {
+		VariableInfo *info = uninitialized[idx].info;
+		if(!std::binary_search(types.begin(), types.end(), info)) {
+			remaining.push_back(uninitialized[idx]);
+		}
+	}
+
+	uninitialized.swap(remaining);
+	stack_map->entries.swap(entries);
+	frames.swap(kept);
+
+	for(unsigned idx = 0; idx < dropped.size(); idx++) {
+		delete dropped[idx];
+	}
+
+	for(unsigned idx = 0; idx < initial.size(); idx++) {
+		delete initial[idx];
+	}
+
+	initial.clear();
+}
+
+/* Linking */
+
+uint32_t InstructionList::SizeAt(CodeNode *node, uint32_t pc) {
+	if(node->IsLabel()) return 0;
+
+	const OpcodeInfo &info = node->Info();
+	switch(info.format) {
+		case FORMAT_LOCAL:
+			return node->index > 255 ? 4 : 2;
+		case FORMAT_IINC:
+			return node->index > 255 || node->value < -128 || node->value > 127 ? 6 : 3;
+		case FORMAT_CONSTANT1:
+			// Becomes ldc_w.
+			return node->index > 255 ? 3 : 2;
+		case FORMAT_BRANCH2:
+		case FORMAT_BRANCH4:
+			if(!node->widened) return 3;
+			// Conditionals branch around a goto_w.
+			return info.flow == FLOW_BRANCH ? 8 : 5;
+		case FORMAT_TABLESWITCH:
+			return 1 + (3 - (pc & 3)) + 12 + 4 * node->count;
+		case FORMAT_LOOKUPSWITCH:
+			return 1 + (3 - (pc & 3)) + 8 + 8 * node->count;
+		default:
+			return info.length;
+	}
+}
+
+uint32_t InstructionList::Layout() {
+	uint64_t pc;
+	bool changed;
+
+	do {
+		pc = 0;
+		for(CodeNode *node = head; node != NULL; node = node->next) {
+			node->pc = (uint32_t)pc;
+			pc += SizeAt(node, node->pc);
+
+			if(pc > 65535) {
+				throw EncodeError("Code exceeds the maximum length.");
+			}
+		}
+
+		// Widening only grows the code, so this settles.
+		changed = false;
+		for(CodeNode *node = head; node != NULL; node = node->next) {
+			if(node->IsLabel()) continue;
+
+			if(IsSwitch(node)) {
+				if(!IsLinked(node->target)) ThrowUnlinked("A switch");
+				for(uint32_t idx = 0; idx < node->count; idx++) {
+					if(!IsLinked(node->targets[idx])) ThrowUnlinked("A switch");
+				}
+			} else if(IsBranch(node)) {
+				if(!IsLinked(node->target)) ThrowUnlinked("A branch");
+
+				int64_t offset = (int64_t)node->target->pc - node->pc;
+				if(!node->widened && (offset < INT16_MIN || offset > INT16_MAX)) {
+					node->widened = true;
+					changed = true;
+				}
+			}
+		}
+	} while(changed);
+
+	return (uint32_t)pc;
+}
+
+void InstructionList::Emit(CodeNode *node, ClassBuilder *builder) {
+	const OpcodeInfo &info = node->Info();
+	uint32_t pc = node->pc;
+
+	switch(info.format) {
+		case FORMAT_NONE:
+			builder->NextByte(node->opcode);
+			break;
+		case FORMAT_BYTE:
+		case FORMAT_NEWARRAY:
+			builder->NextByte(node->opcode);
+			builder->NextByte((uint8_t)node->value);
+			break;
+		case FORMAT_SHORT:
+			builder->NextByte(node->opcode);
+			builder->NextShort((uint16_t)node->value);
+			break;
+		case FORMAT_LOCAL:
+			if(node->index > 255) {
+				builder->NextByte(OP_WIDE);
+				builder->NextByte(node->opcode);
+				builder->NextShort(node->index);
+			} else {
+				builder->NextByte(node->opcode);
+				builder->NextByte((uint8_t)node->index);
+			}
+			break;
+		case FORMAT_IINC:
+			if(node->value < INT16_MIN || node->value > INT16_MAX) {
+				throw EncodeError("Increment exceeds the range of iinc.");
+			}
+
+			if(SizeAt(node, pc) == 6) {
+				builder->NextByte(OP_WIDE);
+				builder->NextByte(node->opcode);
+				builder->NextShort(node->index);
+				builder->NextShort((uint16_t)node->value);
+			} else {
+				builder->NextByte(node->opcode);
+				builder->NextByte((uint8_t)node->index);
+				builder->NextByte((uint8_t)node->value);
+			}
+			break;
+		case FORMAT_CONSTANT1:
+			if(node->index > 255) {
+				builder->NextByte(OP_LDC_W);
+				builder->NextShort(node->index);
+			} else {
+				builder->NextByte(node->opcode);
+				builder->NextByte((uint8_t)node->index);
+			}
+			break;
+		case FORMAT_CONSTANT2:
+			builder->NextByte(node->opcode);
+			builder->NextShort(node->index);
+			break;
+		case FORMAT_INVOKEINTERFACE:
+		case FORMAT_INVOKEDYNAMIC:
+			builder->NextByte(node->opcode);
+			builder->NextShort(node->index);
+			builder->NextByte(info.format == FORMAT_INVOKEINTERFACE ? (uint8_t)node->value : 0);
+			builder->NextByte(0);
+			break;
+		case FORMAT_MULTIANEWARRAY:
+			builder->NextByte(node->opcode);
+			builder->NextShort(node->index);
+			builder->NextByte((uint8_t)node->value);
+			break;
+		case FORMAT_BRANCH2:
+		case FORMAT_BRANCH4:
+			if(!node->widened) {
+				builder->NextByte(node->opcode);
+				builder->NextShort((uint16_t)(node->target->pc - pc));
+			} else if(info.flow == FLOW_BRANCH) {
+				// Skip the goto_w when the condition fails.
+				builder->NextByte(InvertBranch(node->opcode));
+				builder->NextShort(8);
+				builder->NextByte(OP_GOTO_W);
+				builder->NextInt(node->target->pc - (pc + 3));
+			} else {
+				builder->NextByte(info.flow == FLOW_JSR ? OP_JSR_W : OP_GOTO_W);
+				builder->NextInt(node->target->pc - pc);
+			}
+			break;
+		case FORMAT_TABLESWITCH:
+		case FORMAT_LOOKUPSWITCH:
+			builder->NextByte(node->opcode);
+			for(uint32_t pad = 3 - (pc & 3); pad > 0; pad--) {
+				builder->NextByte(0);
+			}
+
+			builder->NextInt(node->target->pc - pc);
+			if(info.format == FORMAT_TABLESWITCH) {
+				builder->NextInt(node->low);
+				builder->NextInt(node->low + (int32_t)(node->count - 1));
+
+				for(uint32_t idx = 0; idx < node->count; idx++) {
+					builder->NextInt(node->targets[idx]->pc - pc);
+				}
+			} else {
+				builder->NextInt(node->count);
+
+				for(uint32_t idx = 0; idx < node->count; idx++) {
+					builder->NextInt(node->keys[idx]);
+					builder->NextInt(node->targets[idx]->pc - pc);
+				}
+			}
+			break;
+		default:
+			throw EncodeError("Invalid opcode in instruction list.");
+	}
+}
+
+uint32_t InstructionList::Link() {
+	ArenaScope scope(classFile->arena);
+	ClassBuilder builder;
+	uint32_t length, pc = 0;
+
+	length = Layout();
+	debug_printf(level3, "Linking instruction list (%u bytes).\n", length);
+
+	builder.Reserve(length);
+	for(CodeNode *node = head; node != NULL; node = node->next) {
+		if(!node->IsLabel()) Emit(node, &builder);
+	}
+
+	// Check every fixup before the code is modified.
+	for(unsigned idx = 0; idx < offsets.size(); idx++) {
+		if(!offsets[idx].label->attached) ThrowUnlinked("A table entry");
+	}
+
+	for(unsigned idx = 0; idx < lengths.size(); idx++) {
+		LengthFixup &fixup = lengths[idx];
+
+		if(!fixup.start->attached || !fixup.end->attached) ThrowUnlinked("A table entry");
+		if(fixup.end->pc < fixup.start->pc) {
+			throw EncodeError("A table entry ends before it starts.");
+		}
+	}
+
+	bool merge = false, rebase = false;
+	for(unsigned idx = 0; idx < frames.size(); idx++) {
+		FrameFixup &fixup = frames[idx];
+
+		if(!fixup.label->attached) ThrowUnlinked("A stack map frame");
+		if(idx == 0) continue;
+
+		FrameFixup &last = frames[idx - 1];
+		if(fixup.label->pc < last.label->pc) {
+			throw EncodeError("Stack map frames are out of order.");
+		} else if(fixup.label->pc == last.label->pc) {
+			// Left at one offset by removed code.
+			uint8_t tag = stack_map->entries[last.frame]->tag;
+
+			merge = true;
+			rebase = rebase || (tag >= 248 && tag != 251);
+		}
+	}
+
+	for(unsigned idx = 0; idx < uninitialized.size(); idx++) {
+		if(!uninitialized[idx].node->attached) ThrowUnlinked("A stack map frame");
+	}
+
+	// The locals of dropped frames are followed from the method's start.
+	std::vector<VariableInfo *> initial;
+	if(rebase) InitialLocals(initial);
+
+	std::vector<uint8_t> bytes = builder.Take();
+	if(code->code != NULL && !code->borrowed) {
+		delete[] code->code;
+	}
+
+	if(Arena *arena = Arena::Current()) {
+		// Released along with the arena.
+		code->code = (uint8_t *)arena->Allocate(length);
+		code->borrowed = true;
+	} else {
+		code->code = new uint8_t[length];
+		code->borrowed = false;
+	}
+
+	memcpy(code->code, bytes.data(), length);
+	code->code_length = length;
+
+	// Tables
+	for(unsigned idx = 0; idx < offsets.size(); idx++) {
+		*offsets[idx].field = offsets[idx].label->pc;
+	}
+
+	for(unsigned idx = 0; idx < lengths.size(); idx++) {
+		*lengths[idx].field = lengths[idx].end->pc - lengths[idx].start->pc;
+	}
+
+	code->exception_table.insert(code->exception_table.end(),
+			handlers.begin(), handlers.end());
+	handlers.clear();
+
+	if(merge) MergeFrames(initial, rebase);
+	for(unsigned idx = 0; idx < frames.size(); idx++) {
+		FrameFixup &fixup = frames[idx];
+		uint32_t delta;
+
+		// The first offset is not biased.
+		delta = idx == 0 ? fixup.label->pc : fixup.label->pc - pc - 1;
+		stack_map->entries[fixup.frame] = SetFrameOffsetDelta(
+				stack_map->entries[fixup.frame], delta);
+		pc = fixup.label->pc;
+	}
+
+	for(unsigned idx = 0; idx < uninitialized.size(); idx++) {
+		uninitialized[idx].info->offset = uninitialized[idx].node->pc;
+	}
+
+	// Contents have changed since decoding.
+	code->MarkDirty();
+	for(unsigned idx = 0; idx < code->attributes.size(); idx++) {
+		code->attributes[idx]->MarkDirty();
+	}
+
+	return length;
+}
+
+} /* JBC */
@@ -0,0 +1,265 @@
+
+# include <stdio.h>
+
+# include "Inflate.h"
+# include "JarFile.h"
+# include "MappedFile.h"
+# include "ErrorTypes.h"
+# include "BatchDecoder.h"
+
+namespace JBC {
+
+// Record signatures.
+static const uint32_t LOCAL_HEADER = 0x04034B50;
+static const uint32_t CENTRAL_HEADER = 0x02014B50;
+static const uint32_t END_RECORD = 0x06054B50;
+static const uint32_t END_RECORD64 = 0x06064B50;
+static const uint32_t END_LOCATOR64 = 0x07064B50;
+
+// Fixed record sizes.
+static const size_t LOCAL_HEADER_SIZE = 30;
+static const size_t CENTRAL_HEADER_SIZE = 46;
+static const size_t END_RECORD_SIZE = 22;
+static const size_t END_RECORD64_SIZE = 56;
+static const size_t END_LOCATOR64_SIZE = 20;
+
+// Deflate cannot expand data by more than this ratio.
+static const uint64_t MAX_DEFLATE_RATIO = 1032;
+
+static inline
+uint16_t ReadShort(const uint8_t *src) {
+	return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static inline
+uint32_t ReadInt(const uint8_t *src) {
+	return (uint32_t)src[0] | ((uint32_t)src[1] << 8)
+			| ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static inline
+uint64_t ReadLong(const uint8_t *src) {
+	return (uint64_t)ReadInt(src) | ((uint64_t)ReadInt(src + 4) << 32);
+}
+
+JarFile::JarFile(const char *path)
+		: mapping(new MappedFile(path)) {
+	try {
+		ReadDirectory();
+	} catch(DecodeError &ex) {
+		// Rethrow after unmapping input.
+		delete mapping;
+		throw;
+	}
+}
+
+JarFile::~JarFile() {
+	delete mapping;
+}
+
+void JarFile::ReadDirectory() {
+	const uint8_t *data = mapping->Data();
+	size_t size = mapping->Size();
+
+	if(size < END_RECORD_SIZE) {
+		throw DecodeError("Not a zip archive.");
+	}
+
+	// The end record is followed by a comment of up to 64K.
+	size_t end = size - END_RECORD_SIZE;
+	size_t limit = end > 0xFFFF ? end - 0xFFFF : 0;
+
+	while(ReadInt(data + end) != END_RECORD
+			|| ReadShort(data + end + 20) > size - end - END_RECORD_SIZE) {
+		if(end-- == limit) {
+			throw DecodeError("Not a zip archive.");
+		}
+	}
+
+	uint64_t count = ReadShort(data + end + 10);
+	uint64_t directory_size = ReadInt(data + end + 12);
+	uint64_t directory_offset = ReadInt(data + end + 16);
+
+	if(count == 0xFFFF || directory_size == 0xFFFFFFFF || directory_offset == 0xFFFFFFFF) {
+		// The real values are in the ZIP64 end record.
+		if(end >= END_LOCATOR64_SIZE
+				&& ReadInt(data + end - END_LOCATOR64_SIZE) == END_LOCATOR64) {
+			uint64_t offset = ReadLong(data + end - END_LOCATOR64_SIZE + 8);
+
+			if(size < END_RECORD64_SIZE || offset > size - END_RECORD64_SIZE
+					|| ReadInt(data + offset) != END_RECORD64) {
+				throw DecodeError("Invalid ZIP64 end of central directory.");
+			}
+
+			count = ReadLong(data + offset + 32);
+			directory_size = ReadLong(data + offset + 40);
+			directory_offset = ReadLong(data + offset + 48);
+		}
+	}
+
+	if(directory_offset > size || directory_size > size - directory_offset) {
+		throw DecodeError("Invalid central directory.");
+	}
+
+	const uint8_t *src = data + directory_offset;
+	const uint8_t *src_end = src + directory_size;
+
+	entries.clear();
+	if(count <= directory_size / CENTRAL_HEADER_SIZE) {
+		entries.reserve(count);
+	}
+
+	for(uint64_t idx = 0; idx < count; idx++) {
+		if((size_t)(src_end - src) < CENTRAL_HEADER_SIZE || ReadInt(src) != CENTRAL_HEADER) {
+			throw DecodeError("Invalid central directory entry.");
+		}
+
+		uint16_t name_length = ReadShort(src + 28);
+		uint16_t extra_length = ReadShort(src + 30);
+		uint16_t comment_length = ReadShort(src + 32);
+		size_t record = CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+
+		if(record > (size_t)(src_end - src)) {
+			throw DecodeError("Invalid central directory entry.");
+		}
+
+		JarEntry entry;
+		entry.name = std::string_view((const char *)src + CENTRAL_HEADER_SIZE, name_length);
+		entry.flags = ReadShort(src + 8);
+		entry.method = ReadShort(src + 10);
+		entry.crc32 = ReadInt(src + 16);
+		entry.compressed_size = ReadInt(src + 20);
+		entry.size = ReadInt(src + 24);
+		entry.offset = ReadInt(src + 42);
+
+		// ZIP64 values follow, in order, for each field that overflowed.
+		const uint8_t *extra = src + CENTRAL_HEADER_SIZE + name_length;
+		const uint8_t *extra_end = extra + extra_length;
+
+		while(extra_end - extra >= 4) {
+			uint16_t id = ReadShort(extra);
+			uint16_t length = ReadShort(extra + 2);
+			const uint8_t *field = extra + 4;
+
+			if(length > extra_end - field) break;
+
+			if(id == 0x0001) {
+				const uint8_t *field_end = field + length;
+
+				if(entry.size == 0xFFFFFFFF && field_end - field >= 8) {
+					entry.size = ReadLong(field);
+					field += 8;
+				}
+
+				if(entry.compressed_size == 0xFFFFFFFF && field_end - field >= 8) {
+					entry.compressed_size = ReadLong(field);
+					field += 8;
+				}
+
+				if(entry.offset == 0xFFFFFFFF && field_end - field >= 8) {
+					entry.offset = ReadLong(field);
+				}
+			}
+
+			extra += 4 + length;
+		}
+
+		entries.push_back(entry);
+		src += record;
+	}
+}
+
+const JarEntry *JarFile::Find(std::string_view name) const {
+	for(std::vector<JarEntry>::const_iterator itr = entries.begin();
+			itr != entries.end(); itr++) {
+		if(itr->name == name) {
+			return &*itr;
+		}
+	}
+
+	return NULL;
+}
+
+std::vector<const JarEntry *> JarFile::Select(bool (*filter)(std::string_view name)) const {
+	std::vector<const JarEntry *> selected;
+
+	for(std::vector<JarEntry>::const_iterator itr = entries.begin();
+			itr != entries.end(); itr++) {
+		std::string_view name = itr->name;
+
+		if(name.size() < 6 || name.substr(name.size() - 6) != ".class") {
+			continue;
+		}
+
+		if(filter == NULL || filter(name)) {
+			selected.push_back(&*itr);
+		}
+	}
+
+	return selected;
+}
+
+const uint8_t *JarFile::Read(const JarEntry &entry, std::vector<uint8_t> &buffer) const {
+	const uint8_t *data = mapping->Data();
+	size_t size = mapping->Size();
+	const uint8_t *contents;
+
+	if(entry.flags & 0x0001) {
+		throw DecodeError("Encrypted jar entries are not supported.");
+	}
+
+	if(entry.offset > size || size - entry.offset < LOCAL_HEADER_SIZE
+			|| ReadInt(data + entry.offset) != LOCAL_HEADER) {
+		throw DecodeError("Invalid jar entry header.");
+	}
+
+	// The local name and extra field may differ from the central ones.
+	const uint8_t *local = data + entry.offset;
+	uint64_t start = entry.offset + LOCAL_HEADER_SIZE
+			+ ReadShort(local + 26) + ReadShort(local + 28);
+
+	if(start > size || entry.compressed_size > size - start) {
+		throw DecodeError("Jar entry extends past the end of the archive.");
+	}
+
+	switch(entry.method) {
+		case JAR_STORED:
+			if(entry.compressed_size != entry.size) {
+				throw DecodeError("Invalid stored jar entry size.");
+			}
+
+			contents = data + start;
+			break;
+		case JAR_DEFLATED:
+			if(entry.size / MAX_DEFLATE_RATIO > entry.compressed_size) {
+				throw DecodeError("Invalid deflated jar entry size.");
+			}
+
+			buffer.resize(entry.size);
+			if(Inflate(data + start, entry.compressed_size, buffer.data(), entry.size)
+					!= entry.size) {
+				throw DecodeError("Jar entry is shorter than its recorded size.");
+			}
+
+			contents = buffer.data();
+			break;
+		default: {
+			char tmp[64];
+			sprintf(tmp, "Unsupported jar compression method : %u.", entry.method);
+			throw DecodeError(tmp);
+		}
+	}
+
+	if(Crc32(contents, entry.size) != entry.crc32) {
+		throw DecodeError("Jar entry checksum mismatch.");
+	}
+
+	return contents;
+}
+
+ClassBatch *DecodeJarFile(JarFile *jar, bool (*filter)(std::string_view name),
+		unsigned threads, const DecodeOptions &options) {
+	return DecodeClassFiles(jar, jar->Select(filter), threads, options);
+}
+
+} /* JBC */
@@ -0,0 +1,88 @@
+
+# include "LoopNest.h"
+
+namespace JBC {
+
+LoopNest::LoopNest() {
+}
+
+LoopNest::LoopNest(CodeAttribute *code, ClassFile *classFile) {
+	Build(code, classFile);
+}
+
+void LoopNest::Build(CodeAttribute *code, ClassFile *classFile) {
+	graph.Build(code, classFile);
+	dominators.Build(graph);
+
+	loops.clear();
+	block_loop.assign(graph.BlockCount(), NONE);
+
+	// Visit headers in postorder, so inner loops are found first.
+	const std::vector<uint32_t> &order = dominators.ReversePostorder();
+
+	for(uint32_t idx = order.size(); idx-- > 0; ) {
+		uint32_t header = order[idx];
+		const ControlFlowEdge *preds = graph.Predecessors(header);
+		uint32_t id = loops.size();
+
+		worklist.clear();
+		for(uint32_t edge = 0; edge < graph.Block(header).predecessor_count; edge++) {
+			if(IsBackEdge(preds[edge].block, header)) {
+				worklist.push_back(preds[edge].block);
+			}
+		}
+
+		if(worklist.empty()) continue;
+
+		Loop loop = { header, NONE, 0, true };
+		loops.push_back(loop);
+		block_loop[header] = id;
+
+		// Walk backwards from the back edges to the header.
+		while(!worklist.empty()) {
+			uint32_t block = worklist.back();
+			uint32_t inner = block_loop[block];
+			worklist.pop_back();
+
+			if(inner == NONE) {
+				block_loop[block] = id;
+			} else {
+				// Already in a loop; continue from its outermost header.
+				while(loops[inner].parent != NONE) {
+					inner = loops[inner].parent;
+				}
+
+				if(inner == id) continue;
+
+				loops[inner].parent = id;
+				loops[id].innermost = false;
+				block = loops[inner].header;
+			}
+
+			const ControlFlowEdge *edges = graph.Predecessors(block);
+			for(uint32_t edge = 0; edge < graph.Block(block).predecessor_count; edge++) {
+				if(dominators.IsReachable(edges[edge].block)) {
+					worklist.push_back(edges[edge].block);
+				}
+			}
+		}
+	}
+
+	// Parents follow their children.
+	for(uint32_t idx = loops.size(); idx-- > 0; ) {
+		Loop &loop = loops[idx];
+		loop.depth = loop.parent == NONE ? 1 : loops[loop.parent].depth + 1;
+	}
+}
+
+uint32_t LoopNest::DepthAt(uint32_t pc) const {
+	uint32_t block = graph.BlockAt(pc);
+
+	if(block == graph.BlockCount()) {
+		return 0;
+	}
+
+	return BlockDepth(block);
+}
+
+} /* JBC */
@@ -0,0 +1,55 @@
+
+# include <errno.h>
+# include <fcntl.h>
+# include <string.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+# include "MappedFile.h"
+
+namespace JBC {
+
+MappedFile::MappedFile(const char *path)
+		: data(NULL), size(0) {
+	struct stat info;
+	int fd;
+
+	if(path == NULL) {
+		throw BufferError("Invalid input path.");
+	}
+
+	if((fd = open(path, O_RDONLY)) < 0) {
+		throw BufferError(strerror(errno));
+	}
+
+	if(fstat(fd, &info) < 0) {
+		int error = errno;
+		close(fd);
+		throw BufferError(strerror(error));
+	}
+
+	// Nothing to map for an empty file.
+	if((size = info.st_size) > 0) {
+		void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapping == MAP_FAILED) {
+			int error = errno;
+			close(fd);
+			throw BufferError(strerror(error));
+		}
+
+		data = static_cast<uint8_t *>(mapping);
+		madvise(data, size, MADV_SEQUENTIAL);
+	}
+
+	// The mapping outlives the descriptor.
+	close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if(data != NULL) {
+		munmap(data, size);
+	}
+}
+
+} /* JBC */
@@ -9,6 +9,7 @@
 namespace JBC {
 
 MemberInfo *MemberInfo::DecodeMember(ClassBuffer *buffer, ClassFile *classFile) {
+	size_t start = buffer->Position();
 	uint16_t index, length;
 
 	// Access Flags
@@ -17,20 +18,35 @@ MemberInfo *MemberInfo::DecodeMember(ClassBuffer *buffer, ClassFile *classFile)
 	// Member Name
 	index = buffer->NextShort();
 	name = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level1, "Member Name : %s.\n", name->bytes);
+	debug_printf(level1, "Member Name : %.*s.\n", name->length, name->bytes);
 
 	// Member Descriptor
 	index = buffer->NextShort();
 	descriptor = static_cast<ConstantUtf8Info *>(classFile->constant_pool[index]);
-	debug_printf(level1, "Member Descriptor : %s.\n", descriptor->bytes);
+	debug_printf(level1, "Member Descriptor : %.*s.\n", descriptor->length, descriptor->bytes);
+
+	if(classFile->options.depth < DECODE_FULL) {
+		// Signature only.
+		SkipAttributes(buffer);
+		return this;
+	}
 
 	// Member Attributes Table
 	length = buffer->NextShort();
 	debug_printf(level1, "Member Attributes Count : %d.\n", length);
 
+	attributes.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		debug_printf(level2, "Member Attribute %d :\n", idx);
-		attributes.push_back(DecodeAttribute(buffer, classFile));
+		if(AttributeInfo *info = DecodeAttribute(buffer, classFile)) {
+			attributes.push_back(info);
+		}
+	}
+
+	if(buffer->IsPersistent() && classFile->options.copy_unmodified) {
+		// Record the encoded member, for pass-through.
+		source_length = buffer->Position() - start;
+		source = buffer->Current() - source_length;
 	}
 
 	return this;
@@ -11,16 +11,23 @@ namespace JBC {
 MemberInfo *MemberInfo::EncodeMember(ClassBuilder *builder, ClassFile *classFile) {
 	uint16_t length;
 
+	if(classFile->CanReuseSource() && !IsDirty()) {
+		// Unmodified since decoding.
+		debug_printf(level1, "Copying unmodified member (%u bytes).\n", source_length);
+		builder->Next(source, source_length);
+		return this;
+	}
+
 	// Access Flags
 	builder->NextShort(access_flags);
 
 	// Member Name
 	builder->NextShort(name->index);
-	debug_printf(level1, "Member Name : %s.\n", name->bytes);
+	debug_printf(level1, "Member Name : %.*s.\n", name->length, name->bytes);
 
 	// Member Descriptor
 	builder->NextShort(descriptor->index);
-	debug_printf(level1, "Member Descriptor : %s.\n", descriptor->bytes);
+	debug_printf(level1, "Member Descriptor : %.*s.\n", descriptor->length, descriptor->bytes);
 
 	builder->NextShort((uint16_t)(length = attributes.size()));
 	debug_printf(level1, "Member Attributes Count : %d.\n", length);
@@ -33,4 +40,10 @@ MemberInfo *MemberInfo::EncodeMember(ClassBuilder *builder, ClassFile *classFile
 	return this;
 }
 
+uint32_t MemberInfo::ComputeSize() {
+	if(!IsDirty()) return source_length;
+
+	return 2 + 2 + 2 + ComputeAttributesSize(attributes);
+}
+
 } /* JBC */
@@ -0,0 +1,117 @@
+
+# include <functional>
+
+# include "MemberInfo.h"
+# include "MemberIndex.h"
+
+namespace JBC {
+
+static inline
+std::string_view NameOf(MemberInfo *member) {
+	return member->name == NULL ? std::string_view() : member->name->View();
+}
+
+static inline
+std::string_view DescriptorOf(MemberInfo *member) {
+	return member->descriptor == NULL ? std::string_view()
+			: member->descriptor->View();
+}
+
+static inline
+size_t HashName(std::string_view name) {
+	return std::hash<std::string_view>()(name);
+}
+
+static inline
+size_t HashSignature(std::string_view name, std::string_view descriptor) {
+	size_t hash = HashName(name);
+	return hash ^ (std::hash<std::string_view>()(descriptor)
+			+ 0x9E3779B9 + (hash << 6) + (hash >> 2));
+}
+
+void MemberIndex::Insert(MemberInfo *member, size_t position) {
+	std::string_view name, descriptor;
+
+	if(member == NULL) return;
+
+	name = NameOf(member);
+	descriptor = DescriptorOf(member);
+
+	names.emplace(HashName(name), position);
+	signatures.emplace(HashSignature(name, descriptor), position);
+}
+
+void MemberIndex::Rebuild(std::vector<MemberInfo *> &members) {
+	names.clear();
+	signatures.clear();
+
+	names.reserve(members.size());
+	signatures.reserve(members.size());
+
+	for(size_t idx = 0; idx < members.size(); idx++) {
+		Insert(members[idx], idx);
+	}
+
+	count = members.size();
+	valid = true;
+}
+
+void MemberIndex::Append(std::vector<MemberInfo *> &members) {
+	if(!valid) return;
+
+	if(count + 1 != members.size()) {
+		// Table was changed elsewhere.
+		valid = false;
+		return;
+	}
+
+	Insert(members.back(), count++);
+}
+
+MemberInfo **MemberIndex::Find(std::vector<MemberInfo *> &members,
+		std::string_view name) {
+	MemberInfo **found = NULL;
+
+	if(!valid || count != members.size()) {
+		Rebuild(members);
+	}
+
+	// Overloads share a name; pick the first declared.
+	std::pair<Table::iterator, Table::iterator> range
+			= names.equal_range(HashName(name));
+	for(Table::iterator itr = range.first; itr != range.second; itr++) {
+		MemberInfo **entry = &members[itr->second];
+
+		if(*entry != NULL && NameOf(*entry) == name
+				&& (found == NULL || entry < found)) {
+			found = entry;
+		}
+	}
+
+	return found;
+}
+
+MemberInfo **MemberIndex::Find(std::vector<MemberInfo *> &members,
+		std::string_view name, std::string_view descriptor) {
+	MemberInfo **found = NULL;
+
+	if(!valid || count != members.size()) {
+		Rebuild(members);
+	}
+
+	std::pair<Table::iterator, Table::iterator> range
+			= signatures.equal_range(HashSignature(name, descriptor));
+	for(Table::iterator itr = range.first; itr != range.second; itr++) {
+		MemberInfo **entry = &members[itr->second];
+
+		if(*entry != NULL && NameOf(*entry) == name
+				&& DescriptorOf(*entry) == descriptor
+				&& (found == NULL || entry < found)) {
+			found = entry;
+		}
+	}
+
+	return found;
+}
+
+} /* JBC */
@@ -8,11 +8,13 @@
 namespace JBC {
 
 MemberInfo::MemberInfo()
-	: access_flags(0), name(NULL), descriptor(NULL) {
+	: access_flags(0), name(NULL), descriptor(NULL),
+	  source(NULL), source_length(0) {
 }
 
 MemberInfo::~MemberInfo() {
-	debug_printf(level1, "Deleting member : %s.\n", 
+	debug_printf(level1, "Deleting member : %.*s.\n",
+			(name == NULL || name->bytes == NULL ? 6 : name->length),
 			(name == NULL || name->bytes == NULL ? "<NULL>" : (char *)name->bytes));
 
 	if(!attributes.empty()) {
@@ -24,4 +26,36 @@ MemberInfo::~MemberInfo() {
 	}
 }
 
+static inline
+uint16_t SourceShort(const uint8_t *source, size_t offset) {
+	return (source[offset] << 8) | source[offset + 1];
+}
+
+CodeAttribute *MemberInfo::GetCode() {
+	for(unsigned idx = 0; idx < attributes.size(); idx++) {
+		CodeAttribute *code = dynamic_cast<CodeAttribute *>(attributes[idx]);
+		if(code != NULL) return code;
+	}
+
+	return NULL;
+}
+
+bool MemberInfo::IsDirty() {
+	if(source == NULL) return true;
+
+	// Compare against the encoded header.
+	if(access_flags != SourceShort(source, 0)
+			|| name == NULL || name->index != SourceShort(source, 2)
+			|| descriptor == NULL || descriptor->index != SourceShort(source, 4)
+			|| attributes.size() != SourceShort(source, 6)) {
+		return true;
+	}
+
+	for(unsigned idx = 0; idx < attributes.size(); idx++) {
+		if(attributes[idx]->IsDirty()) return true;
+	}
+
+	return false;
+}
+
 } /* JBC */
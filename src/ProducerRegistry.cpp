@@ -0,0 +1,85 @@
+
+# include <string.h>
+
+# include "ProducerRegistry.h"
+
+namespace JBC {
+
+ProducerRegistry::ProducerRegistry() {
+	Snapshot *empty = new Snapshot;
+
+	memset(empty->constants, 0, sizeof(empty->constants));
+	empty->previous = NULL;
+	current.store(empty);
+}
+
+ProducerRegistry::~ProducerRegistry() {
+	const Snapshot *snapshot = current.load();
+
+	while(snapshot != NULL) {
+		const Snapshot *previous = snapshot->previous;
+		delete snapshot;
+		snapshot = previous;
+	}
+}
+
+ProducerRegistry &ProducerRegistry::Global() {
+	static ProducerRegistry registry;
+	return registry;
+}
+
+template<typename Modify>
+void ProducerRegistry::Publish(Modify modify) {
+	const Snapshot *snapshot = current.load(std::memory_order_acquire);
+
+	for(;;) {
+		Snapshot *next = new Snapshot(*snapshot);
+		next->previous = snapshot;
+		modify(next);
+
+		// Retry against the latest snapshot if another thread won.
+		if(current.compare_exchange_weak(snapshot, next,
+				std::memory_order_acq_rel, std::memory_order_acquire)) {
+			return;
+		}
+
+		delete next;
+	}
+}
+
+void ProducerRegistry::Register(uint8_t tag, ConstantProducer producer) {
+	Publish([=](Snapshot *next) {
+		next->constants[tag] = producer;
+	});
+}
+
+void ProducerRegistry::Register(std::string_view name, AttributeProducer producer) {
+	Publish([=](Snapshot *next) {
+		std::vector<std::pair<std::string, AttributeProducer> > &attributes = next->attributes;
+
+		for(size_t idx = 0; idx < attributes.size(); idx++) {
+			if(attributes[idx].first == name) {
+				attributes.erase(attributes.begin() + idx);
+				break;
+			}
+		}
+
+		if(producer != NULL) {
+			attributes.push_back(std::make_pair(std::string(name), producer));
+		}
+	});
+}
+
+AttributeProducer ProducerRegistry::Find(std::string_view name) const {
+	const Snapshot *snapshot = current.load(std::memory_order_acquire);
+
+	for(size_t idx = 0; idx < snapshot->attributes.size(); idx++) {
+		if(snapshot->attributes[idx].first == name) {
+			return snapshot->attributes[idx].second;
+		}
+	}
+
+	return NULL;
+}
+
+} /* JBC */
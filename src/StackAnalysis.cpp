@@ -0,0 +1,285 @@
+
+# include <stdio.h>
+
+# include "Bytecode.h"
+# include "ClassFile.h"
+# include "ErrorTypes.h"
+# include "MemberInfo.h"
+# include "ConstantInfo.h"
+# include "AttributeInfo.h"
+# include "StackAnalysis.h"
+# include "ControlFlowGraph.h"
+
+namespace JBC {
+
+static const uint32_t UNVISITED = 0xFFFFFFFF;
+
+static
+void ThrowMalformed(const char *reason, uint32_t pc) {
+	char tmp[64];
+	sprintf(tmp, "%s at pc %u.", reason, pc);
+	throw DecodeError(tmp);
+}
+
+// Parses one field type, returning the slots it takes.
+static
+uint32_t TypeSlots(const uint8_t *&ptr, const uint8_t *end) {
+	if(ptr >= end) {
+		throw DecodeError("Malformed descriptor.");
+	}
+
+	switch(*ptr++) {
+		case 'B': case 'C': case 'F': case 'I':
+		case 'S': case 'Z':
+			return 1;
+		case 'J': case 'D':
+			return 2;
+		case 'V':
+			return 0;
+		case 'L':
+			while(ptr < end && *ptr != ';') ptr++;
+			if(ptr++ >= end) break;
+			return 1;
+		case '[':
+			while(ptr < end && *ptr == '[') ptr++;
+			if(TypeSlots(ptr, end) == 0) break;
+			return 1;
+	}
+
+	throw DecodeError("Malformed descriptor.");
+}
+
+uint32_t ArgumentSlots(ConstantUtf8Info *descriptor, uint32_t *returns) {
+	const uint8_t *ptr = descriptor->bytes;
+	const uint8_t *end = ptr + descriptor->length;
+	uint32_t slots = 0;
+
+	if(ptr >= end || *ptr++ != '(') {
+		throw DecodeError("Malformed method descriptor.");
+	}
+
+	while(ptr < end && *ptr != ')') {
+		uint32_t size = TypeSlots(ptr, end);
+		if(size == 0) {
+			throw DecodeError("Malformed method descriptor.");
+		}
+
+		slots += size;
+	}
+
+	if(ptr++ >= end) {
+		throw DecodeError("Malformed method descriptor.");
+	}
+
+	uint32_t result = TypeSlots(ptr, end);
+	if(returns != NULL) *returns = result;
+
+	return slots;
+}
+
+ConstantNameAndTypeInfo *ReferenceNameAndType(ConstantInfo *constant, ClassFile *classFile) {
+	uint16_t index = 0;
+
+	if(constant != NULL) {
+		switch(constant->tag) {
+			case CONSTANT_FIELD_REF:
+				index = static_cast<ConstantFieldRefInfo *>(constant)->name_and_type_index;
+				break;
+			case CONSTANT_METHOD_REF:
+				index = static_cast<ConstantMethodRefInfo *>(constant)->name_and_type_index;
+				break;
+			case CONSTANT_INTERFACE_METHOD_REF:
+				index = static_cast<ConstantInterfaceMethodRefInfo *>(constant)->name_and_type_index;
+				break;
+			case CONSTANT_INVOKE_DYNAMIC:
+				index = static_cast<ConstantInvokeDynamicInfo *>(constant)->name_and_type_index;
+				break;
+		}
+	}
+
+	if(index == 0 || index >= classFile->constant_pool.size()) {
+		return NULL;
+	}
+
+	return dynamic_cast<ConstantNameAndTypeInfo *>(classFile->constant_pool[index]);
+}
+
+// Resolves the descriptor of a field, method or call site reference.
+static
+ConstantUtf8Info *ReferenceDescriptor(const Instruction &insn, ClassFile *classFile) {
+	ConstantNameAndTypeInfo *nameAndType = ReferenceNameAndType(insn.constant, classFile);
+
+	if(nameAndType == NULL || nameAndType->descriptor_index == 0
+			|| nameAndType->descriptor_index >= classFile->constant_pool.size()) {
+		ThrowMalformed("Invalid member reference", insn.pc);
+	}
+
+	ConstantUtf8Info *descriptor = dynamic_cast<ConstantUtf8Info *>(
+			classFile->constant_pool[nameAndType->descriptor_index]);
+	if(descriptor == NULL) {
+		ThrowMalformed("Invalid member reference", insn.pc);
+	}
+
+	return descriptor;
+}
+
+// Returns the change in stack depth, and the slots popped first.
+static
+int32_t StackEffect(const Instruction &insn, ClassFile *classFile, uint32_t &pops) {
+	const OpcodeInfo &info = insn.Info();
+	uint32_t pushes = info.pushes;
+	pops = info.pops;
+
+	switch(insn.opcode) {
+		case OP_GETSTATIC:
+		case OP_PUTSTATIC:
+		case OP_GETFIELD:
+		case OP_PUTFIELD: {
+			ConstantUtf8Info *descriptor = ReferenceDescriptor(insn, classFile);
+			const uint8_t *ptr = descriptor->bytes;
+			uint32_t size = TypeSlots(ptr, ptr + descriptor->length);
+
+			bool instance = insn.opcode == OP_GETFIELD || insn.opcode == OP_PUTFIELD;
+			bool load = insn.opcode == OP_GETSTATIC || insn.opcode == OP_GETFIELD;
+
+			pops = (instance ? 1 : 0) + (load ? 0 : size);
+			pushes = load ? size : 0;
+			break;
+		}
+		case OP_INVOKEVIRTUAL:
+		case OP_INVOKESPECIAL:
+		case OP_INVOKESTATIC:
+		case OP_INVOKEINTERFACE:
+		case OP_INVOKEDYNAMIC: {
+			ConstantUtf8Info *descriptor = ReferenceDescriptor(insn, classFile);
+			bool receiver = insn.opcode != OP_INVOKESTATIC && insn.opcode != OP_INVOKEDYNAMIC;
+
+			pops = ArgumentSlots(descriptor, &pushes) + (receiver ? 1 : 0);
+			break;
+		}
+		case OP_MULTIANEWARRAY:
+			pops = insn.value;
+			break;
+	}
+
+	return (int32_t)pushes - (int32_t)pops;
+}
+
+CodeLimits ComputeCodeLimits(MemberInfo *method, CodeAttribute *code, ClassFile *classFile) {
+	ControlFlowGraph graph(code, classFile);
+	InstructionIterator itr(code->code, code->code_length, classFile);
+	std::vector<uint32_t> depths(graph.BlockCount(), UNVISITED);
+	std::vector<uint32_t> worklist;
+	Instruction insn;
+
+	CodeLimits limits = { 0, 0 };
+	uint32_t max_stack = 0;
+	uint32_t max_locals = ArgumentSlots(method->descriptor)
+			+ (method->GetFlag(METHOD_STATIC) ? 0 : 1);
+
+	// Propagate stack depths from the entry block.
+	if(graph.BlockCount() > 0) {
+		depths[0] = 0;
+		worklist.push_back(0);
+	}
+
+	while(!worklist.empty()) {
+		uint32_t block = worklist.back();
+		const BasicBlock &info = graph.Block(block);
+		uint32_t depth = depths[block];
+		worklist.pop_back();
+
+		if(depth > max_stack) max_stack = depth;
+
+		itr.Seek(info.start);
+		while(itr.Position() < info.end && itr.Next(insn)) {
+			uint32_t pops;
+			int32_t delta = StackEffect(insn, classFile, pops);
+
+			if(depth < pops) {
+				ThrowMalformed("Stack underflow", insn.pc);
+			}
+
+			depth += delta;
+			if(depth > max_stack) max_stack = depth;
+		}
+
+		const ControlFlowEdge *edges = graph.Successors(block);
+		for(uint32_t idx = 0; idx < info.successor_count; idx++) {
+			uint32_t succ = edges[idx].block;
+			uint32_t entry = depth;
+
+			if(edges[idx].kind == EDGE_EXCEPTION) {
+				// Handlers start with only the exception.
+				entry = 1;
+			} else if(edges[idx].kind == EDGE_FALLTHROUGH && insn.Info().flow == FLOW_JSR) {
+				// The subroutine consumes its return address.
+				entry = depth - 1;
+			}
+
+			if(depths[succ] == UNVISITED) {
+				depths[succ] = entry;
+				worklist.push_back(succ);
+			} else if(depths[succ] != entry) {
+				ThrowMalformed("Inconsistent stack depth", graph.Block(succ).start);
+			}
+		}
+	}
+
+	if(max_stack > 0xFFFF) {
+		throw DecodeError("Operand stack exceeds 65535 slots.");
+	}
+
+	// Find the highest local variable slot used.
+	itr.Seek(0);
+	while(itr.Next(insn)) {
+		uint32_t index = insn.index;
+		uint32_t size = 1;
+		uint8_t op = insn.opcode;
+
+		if(op >= OP_ILOAD_0 && op <= OP_ALOAD_3) {
+			index = (op - OP_ILOAD_0) & 3;
+			op = OP_ILOAD + (op - OP_ILOAD_0) / 4;
+		} else if(op >= OP_ISTORE_0 && op <= OP_ASTORE_3) {
+			index = (op - OP_ISTORE_0) & 3;
+			op = OP_ISTORE + (op - OP_ISTORE_0) / 4;
+		} else if(insn.Info().format != FORMAT_LOCAL && op != OP_IINC) {
+			continue;
+		}
+
+		if(op == OP_LLOAD || op == OP_DLOAD || op == OP_LSTORE || op == OP_DSTORE) {
+			size = 2;
+		}
+
+		if(index + size > max_locals) {
+			max_locals = index + size;
+		}
+	}
+
+	if(max_locals > 0xFFFF) {
+		throw DecodeError("Local variables exceed 65535 slots.");
+	}
+
+	limits.max_stack = max_stack;
+	limits.max_locals = max_locals;
+
+	return limits;
+}
+
+bool UpdateCodeLimits(MemberInfo *method, ClassFile *classFile) {
+	CodeAttribute *code = method->GetCode();
+	if(code == NULL) return false;
+
+	CodeLimits limits = ComputeCodeLimits(method, code, classFile);
+	if(limits.max_stack == code->max_stack && limits.max_locals == code->max_locals) {
+		return false;
+	}
+
+	code->max_stack = limits.max_stack;
+	code->max_locals = limits.max_locals;
+	code->MarkDirty();
+
+	return true;
+}
+
+} /* JBC */
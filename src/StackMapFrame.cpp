@@ -64,8 +64,7 @@ VariableInfo *DecodeVariableInfo(ClassBuffer *buffer, ClassFile *classFile) {
 
 ObjectVariableInfo *ObjectVariableInfo
 		::EncodeInfo(ClassBuilder *builder, ClassFile *) {
-	if(object != NULL)
-		builder->NextShort(object->index);
+	builder->NextShort(object == NULL ? 0 : object->index);
 	return this;
 }
 
@@ -121,12 +120,14 @@ StackMapFullFrame *StackMapFullFrame
 
 	// Stack Frame Locals
 	length = buffer->NextShort();
+	locals.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		locals.push_back(DecodeVariableInfo(buffer, classFile));
 	}
 
 	// Stack Frame Items
 	length = buffer->NextShort();
+	stack.reserve(length);
 	for(unsigned idx = 0; idx < length; idx++) {
 		stack.push_back(DecodeVariableInfo(buffer, classFile));
 	}
@@ -245,12 +246,108 @@ void EncodeStackMapFrame(
 	frame->EncodeFrame(builder, classFile);
 }
 
+/* Stack Map Frame sizes */
+
+uint32_t StackMapItemFrame::ComputeSize() {
+	return 1 + stack->ComputeSize();
+}
+
+uint32_t StackMapExtFrame::ComputeSize() {
+	return 1 + 2 + stack->ComputeSize();
+}
+
+uint32_t StackMapListFrame::ComputeSize() {
+	uint32_t size = 1 + 2;
+
+	for(unsigned idx = 0; idx < (tag - 251u); idx++) {
+		size += stack[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
+uint32_t StackMapFullFrame::ComputeSize() {
+	uint32_t size = 1 + 2;
+
+	// Stack Frame Locals
+	size += 2;
+	for(unsigned idx = 0; idx < locals.size(); idx++) {
+		size += locals[idx]->ComputeSize();
+	}
+
+	// Stack Frame Items
+	size += 2;
+	for(unsigned idx = 0; idx < stack.size(); idx++) {
+		size += stack[idx]->ComputeSize();
+	}
+
+	return size;
+}
+
 /* Stack Map Frame destructors */
 
 StackMapFrame::~StackMapFrame() {
 	debug_printf(level3, "Deleting Stack Map Frame.\n");
 }
 
+uint16_t GetFrameOffsetDelta(StackMapFrame *frame) {
+	if(frame->tag <= 63) {
+		return frame->tag;
+	} else if(frame->tag <= 127) {
+		return frame->tag - 64;
+	} else if(frame->tag == 247) {
+		return static_cast<StackMapExtFrame *>(frame)->offset_delta;
+	} else if(frame->tag <= 251) {
+		return static_cast<StackMapOffFrame *>(frame)->offset_delta;
+	} else if(frame->tag <= 254) {
+		return static_cast<StackMapListFrame *>(frame)->offset_delta;
+	}
+
+	return static_cast<StackMapFullFrame *>(frame)->offset_delta;
+}
+
+StackMapFrame *SetFrameOffsetDelta(StackMapFrame *frame, uint16_t delta) {
+	if(frame->tag <= 63) {
+		if(delta <= 63) {
+			frame->tag = delta;
+			return frame;
+		}
+
+		// Becomes a same_frame_extended.
+		StackMapOffFrame *ext = new StackMapOffFrame(251);
+		ext->offset_delta = delta;
+
+		delete frame;
+		return ext;
+	} else if(frame->tag <= 127) {
+		StackMapItemFrame *item = static_cast<StackMapItemFrame *>(frame);
+
+		if(delta <= 63) {
+			item->tag = 64 + delta;
+			return item;
+		}
+
+		// Becomes a same_locals_1_stack_item_frame_extended.
+		StackMapExtFrame *ext = new StackMapExtFrame(247);
+		ext->offset_delta = delta;
+		ext->stack = item->stack;
+
+		item->stack = NULL;
+		delete item;
+		return ext;
+	} else if(frame->tag == 247) {
+		static_cast<StackMapExtFrame *>(frame)->offset_delta = delta;
+	} else if(frame->tag <= 251) {
+		static_cast<StackMapOffFrame *>(frame)->offset_delta = delta;
+	} else if(frame->tag <= 254) {
+		static_cast<StackMapListFrame *>(frame)->offset_delta = delta;
+	} else {
+		static_cast<StackMapFullFrame *>(frame)->offset_delta = delta;
+	}
+
+	return frame;
+}
+
 StackMapItemFrame::~StackMapItemFrame() {
 	debug_printf(level3, "Deleting Stack Map Item Frame.\n");
 	if(stack != NULL) {
@@ -270,7 +367,7 @@ StackMapListFrame::~StackMapListFrame() {
 	if(stack != NULL) {
 		for(unsigned idx = 0; idx < tag - 251u; idx++)
 			delete stack[idx];
-		delete stack;
+		delete[] stack;
 	}
 }
 
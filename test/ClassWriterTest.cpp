@@ -0,0 +1,204 @@
+
+# include <stdio.h>
+# include <stdlib.h>
+
+# include <vector>
+# include <string_view>
+
+# include "ClassFile.h"
+# include "MemberInfo.h"
+# include "ErrorTypes.h"
+# include "AttributeInfo.h"
+# include "ClassVisitor.h"
+# include "ClassWriter.h"
+# include "TestSupport.h"
+
+using namespace JBC;
+
+// Forwards a method, then skips its attributes.
+class SkipStage
+		: public ClassVisitor {
+private:
+	std::string_view name;
+
+public:
+	SkipStage(ClassVisitor *next, std::string_view name)
+		: ClassVisitor(next), name(name) {
+	}
+
+	bool VisitMethod(const MemberView &method) {
+		return ClassVisitor::VisitMethod(method) && method.name != name;
+	}
+};
+
+// Drops a method without forwarding it.
+class DropStage
+		: public ClassVisitor {
+private:
+	std::string_view name;
+
+public:
+	DropStage(ClassVisitor *next, std::string_view name)
+		: ClassVisitor(next), name(name) {
+	}
+
+	bool VisitMethod(const MemberView &method) {
+		return method.name != name && ClassVisitor::VisitMethod(method);
+	}
+};
+
+// Renames a method, adding its new name to the pool.
+class RenameStage
+		: public ClassVisitor {
+private:
+	ClassWriter *writer;
+
+public:
+	RenameStage(ClassWriter *writer)
+		: ClassVisitor(writer), writer(writer) {
+	}
+
+	bool VisitMethod(const MemberView &method) {
+		MemberView renamed = method;
+
+		if(method.name == "first") {
+			renamed.name_index = writer->FindOrAddUtf8("renamed");
+		}
+
+		return ClassVisitor::VisitMethod(renamed);
+	}
+};
+
+static
+MethodCode NewCode(std::vector<uint8_t> bytes) {
+	MethodCode code;
+
+	code.max_stack = 1;
+	code.max_locals = 1;
+	code.code = bytes;
+	return code;
+}
+
+static
+std::vector<uint8_t> AssembleTestClass() {
+	ClassAssembler assembler;
+
+	MethodCode first = NewCode({
+		0x03,				// 0: iconst_0
+		0xAC				// 1: ireturn
+	});
+
+	MethodCode second = NewCode({
+		0x1A,				// 0: iload_0
+		0xAC				// 1: ireturn
+	});
+
+	// The last method has code, and the class attributes follow it.
+	assembler.AddMethod(0x0008, "first", "()I", &first);
+	assembler.AddMethod(0x0108, "native", "()V", NULL);
+	assembler.AddMethod(0x0008, "second", "(I)I", &second);
+
+	uint16_t source = assembler.Utf8("Test.java");
+	assembler.AddAttribute("SourceFile", { (uint8_t)(source >> 8), (uint8_t)source });
+	return assembler.Assemble(50, "Test");
+}
+
+static
+void Rewrite(const std::vector<uint8_t> &input, ClassVisitor *stage) {
+	ClassBuffer buffer(input.data(), input.size());
+	ClassReader reader;
+
+	reader.Accept(&buffer, stage);
+}
+
+static
+bool HasMethod(ClassFile *classFile, std::string_view name) {
+	for(size_t idx = 0; idx < classFile->methods.size(); idx++) {
+		if(classFile->methods[idx]->Name() == name) return true;
+	}
+
+	return false;
+}
+
+static
+bool HasSourceFile(ClassFile *classFile) {
+	return classFile->attributes.size() == 1
+		&& classFile->attributes[0]->name->View() == "SourceFile";
+}
+
+static
+void TestIdentity(const std::vector<uint8_t> &input) {
+	ClassBuilder output;
+	ClassWriter writer(&output);
+
+	Rewrite(input, &writer);
+	CHECK(output.Take() == input);
+}
+
+static
+void TestSkippedMember(const std::vector<uint8_t> &input) {
+	ClassBuilder output;
+	ClassWriter writer(&output);
+	SkipStage stage(&writer, "second");
+
+	Rewrite(input, &stage);
+	std::vector<uint8_t> result = output.Take();
+	ClassFile *classFile = DecodeClassFile(result.data(), result.size());
+
+	// The method is kept without its code.
+	CHECK(classFile->methods.size() == 3);
+	CHECK(classFile->FindMethod("second")->attributes.empty());
+	CHECK(classFile->FindMethod("first")->GetCode() != NULL);
+	CHECK(HasSourceFile(classFile));
+	delete classFile;
+}
+
+static
+void TestDroppedMember(const std::vector<uint8_t> &input) {
+	ClassBuilder output;
+	ClassWriter writer(&output);
+	DropStage stage(&writer, "first");
+
+	Rewrite(input, &stage);
+	std::vector<uint8_t> result = output.Take();
+	ClassFile *classFile = DecodeClassFile(result.data(), result.size());
+
+	CHECK(classFile->methods.size() == 2);
+	CHECK(!HasMethod(classFile, "first"));
+	CHECK(classFile->FindMethod("second")->GetCode() != NULL);
+	CHECK(HasSourceFile(classFile));
+	delete classFile;
+}
+
+static
+void TestAddedConstant(const std::vector<uint8_t> &input) {
+	ClassBuilder output;
+	ClassWriter writer(&output);
+	RenameStage stage(&writer);
+
+	Rewrite(input, &stage);
+	std::vector<uint8_t> result = output.Take();
+	ClassFile *classFile = DecodeClassFile(result.data(), result.size());
+
+	CHECK(!HasMethod(classFile, "first"));
+	CHECK(classFile->FindMethod("renamed")->GetCode() != NULL);
+	CHECK(HasSourceFile(classFile));
+	delete classFile;
+}
+
+int main() {
+	std::vector<uint8_t> input = AssembleTestClass();
+
+	try {
+		TestIdentity(input);
+		TestSkippedMember(input);
+		TestDroppedMember(input);
+		TestAddedConstant(input);
+	} catch(JBCError &err) {
+		fprintf(stderr, "Unexpected error : %s\n", err.msg.c_str());
+		failures++;
+	}
+
+	printf("ClassWriterTest : %s.\n", failures ? "FAILED" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,275 @@
+
+# include <stdio.h>
+# include <stdlib.h>
+
+# include <vector>
+
+# include "ClassFile.h"
+# include "MemberInfo.h"
+# include "ErrorTypes.h"
+# include "AttributeInfo.h"
+# include "StackMapFrame.h"
+# include "FrameAnalysis.h"
+# include "TestSupport.h"
+
+using namespace JBC;
+
+// Indices of constants shared by the tests.
+static uint16_t test_class;
+static uint16_t base_class;
+static uint16_t object_class;
+static uint16_t throwable_class;
+
+static
+MethodCode NewCode(uint16_t max_stack, uint16_t max_locals, std::vector<uint8_t> bytes) {
+	MethodCode code;
+
+	code.max_stack = max_stack;
+	code.max_locals = max_locals;
+	code.code = bytes;
+	return code;
+}
+
+static
+std::vector<uint8_t> AssembleTestClass() {
+	ClassAssembler assembler;
+
+	test_class = assembler.Class("Test");
+	base_class = assembler.Class("Base");
+	object_class = assembler.Class("java/lang/Object");
+	throwable_class = assembler.Class("java/lang/Throwable");
+
+	uint16_t first = assembler.Class("First");
+	uint16_t second = assembler.Class("Second");
+	uint16_t super = assembler.MethodRef("java/lang/Object", "<init>", "()V");
+
+	// Each frame type in turn.
+	MethodCode kinds = NewCode(1, 2, {
+		0x03,				// 0: iconst_0
+		0x3C,				// 1: istore_1
+		0x1A,				// 2: iload_0
+		0x9A, 0x00, 0x06,	// 3: ifne 9
+		0x04,				// 6: iconst_1
+		0x3C,				// 7: istore_1
+		0x00,				// 8: nop
+		0x1B,				// 9: iload_1, appends an int
+		0x99, 0x00, 0x04,	// 10: ifeq 14
+		0x00,				// 13: nop
+		0x1A,				// 14: iload_0, the same locals
+		0x99, 0x00, 0x08,	// 15: ifeq 23
+		0x01,				// 18: aconst_null
+		0x4C,				// 19: astore_1
+		0xA7, 0x00, 0x03,	// 20: goto 23
+		0x0B,				// 23: fconst_0, chops the merged local
+		0x3B,				// 24: fstore_0
+		0x04,				// 25: iconst_1
+		0xA7, 0x00, 0x03,	// 26: goto 29
+		0xAC				// 29: ireturn, with a float local and an int pushed
+	});
+
+	// Only the handler is reachable after the first return.
+	MethodCode dead = NewCode(1, 0, {
+		0x00,				// 0: nop
+		0xB1,				// 1: return
+		0x04,				// 2: iconst_1
+		0x57,				// 3: pop
+		0xB1,				// 4: return
+		0x57,				// 5: pop
+		0xB1				// 6: return
+	});
+	dead.handlers = { 0, 5, 5, 0 };
+
+	// The receiver is uninitialized until the super constructor runs.
+	MethodCode init = NewCode(2, 1, {
+		0x2A,				// 0: aload_0
+		0x03,				// 1: iconst_0
+		0x99, 0x00, 0x04,	// 2: ifeq 6
+		0x00,				// 5: nop
+		0xB7, (uint8_t)(super >> 8), (uint8_t)super,	// 6: invokespecial
+		0x03,				// 9: iconst_0
+		0x99, 0x00, 0x04,	// 10: ifeq 14
+		0x00,				// 13: nop
+		0xB1				// 14: return
+	});
+
+	// Two sibling classes merge to their common superclass.
+	MethodCode merge = NewCode(1, 1, {
+		0x1A,				// 0: iload_0
+		0x99, 0x00, 0x0A,	// 1: ifeq 11
+		0x01,				// 4: aconst_null
+		0xC0, (uint8_t)(first >> 8), (uint8_t)first,	// 5: checkcast First
+		0xA7, 0x00, 0x07,	// 8: goto 15
+		0x01,				// 11: aconst_null
+		0xC0, (uint8_t)(second >> 8), (uint8_t)second,	// 12: checkcast Second
+		0xB0				// 15: areturn
+	});
+
+	// Subroutines have no frames.
+	MethodCode subroutine = NewCode(1, 1, {
+		0xC9, 0x00, 0x00, 0x00, 0x08,	// 0: jsr_w 8
+		0x03,				// 5: iconst_0
+		0x57,				// 6: pop
+		0xB1,				// 7: return
+		0x4B,				// 8: astore_0
+		0xA9, 0x00			// 9: ret 0
+	});
+
+	assembler.AddMethod(0x0008, "kinds", "(I)I", &kinds);
+	assembler.AddMethod(0x0008, "dead", "()V", &dead);
+	assembler.AddMethod(0x0001, "<init>", "()V", &init);
+	assembler.AddMethod(0x0008, "merge", "(Z)LBase;", &merge);
+	assembler.AddMethod(0x0008, "subroutine", "()V", &subroutine);
+	return assembler.Assemble(50, "Test");
+}
+
+static
+std::vector<uint8_t> Frames(ClassFile *classFile, std::string_view name,
+		ClassHierarchy *hierarchy = NULL) {
+	MemberInfo *method = classFile->FindMethod(name);
+	CodeAttribute *code = method->GetCode();
+
+	ComputeStackMapFrames(method, classFile, hierarchy);
+
+	AttributeInfo *table = FindCodeAttribute(code, "StackMapTable");
+	return table == NULL ? std::vector<uint8_t>() : EncodeContents(table, classFile);
+}
+
+static
+void TestFrameTypes(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+
+	CHECK(Frames(classFile, "kinds") == std::vector<uint8_t>({
+		0x00, 0x04,
+		252, 0x00, 0x09, ITEM_INTEGER,
+		4,
+		250, 0x00, 0x08,
+		255, 0x00, 0x05, 0x00, 0x01, ITEM_FLOAT, 0x00, 0x01, ITEM_INTEGER
+	}));
+
+	delete classFile;
+}
+
+static
+void TestDeadCode(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("dead")->GetCode();
+
+	CHECK(Frames(classFile, "dead") == std::vector<uint8_t>({
+		0x00, 0x02,
+		64 + 2, ITEM_OBJECT, (uint8_t)(throwable_class >> 8), (uint8_t)throwable_class,
+		64 + 2, ITEM_OBJECT, (uint8_t)(throwable_class >> 8), (uint8_t)throwable_class
+	}));
+
+	CHECK(std::vector<uint8_t>(code->code, code->code + code->code_length)
+			== std::vector<uint8_t>({ 0x00, 0xB1, 0x00, 0x00, 0xBF, 0x57, 0xB1 }));
+
+	// The handler no longer covers the unreachable code.
+	CHECK(code->exception_table.size() == 1);
+	CHECK(code->exception_table[0]->start_pc == 0);
+	CHECK(code->exception_table[0]->end_pc == 2);
+	CHECK(code->exception_table[0]->handler_pc == 5);
+	delete classFile;
+}
+
+static
+void TestConstructor(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+
+	CHECK(Frames(classFile, "<init>") == std::vector<uint8_t>({
+		0x00, 0x02,
+		64 + 6, ITEM_UNINITIALIZED_THIS,
+		255, 0x00, 0x07,
+		0x00, 0x01, ITEM_OBJECT, (uint8_t)(test_class >> 8), (uint8_t)test_class,
+		0x00, 0x00
+	}));
+
+	delete classFile;
+}
+
+static
+void TestHierarchy(const std::vector<uint8_t> &input) {
+	ClassSetHierarchy hierarchy;
+
+	hierarchy.AddClass("Base", "java/lang/Object");
+	hierarchy.AddClass("First", "Base");
+	hierarchy.AddClass("Second", "Base");
+
+	CHECK(hierarchy.CommonSuperclass("First", "Second") == "Base");
+	CHECK(hierarchy.CommonSuperclass("First", "Base") == "Base");
+	CHECK(hierarchy.CommonSuperclass("First", "Unknown") == "java/lang/Object");
+
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+
+	CHECK(Frames(classFile, "merge", &hierarchy) == std::vector<uint8_t>({
+		0x00, 0x02,
+		11,
+		64 + 3, ITEM_OBJECT, (uint8_t)(base_class >> 8), (uint8_t)base_class
+	}));
+
+	// Without the hierarchy, only java/lang/Object is known.
+	CHECK(Frames(classFile, "merge") == std::vector<uint8_t>({
+		0x00, 0x02,
+		11,
+		64 + 3, ITEM_OBJECT, (uint8_t)(object_class >> 8), (uint8_t)object_class
+	}));
+
+	delete classFile;
+}
+
+static
+void TestModifiedOnly(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("kinds")->GetCode();
+
+	// Unmodified code is encoded as decoded.
+	classFile->compute = COMPUTE_LIMITS | COMPUTE_FRAMES;
+	CHECK(EncodeClassFile(classFile) == input);
+
+	code->max_stack = 7;
+	code->MarkDirty();
+
+	std::vector<uint8_t> output = EncodeClassFile(classFile);
+	CHECK(output != input);
+	CHECK(code->max_stack == 1);
+	CHECK(FindCodeAttribute(code, "StackMapTable") != NULL);
+	delete classFile;
+}
+
+static
+void TestSubroutines(std::vector<uint8_t> input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("subroutine")->GetCode();
+
+	// Left as is before version 51.
+	classFile->compute = COMPUTE_LIMITS | COMPUTE_FRAMES;
+	code->MarkDirty();
+
+	EncodeClassFile(classFile);
+	CHECK(FindCodeAttribute(code, "StackMapTable") == NULL);
+	delete classFile;
+
+	input[7] = 51;
+	classFile = DecodeClassFile(input.data(), input.size());
+
+	CHECK_THROWS(Frames(classFile, "subroutine"), EncodeError);
+	delete classFile;
+}
+
+int main() {
+	std::vector<uint8_t> input = AssembleTestClass();
+
+	try {
+		TestFrameTypes(input);
+		TestDeadCode(input);
+		TestConstructor(input);
+		TestHierarchy(input);
+		TestModifiedOnly(input);
+		TestSubroutines(input);
+	} catch(JBCError &err) {
+		fprintf(stderr, "Unexpected error : %s\n", err.msg.c_str());
+		failures++;
+	}
+
+	printf("FrameAnalysisTest : %s.\n", failures ? "FAILED" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,436 @@
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+
+# include <vector>
+
+# include "ClassFile.h"
+# include "MemberInfo.h"
+# include "AttributeInfo.h"
+# include "StackMapFrame.h"
+# include "InstructionList.h"
+# include "TestSupport.h"
+
+using namespace JBC;
+
+// Indices of constants shared by the tests.
+static uint16_t throwable_class;
+
+static
+MethodCode BranchingCode(ClassAssembler &assembler) {
+	MethodCode code;
+
+	code.max_stack = 1;
+	code.max_locals = 1;
+	code.code = {
+		0x1A,				// 0: iload_0
+		0x99, 0x00, 0x08,	// 1: ifeq 9
+		0x04,				// 4: iconst_1
+		0x3B,				// 5: istore_0
+		0xA7, 0x00, 0x05,	// 6: goto 11
+		0x05,				// 9: iconst_2
+		0x3B,				// 10: istore_0
+		0x1A,				// 11: iload_0
+		0xAC,				// 12: ireturn
+		0x57,				// 13: pop
+		0x03,				// 14: iconst_0
+		0xAC				// 15: ireturn
+	};
+
+	// Anything thrown from 4 to 9 is handled at 13.
+	code.handlers = { 4, 9, 13, 0 };
+
+	code.attributes.push_back({ "LineNumberTable", {
+		0x00, 0x04,
+		0x00, 0x00, 0x00, 0x0A,
+		0x00, 0x09, 0x00, 0x0B,
+		0x00, 0x0B, 0x00, 0x0C,
+		0x00, 0x0D, 0x00, 0x0D
+	}});
+
+	uint16_t name = assembler.Utf8("x");
+	uint16_t descriptor = assembler.Utf8("I");
+	code.attributes.push_back({ "LocalVariableTable", {
+		0x00, 0x01,
+		0x00, 0x00, 0x00, 0x10,
+		(uint8_t)(name >> 8), (uint8_t)name,
+		(uint8_t)(descriptor >> 8), (uint8_t)descriptor,
+		0x00, 0x00
+	}});
+
+	// Same frames at 9 and 11, and the exception on the stack at 13.
+	code.attributes.push_back({ "StackMapTable", {
+		0x00, 0x03,
+		9,
+		1,
+		64 + 1, ITEM_OBJECT, (uint8_t)(throwable_class >> 8), (uint8_t)throwable_class
+	}});
+
+	return code;
+}
+
+static
+MethodCode SwitchingCode() {
+	MethodCode code;
+
+	code.max_stack = 1;
+	code.max_locals = 1;
+	code.code = {
+		0x1A,									// 0: iload_0
+		0xAA, 0x00, 0x00,						// 1: tableswitch
+		0x00, 0x00, 0x00, 0x1B,					//    default 28
+		0x00, 0x00, 0x00, 0x00,					//    low 0
+		0x00, 0x00, 0x00, 0x01,					//    high 1
+		0x00, 0x00, 0x00, 0x17,					//    0: 24
+		0x00, 0x00, 0x00, 0x19,					//    1: 26
+		0x04, 0xAC,								// 24: iconst_1, ireturn
+		0x05, 0xAC,								// 26: iconst_2, ireturn
+		0x1A,									// 28: iload_0
+		0xAB, 0x00, 0x00,						// 29: lookupswitch
+		0x00, 0x00, 0x00, 0x1F,					//    default 60
+		0x00, 0x00, 0x00, 0x02,					//    2 pairs
+		0xFF, 0xFF, 0xFF, 0xFF,					//    -1: 56
+		0x00, 0x00, 0x00, 0x1B,
+		0x00, 0x00, 0x00, 0x07,					//    7: 58
+		0x00, 0x00, 0x00, 0x1D,
+		0x06, 0xAC,								// 56: iconst_3, ireturn
+		0x07, 0xAC,								// 58: iconst_4, ireturn
+		0x03, 0xAC								// 60: iconst_0, ireturn
+	};
+
+	return code;
+}
+
+static
+MethodCode MergingCode() {
+	MethodCode code;
+
+	code.max_stack = 1;
+	code.max_locals = 3;
+	code.code = {
+		0x03,				// 0: iconst_0
+		0x3D,				// 1: istore_2
+		0x1A,				// 2: iload_0
+		0x99, 0x00, 0x06,	// 3: ifeq 9
+		0x04,				// 6: iconst_1
+		0x3D,				// 7: istore_2
+		0x00,				// 8: nop
+		0x00,				// 9: nop
+		0x00,				// 10: nop
+		0x1C,				// 11: iload_2
+		0xAC				// 12: ireturn
+	};
+
+	// An int is appended at 9, and the same locals follow at 11.
+	code.attributes.push_back({ "StackMapTable", {
+		0x00, 0x02,
+		252, 0x00, 0x09, ITEM_INTEGER,
+		1
+	}});
+
+	return code;
+}
+
+static
+std::vector<uint8_t> AssembleTestClass() {
+	ClassAssembler assembler;
+
+	throwable_class = assembler.Class("java/lang/Throwable");
+
+	MethodCode branching = BranchingCode(assembler);
+	MethodCode switching = SwitchingCode();
+	MethodCode merging = MergingCode();
+
+	assembler.AddMethod(0x0008, "branch", "(I)I", &branching);
+	assembler.AddMethod(0x0008, "select", "(I)I", &switching);
+	assembler.AddMethod(0x0008, "merge", "(ILjava/lang/String;)I", &merging);
+	return assembler.Assemble(50, "Test");
+}
+
+static
+int32_t ReadInt(const uint8_t *src) {
+	return (int32_t)(((uint32_t)src[0] << 24) | (src[1] << 16) | (src[2] << 8) | src[3]);
+}
+
+static
+std::vector<uint8_t> Code(CodeAttribute *code) {
+	return std::vector<uint8_t>(code->code, code->code + code->code_length);
+}
+
+static
+CodeNode *FirstInstruction(InstructionList &list) {
+	CodeNode *node = list.First();
+
+	while(node->IsLabel()) node = node->next;
+	return node;
+}
+
+static
+void TestIdentity(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+
+	for(size_t idx = 0; idx < classFile->methods.size(); idx++) {
+		CodeAttribute *code = classFile->methods[idx]->GetCode();
+		std::vector<uint8_t> before = Code(code);
+
+		InstructionList list(code, classFile);
+		CHECK(list.Link() == before.size());
+		CHECK(Code(code) == before);
+	}
+
+	// Every table is rewritten to the same values.
+	CHECK(EncodeClassFile(classFile) == input);
+	delete classFile;
+}
+
+static
+void TestTableFixups(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("branch")->GetCode();
+	InstructionList list(code, classFile);
+
+	// Three bytes are inserted at the start of the protected range.
+	for(unsigned idx = 0; idx < 3; idx++) {
+		list.InsertAfter(list.LabelAt(4), list.NewInstruction(OP_NOP));
+	}
+
+	CHECK(list.Link() == 19);
+	CHECK(Code(code) == std::vector<uint8_t>({
+		0x1A, 0x99, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x04, 0x3B,
+		0xA7, 0x00, 0x05, 0x05, 0x3B, 0x1A, 0xAC, 0x57, 0x03, 0xAC
+	}));
+
+	CHECK(code->exception_table.size() == 1);
+	CHECK(code->exception_table[0]->start_pc == 4);
+	CHECK(code->exception_table[0]->end_pc == 12);
+	CHECK(code->exception_table[0]->handler_pc == 16);
+
+	CHECK(EncodeContents(FindCodeAttribute(code, "LineNumberTable"), classFile)
+			== std::vector<uint8_t>({
+		0x00, 0x04,
+		0x00, 0x00, 0x00, 0x0A,
+		0x00, 0x0C, 0x00, 0x0B,
+		0x00, 0x0E, 0x00, 0x0C,
+		0x00, 0x10, 0x00, 0x0D
+	}));
+
+	std::vector<uint8_t> locals = EncodeContents(
+			FindCodeAttribute(code, "LocalVariableTable"), classFile);
+	CHECK(locals.size() == 12 && locals[3] == 0 && locals[5] == 19);
+
+	CHECK(EncodeContents(FindCodeAttribute(code, "StackMapTable"), classFile)
+			== std::vector<uint8_t>({
+		0x00, 0x03,
+		12,
+		1,
+		64 + 1, ITEM_OBJECT, (uint8_t)(throwable_class >> 8), (uint8_t)throwable_class
+	}));
+
+	delete classFile;
+}
+
+static
+void TestSwitchPadding(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("select")->GetCode();
+	InstructionList list(code, classFile);
+
+	// Moving the tableswitch by one byte takes one byte of padding.
+	list.InsertBefore(FirstInstruction(list), list.NewInstruction(OP_NOP));
+
+	CHECK(list.Link() == 62);
+	CHECK(code->code[2] == OP_TABLESWITCH && code->code[3] == 0);
+	CHECK(ReadInt(code->code + 4) == 28 - 2);
+	CHECK(ReadInt(code->code + 8) == 0 && ReadInt(code->code + 12) == 1);
+	CHECK(ReadInt(code->code + 16) == 24 - 2);
+	CHECK(ReadInt(code->code + 20) == 26 - 2);
+
+	// The lookupswitch is unmoved.
+	CHECK(code->code[29] == OP_LOOKUPSWITCH);
+	CHECK(ReadInt(code->code + 32) == 60 - 29);
+	CHECK(ReadInt(code->code + 40) == -1 && ReadInt(code->code + 44) == 56 - 29);
+	CHECK(ReadInt(code->code + 48) == 7 && ReadInt(code->code + 52) == 58 - 29);
+
+	delete classFile;
+}
+
+static
+void TestWidening(const std::vector<uint8_t> &input) {
+	const uint32_t count = 40000;
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("branch")->GetCode();
+	InstructionList list(code, classFile);
+
+	// Both branches jump over the inserted code.
+	for(uint32_t idx = 0; idx < count; idx++) {
+		list.InsertBefore(list.LabelAt(9), list.NewInstruction(OP_NOP));
+	}
+
+	// The ifeq becomes ifne over a goto_w, and the goto a goto_w.
+	CHECK(list.Link() == 23 + count);
+	CHECK(code->code[1] == OP_IFNE);
+	CHECK(code->code[2] == 0x00 && code->code[3] == 0x08);
+	CHECK(code->code[4] == OP_GOTO_W && ReadInt(code->code + 5) == (int32_t)(16 + count - 4));
+	CHECK(code->code[9] == OP_ICONST_1 && code->code[10] == OP_ISTORE_0);
+	CHECK(code->code[11] == OP_GOTO_W && ReadInt(code->code + 12) == (int32_t)(18 + count - 11));
+	CHECK(code->code[16 + count] == OP_ICONST_2);
+
+	CHECK(code->exception_table[0]->start_pc == 9);
+	CHECK(code->exception_table[0]->end_pc == 16 + count);
+	CHECK(code->exception_table[0]->handler_pc == 20 + count);
+
+	// The first frame no longer fits a same_frame.
+	std::vector<uint8_t> frames = EncodeContents(
+			FindCodeAttribute(code, "StackMapTable"), classFile);
+	CHECK(frames.size() == 10);
+	CHECK(frames[2] == 251 && ((frames[3] << 8) | frames[4]) == 16 + count);
+	CHECK(frames[5] == 1 && frames[6] == 64 + 1);
+
+	// The fall through after the first goto_w needs a frame of its own.
+	classFile->compute = COMPUTE_FRAMES;
+
+	// The result decodes, with tables on instruction boundaries.
+	std::vector<uint8_t> output = EncodeClassFile(classFile);
+	ClassFile *result = DecodeClassFile(output.data(), output.size());
+	CodeAttribute *decoded = result->FindMethod("branch")->GetCode();
+	InstructionList check(decoded, result);
+	CHECK(decoded->code_length == 23 + count);
+
+	frames = EncodeContents(FindCodeAttribute(decoded, "StackMapTable"), result);
+	CHECK(frames[2] == 9);
+
+	delete result;
+	delete classFile;
+}
+
+static
+void TestUnlinked(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("branch")->GetCode();
+	std::vector<uint8_t> before = Code(code);
+	InstructionList list(code, classFile);
+
+	// The handler label is only referenced by tables.
+	list.InsertAfter(list.LabelAt(4), list.NewInstruction(OP_NOP));
+	list.Remove(list.LabelAt(13));
+
+	CHECK_THROWS(list.Link(), EncodeError);
+
+	// The attribute is left as it was.
+	CHECK(Code(code) == before);
+	CHECK(code->exception_table.size() == 1);
+	CHECK(code->exception_table[0]->start_pc == 4);
+	CHECK(code->exception_table[0]->end_pc == 9);
+	CHECK(code->exception_table[0]->handler_pc == 13);
+	CHECK(EncodeClassFile(classFile) == input);
+
+	delete classFile;
+}
+
+static
+void TestUnlinkedBranch(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("branch")->GetCode();
+	InstructionList list(code, classFile);
+	CodeNode *target = list.NewLabel();
+
+	// The new branch targets a label never added to the list.
+	list.InsertBefore(FirstInstruction(list), list.NewBranch(OP_GOTO, target));
+
+	CHECK_THROWS(list.Link(), EncodeError);
+	CHECK(EncodeClassFile(classFile) == input);
+
+	delete classFile;
+}
+
+static
+void TestMissingTargets(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("branch")->GetCode();
+	InstructionList list(code, classFile);
+
+	// Instructions with targets have their own constructors.
+	CHECK_THROWS(list.NewInstruction(OP_GOTO), JBCError);
+	CHECK_THROWS(list.NewInstruction(OP_JSR_W), JBCError);
+	CHECK_THROWS(list.NewInstruction(OP_IFEQ), JBCError);
+	CHECK_THROWS(list.NewInstruction(OP_TABLESWITCH), JBCError);
+	CHECK_THROWS(list.NewInstruction(OP_LOOKUPSWITCH), JBCError);
+
+	list.InsertBefore(FirstInstruction(list), list.NewBranch(OP_GOTO, NULL));
+
+	CHECK_THROWS(list.Link(), EncodeError);
+	CHECK(EncodeClassFile(classFile) == input);
+
+	delete classFile;
+}
+
+static
+void TestMergedFrames(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	CodeAttribute *code = classFile->FindMethod("branch")->GetCode();
+	InstructionList list(code, classFile);
+	CodeNode *first = list.LabelAt(9)->next;
+	CodeNode *second = list.LabelAt(10)->next;
+
+	// The frames at 9 and 11 meet, and the later one is kept.
+	list.Remove(first);
+	list.Remove(second);
+
+	CHECK(list.Link() == 14);
+	CHECK(EncodeContents(FindCodeAttribute(code, "StackMapTable"), classFile)
+			== std::vector<uint8_t>({
+		0x00, 0x02,
+		9,
+		64 + 1, ITEM_OBJECT, (uint8_t)(throwable_class >> 8), (uint8_t)throwable_class
+	}));
+
+	// The frame after an append is rewritten with every local.
+	code = classFile->FindMethod("merge")->GetCode();
+	InstructionList merged(code, classFile);
+	first = merged.LabelAt(9)->next;
+	second = merged.LabelAt(10)->next;
+
+	merged.Remove(first);
+	merged.Remove(second);
+
+	CHECK(merged.Link() == 11);
+	uint16_t string_class = classFile->FindOrAddClass("java/lang/String")->index;
+	CHECK(EncodeContents(FindCodeAttribute(code, "StackMapTable"), classFile)
+			== std::vector<uint8_t>({
+		0x00, 0x01,
+		255, 0x00, 0x09,
+		0x00, 0x03, ITEM_INTEGER, ITEM_OBJECT, (uint8_t)(string_class >> 8), (uint8_t)string_class,
+		ITEM_INTEGER,
+		0x00, 0x00
+	}));
+
+	// The result decodes.
+	std::vector<uint8_t> output = EncodeClassFile(classFile);
+	ClassFile *result = DecodeClassFile(output.data(), output.size());
+	CHECK(result->FindMethod("merge")->GetCode()->code_length == 11);
+
+	delete result;
+	delete classFile;
+}
+
+int main() {
+	std::vector<uint8_t> input = AssembleTestClass();
+
+	try {
+		TestIdentity(input);
+		TestTableFixups(input);
+		TestSwitchPadding(input);
+		TestWidening(input);
+		TestUnlinked(input);
+		TestUnlinkedBranch(input);
+		TestMissingTargets(input);
+		TestMergedFrames(input);
+	} catch(JBCError &err) {
+		fprintf(stderr, "Unexpected error : %s\n", err.msg.c_str());
+		failures++;
+	}
+
+	printf("InstructionListTest : %s.\n", failures ? "FAILED" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,318 @@
+
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <unistd.h>
+
+# include <string>
+# include <vector>
+
+# include "Inflate.h"
+# include "JarFile.h"
+# include "ClassFile.h"
+# include "ErrorTypes.h"
+# include "BatchDecoder.h"
+# include "TestSupport.h"
+
+using namespace JBC;
+
+static const char *STORED_JAR = "test/fixtures/stored.jar";
+static const char *DEFLATED_JAR = "test/fixtures/deflated.jar";
+static const char *ZIP64_JAR = "test/fixtures/zip64.jar";
+
+static
+std::vector<uint8_t> ReadFile(const char *path) {
+	std::vector<uint8_t> data;
+	FILE *file = fopen(path, "rb");
+	uint8_t chunk[4096];
+	size_t count;
+
+	if(file == NULL) {
+		throw BufferError("Cannot open fixture.");
+	}
+
+	while((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		data.insert(data.end(), chunk, chunk + count);
+	}
+
+	fclose(file);
+	return data;
+}
+
+// Writes an archive to a temporary file, removed on destruction.
+class TempArchive {
+private:
+	char		path[32];
+
+public:
+	TempArchive(const std::vector<uint8_t> &data) {
+		strcpy(path, "/tmp/JarFileTestXXXXXX");
+
+		int fd = mkstemp(path);
+		if(fd < 0 || write(fd, data.data(), data.size()) != (ssize_t)data.size()) {
+			throw BufferError("Cannot write temporary archive.");
+		}
+
+		close(fd);
+	}
+
+	~TempArchive() {
+		unlink(path);
+	}
+
+	const char *Path() const {
+		return path;
+	}
+};
+
+// Returns the offset of an entry's central directory header.
+static
+size_t FindCentral(const std::vector<uint8_t> &data, std::string_view name) {
+	for(size_t pos = 0; pos + 46 + name.size() <= data.size(); pos++) {
+		if(data[pos] == 0x50 && data[pos + 1] == 0x4B && data[pos + 2] == 0x01
+				&& data[pos + 3] == 0x02
+				&& std::string_view((const char *)&data[pos + 46], name.size()) == name) {
+			return pos;
+		}
+	}
+
+	throw BufferError("Entry not found in fixture.");
+}
+
+static
+std::string ReadEntry(const JarFile &jar, std::string_view name) {
+	std::vector<uint8_t> buffer;
+	const JarEntry *entry = jar.Find(name);
+	const uint8_t *contents = jar.Read(*entry, buffer);
+
+	return std::string((const char *)contents, entry->size);
+}
+
+static
+bool ReadFails(const std::vector<uint8_t> &data, std::string_view name) {
+	TempArchive archive(data);
+	JarFile jar(archive.Path());
+	std::vector<uint8_t> buffer;
+
+	try {
+		jar.Read(*jar.Find(name), buffer);
+	} catch(DecodeError &) {
+		return true;
+	}
+
+	return false;
+}
+
+static
+bool OpenFails(const std::vector<uint8_t> &data) {
+	TempArchive archive(data);
+
+	try {
+		JarFile jar(archive.Path());
+	} catch(DecodeError &) {
+		return true;
+	}
+
+	return false;
+}
+
+static
+bool IsPackaged(std::string_view name) {
+	return name.substr(0, 4) == "pkg/";
+}
+
+static
+void TestInflate() {
+	uint8_t output[16];
+
+	// A stored block.
+	const uint8_t stored[] = { 0x01, 0x05, 0x00, 0xFA, 0xFF, 'h', 'e', 'l', 'l', 'o' };
+	CHECK(Inflate(stored, sizeof(stored), output, sizeof(output)) == 5);
+	CHECK(memcmp(output, "hello", 5) == 0);
+
+	// A fixed Huffman block, with a back reference.
+	const uint8_t fixed[] = { 0x4B, 0x4C, 0x4A, 0x4E, 0x84, 0x21, 0x00 };
+	CHECK(Inflate(fixed, sizeof(fixed), output, sizeof(output)) == 12);
+	CHECK(memcmp(output, "abcabcabcabc", 12) == 0);
+
+	CHECK_THROWS(Inflate(fixed, sizeof(fixed), output, 4), DecodeError);
+	CHECK_THROWS(Inflate(fixed, 2, output, sizeof(output)), DecodeError);
+
+	// Block type 3 is reserved.
+	const uint8_t reserved[] = { 0x07 };
+	CHECK_THROWS(Inflate(reserved, sizeof(reserved), output, sizeof(output)), DecodeError);
+
+	// A stored block whose length check does not match.
+	const uint8_t mismatched[] = { 0x01, 0x05, 0x00, 0xFA, 0xFE, 'h', 'e', 'l', 'l', 'o' };
+	CHECK_THROWS(Inflate(mismatched, sizeof(mismatched), output, sizeof(output)), DecodeError);
+}
+
+static
+void TestCrc32() {
+	CHECK(Crc32((const uint8_t *)"123456789", 9) == 0xCBF43926);
+	CHECK(Crc32(NULL, 0) == 0);
+}
+
+static
+void TestDirectory(const char *path) {
+	JarFile jar(path);
+
+	CHECK(jar.EntryCount() == 5);
+	CHECK(jar.Entry(0).name == "META-INF/MANIFEST.MF");
+	CHECK(jar.Find("missing.class") == NULL);
+
+	const JarEntry *hello = jar.Find("Hello.class");
+	CHECK(hello != NULL && hello->size == 57);
+
+	// Only classes are selected, then filtered.
+	std::vector<const JarEntry *> classes = jar.Select();
+	CHECK(classes.size() == 2);
+	CHECK(classes[0]->name == "Hello.class" && classes[1]->name == "pkg/World.class");
+	CHECK(jar.Select(IsPackaged).size() == 1);
+
+	CHECK(ReadEntry(jar, "META-INF/MANIFEST.MF")
+			== "Manifest-Version: 1.0\r\nCreated-By: test\r\n\r\n");
+	CHECK(ReadEntry(jar, "pkg/").empty());
+
+	std::string readme = ReadEntry(jar, "readme.txt");
+	CHECK(readme.size() == 9600);
+	CHECK(readme.substr(0, 10) == "line 0 of ");
+}
+
+static
+void TestFormats() {
+	JarFile stored(STORED_JAR);
+	JarFile deflated(DEFLATED_JAR);
+	JarFile zip64(ZIP64_JAR);
+
+	CHECK(stored.Find("Hello.class")->method == JAR_STORED);
+	CHECK(deflated.Find("Hello.class")->method == JAR_DEFLATED);
+	CHECK(zip64.Find("Hello.class")->method == JAR_DEFLATED);
+
+	// Sizes and offsets come from the ZIP64 extra field.
+	CHECK(zip64.Find("Hello.class")->compressed_size != 0xFFFFFFFF);
+	CHECK(zip64.Find("Hello.class")->offset != 0xFFFFFFFF);
+
+	std::string hello = ReadEntry(stored, "Hello.class");
+	CHECK(ReadEntry(deflated, "Hello.class") == hello);
+	CHECK(ReadEntry(zip64, "Hello.class") == hello);
+	CHECK(ReadEntry(zip64, "readme.txt") == ReadEntry(deflated, "readme.txt"));
+
+	ClassFile *classFile = DecodeClassFile((const uint8_t *)hello.data(), hello.size());
+	CHECK(classFile->major_version == 50);
+	delete classFile;
+}
+
+static
+void TestDecodeJar() {
+	JarFile jar(DEFLATED_JAR);
+
+	ClassBatch *batch = DecodeJarFile(&jar, NULL, 2);
+	CHECK(batch->Size() == 2);
+	CHECK(batch->Failures() == 0);
+	CHECK(batch->Name(1) == "pkg/World.class");
+	CHECK(batch->Get(0) != NULL && batch->Get(1) != NULL);
+	delete batch;
+
+	batch = DecodeJarFile(&jar, IsPackaged, 2);
+	CHECK(batch->Size() == 1);
+	CHECK(batch->Name(0) == "pkg/World.class");
+	delete batch;
+}
+
+static
+void TestCorruptEntries() {
+	std::vector<uint8_t> stored = ReadFile(STORED_JAR);
+	std::vector<uint8_t> deflated = ReadFile(DEFLATED_JAR);
+	std::vector<uint8_t> data;
+	size_t central;
+
+	// A changed byte of contents fails the checksum.
+	central = FindCentral(stored, "Hello.class");
+	data = stored;
+	size_t local = data[central + 42] | (data[central + 43] << 8);
+	size_t start = local + 30 + data[local + 26] + data[local + 28];
+	data[start + 10] ^= 0xFF;
+	CHECK(ReadFails(data, "Hello.class"));
+	CHECK(!ReadFails(data, "pkg/World.class"));
+
+	// The failure is recorded in its place in a batch.
+	{
+		TempArchive archive(data);
+		JarFile jar(archive.Path());
+		ClassBatch *batch = DecodeJarFile(&jar, NULL, 2);
+
+		CHECK(batch->Failures() == 1);
+		CHECK(batch->Get(0) == NULL && !batch->Error(0).empty());
+		CHECK(batch->Get(1) != NULL);
+		delete batch;
+	}
+
+	// Encrypted entries.
+	data = stored;
+	data[central + 8] |= 0x01;
+	CHECK(ReadFails(data, "Hello.class"));
+
+	// Unsupported compression methods.
+	data = stored;
+	data[central + 10] = 12;
+	CHECK(ReadFails(data, "Hello.class"));
+
+	// A damaged deflate stream.
+	central = FindCentral(deflated, "Hello.class");
+	data = deflated;
+	local = data[central + 42] | (data[central + 43] << 8);
+	start = local + 30 + data[local + 26] + data[local + 28];
+	memset(&data[start], 0xFF, 8);
+	CHECK(ReadFails(data, "Hello.class"));
+
+	// A local header offset past the end.
+	data = deflated;
+	data[central + 44] = 0x7F;
+	CHECK(ReadFails(data, "Hello.class"));
+}
+
+static
+void TestCorruptArchives() {
+	std::vector<uint8_t> deflated = ReadFile(DEFLATED_JAR);
+	std::vector<uint8_t> data;
+
+	CHECK(OpenFails(std::vector<uint8_t>()));
+	CHECK(OpenFails(std::vector<uint8_t>(21, 0)));
+
+	// Truncated archives lose their end record.
+	CHECK(OpenFails(std::vector<uint8_t>(deflated.begin(), deflated.begin() + deflated.size() / 2)));
+
+	// A central directory past the end.
+	data = deflated;
+	data[data.size() - 5] = 0x7F;
+	CHECK(OpenFails(data));
+
+	// A ZIP64 locator in an archive too small for its end record.
+	data.assign(46, 0);
+	memcpy(&data[0], "PK\x06\x06", 4);
+	memcpy(&data[4], "PK\x06\x07", 4);
+	memcpy(&data[24], "PK\x05\x06", 4);
+	data[34] = data[35] = 0xFF;
+	CHECK(OpenFails(data));
+}
+
+int main() {
+	try {
+		TestInflate();
+		TestCrc32();
+		TestDirectory(STORED_JAR);
+		TestDirectory(DEFLATED_JAR);
+		TestDirectory(ZIP64_JAR);
+		TestFormats();
+		TestDecodeJar();
+		TestCorruptEntries();
+		TestCorruptArchives();
+	} catch(JBCError &err) {
+		fprintf(stderr, "Unexpected error : %s\n", err.msg.c_str());
+		failures++;
+	}
+
+	printf("JarFileTest : %s.\n", failures ? "FAILED" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
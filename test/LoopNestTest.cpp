@@ -0,0 +1,189 @@
+
+# include <stdio.h>
+# include <stdlib.h>
+
+# include <vector>
+
+# include "ClassFile.h"
+# include "MemberInfo.h"
+# include "ErrorTypes.h"
+# include "AttributeInfo.h"
+# include "LoopNest.h"
+# include "TestSupport.h"
+
+using namespace JBC;
+
+static
+MethodCode NewCode(std::vector<uint8_t> bytes) {
+	MethodCode code;
+
+	code.max_stack = 1;
+	code.max_locals = 2;
+	code.code = bytes;
+	return code;
+}
+
+static
+std::vector<uint8_t> AssembleTestClass() {
+	ClassAssembler assembler;
+
+	// An inner loop at 8 inside an outer loop at 2, then dead code.
+	MethodCode nested = NewCode({
+		0x03,				// 0: iconst_0
+		0x3C,				// 1: istore_1
+		0x1B,				// 2: iload_1
+		0x99, 0x00, 0x12,	// 3: ifeq 21
+		0x03,				// 6: iconst_0
+		0x3B,				// 7: istore_0
+		0x1A,				// 8: iload_0
+		0x99, 0x00, 0x09,	// 9: ifeq 18
+		0x84, 0x00, 0x01,	// 12: iinc 0 1
+		0xA7, 0xFF, 0xF9,	// 15: goto 8
+		0xA7, 0xFF, 0xF0,	// 18: goto 2
+		0xB1,				// 21: return
+		0xB1				// 22: return
+	});
+
+	// Two back edges to the header at 1 form one loop.
+	MethodCode shared = NewCode({
+		0x00,				// 0: nop
+		0x1A,				// 1: iload_0
+		0x99, 0x00, 0x0A,	// 2: ifeq 12
+		0x1A,				// 5: iload_0
+		0x9A, 0xFF, 0xFB,	// 6: ifne 1
+		0xA7, 0xFF, 0xF8,	// 9: goto 1
+		0xB1				// 12: return
+	});
+
+	// Straight line code has no loops.
+	MethodCode straight = NewCode({
+		0x1A,				// 0: iload_0
+		0x99, 0x00, 0x04,	// 1: ifeq 5
+		0x00,				// 4: nop
+		0xB1				// 5: return
+	});
+
+	assembler.AddMethod(0x0008, "nested", "(I)V", &nested);
+	assembler.AddMethod(0x0008, "shared", "(I)V", &shared);
+	assembler.AddMethod(0x0008, "straight", "(I)V", &straight);
+	return assembler.Assemble(50, "Test");
+}
+
+static
+void TestDominators(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	LoopNest nest(classFile->FindMethod("nested")->GetCode(), classFile);
+	const ControlFlowGraph &graph = nest.Graph();
+	const DominatorTree &tree = nest.Dominators();
+
+	CHECK(graph.BlockCount() == 8);
+	uint32_t entry = graph.BlockAt(0);
+	uint32_t outer = graph.BlockAt(2);
+	uint32_t inner = graph.BlockAt(8);
+	uint32_t body = graph.BlockAt(12);
+	uint32_t latch = graph.BlockAt(18);
+	uint32_t exit = graph.BlockAt(21);
+	uint32_t dead = graph.BlockAt(22);
+
+	CHECK(tree.ImmediateDominator(entry) == DominatorTree::NONE);
+	CHECK(tree.ImmediateDominator(outer) == entry);
+	CHECK(tree.ImmediateDominator(inner) == graph.BlockAt(6));
+	CHECK(tree.ImmediateDominator(body) == inner);
+	CHECK(tree.ImmediateDominator(latch) == inner);
+	CHECK(tree.ImmediateDominator(exit) == outer);
+
+	CHECK(tree.Dominates(outer, latch));
+	CHECK(tree.Dominates(inner, inner));
+	CHECK(!tree.Dominates(inner, exit));
+	CHECK(!tree.Dominates(body, latch));
+
+	// The dead block is outside the tree.
+	CHECK(!tree.IsReachable(dead));
+	CHECK(tree.ImmediateDominator(dead) == DominatorTree::NONE);
+	CHECK(tree.PostorderPosition(dead) == DominatorTree::NONE);
+	CHECK(!tree.Dominates(entry, dead));
+	CHECK(tree.ReversePostorder().size() == 7);
+	CHECK(tree.ReversePostorder()[0] == entry);
+
+	delete classFile;
+}
+
+static
+void TestNestedLoops(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	LoopNest nest(classFile->FindMethod("nested")->GetCode(), classFile);
+	const ControlFlowGraph &graph = nest.Graph();
+
+	// Inner loops come first.
+	CHECK(nest.LoopCount() == 2);
+	const Loop &inner = nest.GetLoop(0);
+	const Loop &outer = nest.GetLoop(1);
+
+	CHECK(inner.header == graph.BlockAt(8));
+	CHECK(inner.parent == 1 && inner.depth == 2 && inner.innermost);
+	CHECK(outer.header == graph.BlockAt(2));
+	CHECK(outer.parent == LoopNest::NONE && outer.depth == 1 && !outer.innermost);
+
+	CHECK(nest.IsBackEdge(graph.BlockAt(12), graph.BlockAt(8)));
+	CHECK(nest.IsBackEdge(graph.BlockAt(18), graph.BlockAt(2)));
+	CHECK(!nest.IsBackEdge(graph.BlockAt(2), graph.BlockAt(6)));
+
+	CHECK(nest.LoopOf(graph.BlockAt(12)) == 0);
+	CHECK(nest.LoopOf(graph.BlockAt(18)) == 1);
+	CHECK(nest.LoopOf(graph.BlockAt(21)) == LoopNest::NONE);
+	CHECK(nest.LoopOf(graph.BlockAt(22)) == LoopNest::NONE);
+
+	CHECK(nest.DepthAt(0) == 0);
+	CHECK(nest.DepthAt(3) == 1);
+	CHECK(nest.DepthAt(9) == 2);
+	CHECK(nest.DepthAt(15) == 2);
+	CHECK(nest.DepthAt(18) == 1);
+	CHECK(nest.DepthAt(21) == 0);
+	CHECK(nest.DepthAt(22) == 0);
+
+	delete classFile;
+}
+
+static
+void TestSharedHeader(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	LoopNest nest(classFile->FindMethod("shared")->GetCode(), classFile);
+	const ControlFlowGraph &graph = nest.Graph();
+
+	CHECK(nest.LoopCount() == 1);
+	const Loop &loop = nest.GetLoop(0);
+
+	CHECK(loop.header == graph.BlockAt(1));
+	CHECK(loop.parent == LoopNest::NONE && loop.depth == 1 && loop.innermost);
+	CHECK(nest.IsBackEdge(graph.BlockAt(5), graph.BlockAt(1)));
+	CHECK(nest.IsBackEdge(graph.BlockAt(9), graph.BlockAt(1)));
+
+	CHECK(nest.DepthAt(0) == 0);
+	CHECK(nest.DepthAt(6) == 1);
+	CHECK(nest.DepthAt(9) == 1);
+	CHECK(nest.DepthAt(12) == 0);
+
+	// Storage is reused for another method.
+	nest.Build(classFile->FindMethod("straight")->GetCode(), classFile);
+	CHECK(nest.LoopCount() == 0);
+	CHECK(nest.Graph().BlockCount() == 3);
+	CHECK(nest.DepthAt(4) == 0);
+
+	delete classFile;
+}
+
+int main() {
+	std::vector<uint8_t> input = AssembleTestClass();
+
+	try {
+		TestDominators(input);
+		TestNestedLoops(input);
+		TestSharedHeader(input);
+	} catch(JBCError &err) {
+		fprintf(stderr, "Unexpected error : %s\n", err.msg.c_str());
+		failures++;
+	}
+
+	printf("LoopNestTest : %s.\n", failures ? "FAILED" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+
+# include <stdio.h>
+# include <stdlib.h>
+
+# include <vector>
+
+# include "ClassFile.h"
+# include "MemberInfo.h"
+# include "ErrorTypes.h"
+# include "AttributeInfo.h"
+# include "StackAnalysis.h"
+# include "TestSupport.h"
+
+using namespace JBC;
+
+static
+MethodCode NewCode(std::vector<uint8_t> bytes) {
+	MethodCode code;
+
+	// Deliberately wrong, so updates are visible.
+	code.max_stack = 9;
+	code.max_locals = 9;
+	code.code = bytes;
+	return code;
+}
+
+static
+std::vector<uint8_t> AssembleTestClass() {
+	ClassAssembler assembler;
+	uint16_t take = assembler.MethodRef("Test", "take", "(ILjava/lang/String;)J");
+
+	// Wide arguments take two slots each.
+	MethodCode sum = NewCode({
+		0x1E,				// 0: lload_0
+		0x20,				// 1: lload_2
+		0x61,				// 2: ladd
+		0xAD				// 3: lreturn
+	});
+
+	// The receiver and arguments are popped, and the long result pushed.
+	MethodCode call = NewCode({
+		0x2A,				// 0: aload_0
+		0x1B,				// 1: iload_1
+		0x01,				// 2: aconst_null
+		0xB6, (uint8_t)(take >> 8), (uint8_t)take,	// 3: invokevirtual take
+		0x58,				// 6: pop2
+		0xB1				// 7: return
+	});
+
+	// The handler starts with only the exception on the stack.
+	MethodCode handler = NewCode({
+		0x04,				// 0: iconst_1
+		0x05,				// 1: iconst_2
+		0x01,				// 2: aconst_null
+		0xBF,				// 3: athrow
+		0x4C,				// 4: astore_1
+		0xB1				// 5: return
+	});
+	handler.handlers = { 0, 4, 4, 0 };
+
+	// Subroutines consume their return address, at either width.
+	MethodCode subroutine = NewCode({
+		0xA8, 0x00, 0x06,	// 0: jsr 6
+		0x03,				// 3: iconst_0
+		0x57,				// 4: pop
+		0xB1,				// 5: return
+		0x4B,				// 6: astore_0
+		0xA9, 0x00			// 7: ret 0
+	});
+
+	MethodCode wide_subroutine = NewCode({
+		0xC9, 0x00, 0x00, 0x00, 0x08,	// 0: jsr_w 8
+		0x03,				// 5: iconst_0
+		0x57,				// 6: pop
+		0xB1,				// 7: return
+		0x4B,				// 8: astore_0
+		0xA9, 0x00			// 9: ret 0
+	});
+
+	MethodCode underflow = NewCode({
+		0x57,				// 0: pop
+		0xB1				// 1: return
+	});
+
+	MethodCode inconsistent = NewCode({
+		0x1A,				// 0: iload_0
+		0x99, 0x00, 0x04,	// 1: ifeq 5
+		0x03,				// 4: iconst_0
+		0xB1				// 5: return
+	});
+
+	assembler.AddMethod(0x0008, "sum", "(JJ)J", &sum);
+	assembler.AddMethod(0x0000, "call", "(I)V", &call);
+	assembler.AddMethod(0x0008, "handler", "()V", &handler);
+	assembler.AddMethod(0x0008, "subroutine", "()V", &subroutine);
+	assembler.AddMethod(0x0008, "wide_subroutine", "()V", &wide_subroutine);
+	assembler.AddMethod(0x0008, "underflow", "()V", &underflow);
+	assembler.AddMethod(0x0008, "inconsistent", "(I)V", &inconsistent);
+	assembler.AddMethod(0x0408, "native", "()V", NULL);
+	return assembler.Assemble(50, "Test");
+}
+
+static
+bool HasLimits(ClassFile *classFile, std::string_view name,
+		uint16_t max_stack, uint16_t max_locals) {
+	MemberInfo *method = classFile->FindMethod(name);
+	CodeLimits limits = ComputeCodeLimits(method, method->GetCode(), classFile);
+
+	return limits.max_stack == max_stack && limits.max_locals == max_locals;
+}
+
+static
+void TestLimits(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+
+	CHECK(HasLimits(classFile, "sum", 4, 4));
+	CHECK(HasLimits(classFile, "call", 3, 2));
+	CHECK(HasLimits(classFile, "handler", 3, 2));
+	CHECK(HasLimits(classFile, "subroutine", 1, 1));
+	CHECK(HasLimits(classFile, "wide_subroutine", 1, 1));
+	delete classFile;
+}
+
+static
+void TestMalformed(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+
+	CHECK_THROWS(HasLimits(classFile, "underflow", 0, 0), DecodeError);
+	CHECK_THROWS(HasLimits(classFile, "inconsistent", 0, 0), DecodeError);
+	delete classFile;
+}
+
+static
+void TestUpdate(const std::vector<uint8_t> &input) {
+	ClassFile *classFile = DecodeClassFile(input.data(), input.size());
+	MemberInfo *method = classFile->FindMethod("sum");
+	CodeAttribute *code = method->GetCode();
+
+	CHECK(UpdateCodeLimits(method, classFile));
+	CHECK(code->max_stack == 4);
+	CHECK(code->max_locals == 4);
+
+	// Nothing changes the second time.
+	CHECK(!UpdateCodeLimits(method, classFile));
+	CHECK(!UpdateCodeLimits(classFile->FindMethod("native"), classFile));
+	delete classFile;
+}
+
+int main() {
+	std::vector<uint8_t> input = AssembleTestClass();
+
+	try {
+		TestLimits(input);
+		TestMalformed(input);
+		TestUpdate(input);
+	} catch(JBCError &err) {
+		fprintf(stderr, "Unexpected error : %s\n", err.msg.c_str());
+		failures++;
+	}
+
+	printf("StackAnalysisTest : %s.\n", failures ? "FAILED" : "passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
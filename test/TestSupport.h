@@ -0,0 +1,255 @@
+/**
+ * @file TestSupport.h
+ *
+ * @brief Defines checks, and a class file assembler, shared by the tests.
+ **/
+# ifndef __TESTSUPPORT_H__
+# define __TESTSUPPORT_H__
+
+# include <stdio.h>
+# include <stdint.h>
+
+# include <map>
+# include <string>
+# include <vector>
+# include <utility>
+# include <string_view>
+
+# include "ClassFile.h"
+# include "ClassBuilder.h"
+# include "ConstantInfo.h"
+# include "AttributeInfo.h"
+
+namespace JBC {
+
+// Number of failed checks; the test fails if any.
+static int failures = 0;
+
+static inline
+void Check(bool passed, const char *condition, const char *file, int line) {
+	if(!passed) {
+		fprintf(stderr, "%s:%d: Check failed : %s.\n", file, line, condition);
+		failures++;
+	}
+}
+
+/**
+ * @brief Checks a condition, reporting it if false.
+ **/
+# define CHECK(condition) \
+	Check((condition), #condition, __FILE__, __LINE__)
+
+/**
+ * @brief Checks that a statement raises an error of the given type.
+ **/
+# define CHECK_THROWS(statement, Error) \
+	do { \
+		bool thrown = false; \
+		try { statement; } catch(Error &) { thrown = true; } \
+		Check(thrown, #statement " throws " #Error, __FILE__, __LINE__); \
+	} while(0)
+
+/**
+ * @struct MethodCode
+ * @brief The contents of a Code attribute to assemble.
+ **/
+struct MethodCode {
+	uint16_t	max_stack;
+	uint16_t	max_locals;
+	std::vector<uint8_t> code;
+
+	// Start, end, handler and catch type of each exception handler.
+	std::vector<uint16_t> handlers;
+
+	// Nested attributes, by name.
+	std::vector<std::pair<std::string, std::vector<uint8_t> > > attributes;
+
+	MethodCode()
+		: max_stack(0), max_locals(0) {
+	}
+};
+
+/**
+ * @class ClassAssembler
+ * @brief Assembles small class files byte by byte.
+ *
+ * Constants are added on first use and shared after, so their indices
+ * can be used in hand written bytecode and expected tables.
+ **/
+class ClassAssembler {
+private:
+	ClassBuilder pool;
+	uint16_t	count;
+	std::map<std::string, uint16_t> constants;
+
+	ClassBuilder methods;
+	uint16_t	method_count;
+
+	ClassBuilder attributes;
+	uint16_t	attribute_count;
+
+public:
+	ClassAssembler()
+		: count(1), method_count(0), attribute_count(0) {
+	}
+
+	uint16_t Utf8(std::string_view value) {
+		ClassBuilder entry;
+
+		entry.NextByte(CONSTANT_UTF8)->NextShort(value.size());
+		entry.Next((const uint8_t *)value.data(), value.size());
+		return Add(entry);
+	}
+
+	uint16_t Integer(int32_t value) {
+		ClassBuilder entry;
+
+		entry.NextByte(CONSTANT_INTEGER)->NextInt((uint32_t)value);
+		return Add(entry);
+	}
+
+	uint16_t Class(std::string_view name) {
+		ClassBuilder entry;
+
+		entry.NextByte(CONSTANT_CLASS)->NextShort(Utf8(name));
+		return Add(entry);
+	}
+
+	uint16_t NameAndType(std::string_view name, std::string_view descriptor) {
+		ClassBuilder entry;
+
+		entry.NextByte(CONSTANT_NAME_AND_TYPE)->NextShort(Utf8(name));
+		entry.NextShort(Utf8(descriptor));
+		return Add(entry);
+	}
+
+	uint16_t FieldRef(std::string_view owner, std::string_view name,
+			std::string_view descriptor) {
+		return Reference(CONSTANT_FIELD_REF, owner, name, descriptor);
+	}
+
+	uint16_t MethodRef(std::string_view owner, std::string_view name,
+			std::string_view descriptor) {
+		return Reference(CONSTANT_METHOD_REF, owner, name, descriptor);
+	}
+
+	/**
+	 * @brief Adds a method, with code unless NULL.
+	 **/
+	void AddMethod(uint16_t flags, std::string_view name, std::string_view descriptor,
+			const MethodCode *code) {
+		methods.NextShort(flags)->NextShort(Utf8(name))->NextShort(Utf8(descriptor));
+		method_count++;
+
+		if(code == NULL) {
+			methods.NextShort(0);
+			return;
+		}
+
+		uint32_t length = 2 + 2 + 4 + code->code.size() + 2 + 2 * code->handlers.size() + 2;
+		for(size_t idx = 0; idx < code->attributes.size(); idx++) {
+			length += 6 + code->attributes[idx].second.size();
+		}
+
+		methods.NextShort(1)->NextShort(Utf8("Code"))->NextInt(length);
+		methods.NextShort(code->max_stack)->NextShort(code->max_locals);
+		methods.NextInt(code->code.size())->Next(code->code.data(), code->code.size());
+
+		methods.NextShort(code->handlers.size() / 4);
+		for(size_t idx = 0; idx < code->handlers.size(); idx++) {
+			methods.NextShort(code->handlers[idx]);
+		}
+
+		methods.NextShort(code->attributes.size());
+		for(size_t idx = 0; idx < code->attributes.size(); idx++) {
+			const std::vector<uint8_t> &contents = code->attributes[idx].second;
+
+			methods.NextShort(Utf8(code->attributes[idx].first))->NextInt(contents.size());
+			methods.Next(contents.data(), contents.size());
+		}
+	}
+
+	/**
+	 * @brief Adds an attribute to the class.
+	 **/
+	void AddAttribute(std::string_view name, const std::vector<uint8_t> &contents) {
+		attributes.NextShort(Utf8(name))->NextInt(contents.size());
+		attributes.Next(contents.data(), contents.size());
+		attribute_count++;
+	}
+
+	/**
+	 * @brief Assembles the class file.
+	 **/
+	std::vector<uint8_t> Assemble(uint16_t major_version, std::string_view name,
+			std::string_view super = "java/lang/Object") {
+		uint16_t this_class = Class(name);
+		uint16_t super_class = Class(super);
+		ClassBuilder output;
+
+		output.NextInt(JAVA_MAGIC)->NextShort(0)->NextShort(major_version);
+		output.NextShort(count)->Next(pool.Data(), pool.Size());
+		output.NextShort(CLASS_PUBLIC | CLASS_SUPER);
+		output.NextShort(this_class)->NextShort(super_class);
+
+		// No interfaces or fields.
+		output.NextShort(0)->NextShort(0);
+
+		output.NextShort(method_count)->Next(methods.Data(), methods.Size());
+		output.NextShort(attribute_count)->Next(attributes.Data(), attributes.Size());
+
+		return output.Take();
+	}
+
+private:
+	uint16_t Add(ClassBuilder &entry) {
+		std::string key((const char *)entry.Data(), entry.Size());
+		std::map<std::string, uint16_t>::iterator itr = constants.find(key);
+
+		if(itr != constants.end()) {
+			return itr->second;
+		}
+
+		pool.Next(entry.Data(), entry.Size());
+		constants[key] = count;
+		return count++;
+	}
+
+	uint16_t Reference(uint8_t tag, std::string_view owner, std::string_view name,
+			std::string_view descriptor) {
+		ClassBuilder entry;
+
+		entry.NextByte(tag)->NextShort(Class(owner));
+		entry.NextShort(NameAndType(name, descriptor));
+		return Add(entry);
+	}
+};
+
+/**
+ * @brief Returns a method's nested attribute by name, or NULL.
+ **/
+static inline
+AttributeInfo *FindCodeAttribute(CodeAttribute *code, std::string_view name) {
+	for(size_t idx = 0; idx < code->attributes.size(); idx++) {
+		if(code->attributes[idx]->name->View() == name) {
+			return code->attributes[idx];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Encodes the contents of an attribute, without its header.
+ **/
+static inline
+std::vector<uint8_t> EncodeContents(AttributeInfo *info, ClassFile *classFile) {
+	ClassBuilder builder;
+
+	info->EncodeAttribute(&builder, classFile);
+	return builder.Take();
+}
+
+} /* JBC */
+
+# endif /* TestSupport.h */